@@ -37,7 +37,8 @@ static Something appQuit(Thread *thread){
 }
 
 static Something appDelay(Thread *thread){
-    SDL_Delay((uint32_t)unwrapInteger(stackGetVariable(0, thread)));
+    uint32_t milliseconds = (uint32_t)unwrapInteger(stackGetVariable(0, thread));
+    allowingGC(SDL_Delay(milliseconds));
     return NOTHINGNESS;
 }
 
@@ -94,7 +95,7 @@ static Something rendererDrawLine(Thread *thread){
     int x2 = (int)unwrapInteger(stackGetVariable(2, thread));
     int y2 = (int)unwrapInteger(stackGetVariable(3, thread));
     SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
-    SDL_Delay(2000);
+    allowingGC(SDL_Delay(2000));
     return NOTHINGNESS;
 }
 
@@ -0,0 +1,396 @@
+//
+//  asyncIO.c
+//  Emojicode
+//
+
+#define _GNU_SOURCE
+#include "asyncIO.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__) && !defined(fileNoIOUring)
+#define FILE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+/*
+ * Operations are submitted to an io_uring if the kernel provides one, a thread reaps their completions. Otherwise,
+ * and whenever the ring is full, a pool of I/O threads performs them with pread and pwrite. Neither kind of thread is
+ * known to the GC as none of them ever touches the object heap.
+ */
+
+/** The number of I/O threads performing operations without io_uring. */
+#ifndef fileWorkerCount
+#define fileWorkerCount 4
+#endif
+
+/** The number of operations the io_uring can perform at once. */
+#define fileRingEntries 64
+
+struct FileOperation {
+    int fd;
+    bool write;
+    char *bytes;
+    size_t size;
+    off_t offset;
+    /** The number of bytes read or written so far. */
+    size_t transferred;
+    int error;
+    bool done;
+    /** Whether the owner released the operation before it completed. */
+    bool released;
+#ifdef FILE_IO_URING
+    /** The part of @c bytes that is still to be transferred by the ring. */
+    struct iovec iovec;
+#endif
+    /** The next operation in the queue of the I/O threads. */
+    FileOperation *next;
+};
+
+/** Guards all operations, the queue and the submission side of the ring. */
+static pthread_mutex_t operationsMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t operationCompleted = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t operationQueued = PTHREAD_COND_INITIALIZER;
+static pthread_once_t setUpOnce = PTHREAD_ONCE_INIT;
+
+static FileOperation *queueHead, *queueTail;
+static bool workersStarted;
+
+static void operationFree(FileOperation *operation){
+    free(operation->bytes);
+    free(operation);
+}
+
+/** Marks @c operation completed. Must be called with the mutex held. */
+static void operationComplete(FileOperation *operation, int error){
+    operation->error = error;
+    operation->done = true;
+    if (operation->released) {
+        operationFree(operation);
+    }
+    else {
+        pthread_cond_broadcast(&operationCompleted);
+    }
+}
+
+//MARK: I/O threads
+
+/** Performs @c operation until all bytes were transferred, the end of the file was reached or an error occurred. */
+static int operationPerform(FileOperation *operation){
+    while (operation->transferred < operation->size) {
+        char *bytes = operation->bytes + operation->transferred;
+        size_t size = operation->size - operation->transferred;
+        off_t offset = operation->offset + operation->transferred;
+        ssize_t n = operation->write ? pwrite(operation->fd, bytes, size, offset)
+                                     : pread(operation->fd, bytes, size, offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        if (n == 0) {
+            break;
+        }
+        operation->transferred += n;
+    }
+    return 0;
+}
+
+static void* workerRun(void *unused){
+    pthread_mutex_lock(&operationsMutex);
+    while (true) {
+        while (!queueHead) {
+            pthread_cond_wait(&operationQueued, &operationsMutex);
+        }
+        FileOperation *operation = queueHead;
+        queueHead = operation->next;
+        if (!queueHead) {
+            queueTail = NULL;
+        }
+        pthread_mutex_unlock(&operationsMutex);
+        int error = operationPerform(operation);
+        pthread_mutex_lock(&operationsMutex);
+        operationComplete(operation, error);
+    }
+    return NULL;
+}
+
+/** Hands @c operation to the I/O threads. Must be called with the mutex held. */
+static void workersSubmit(FileOperation *operation){
+    if (!workersStarted) {
+        workersStarted = true;
+        for (int i = 0; i < fileWorkerCount; i++) {
+            pthread_t thread;
+            pthread_create(&thread, NULL, workerRun, NULL);
+            pthread_detach(thread);
+        }
+    }
+    operation->next = NULL;
+    if (queueTail) {
+        queueTail->next = operation;
+    }
+    else {
+        queueHead = operation;
+    }
+    queueTail = operation;
+    pthread_cond_signal(&operationQueued);
+}
+
+//MARK: io_uring
+
+#ifdef FILE_IO_URING
+
+static struct {
+    /** The descriptor of the ring, -1 if operations must not be submitted to it. */
+    int fd;
+    /** The mappings of the ring. @c cqRing equals @c sqRing if the kernel maps both queues at once. */
+    void *sqRing, *cqRing;
+    size_t sqRingSize, cqRingSize, sqesSize;
+    unsigned *sqTail, *sqMask, *sqArray;
+    struct io_uring_sqe *sqes;
+    unsigned *cqHead, *cqTail, *cqMask;
+    struct io_uring_cqe *cqes;
+    /** The number of operations submitted whose completion was not reaped yet. */
+    unsigned inFlight;
+} ring = { .fd = -1 };
+
+/** Submits the rest of @c operation to the ring. Must be called with the mutex held and a free entry. */
+static bool ringSubmit(FileOperation *operation){
+    unsigned tail = *ring.sqTail;
+    unsigned index = tail & *ring.sqMask;
+    struct io_uring_sqe *sqe = ring.sqes + index;
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    operation->iovec.iov_base = operation->bytes + operation->transferred;
+    operation->iovec.iov_len = operation->size - operation->transferred;
+    sqe->opcode = operation->write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = operation->fd;
+    sqe->addr = (uintptr_t)&operation->iovec;
+    sqe->len = 1;
+    sqe->off = operation->offset + operation->transferred;
+    sqe->user_data = (uintptr_t)operation;
+    ring.sqArray[index] = index;
+    __atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    while (syscall(__NR_io_uring_enter, ring.fd, 1, 0, 0, NULL, 0) < 0) {
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            //The kernel did not consume the entry, take it back so that it is not submitted with the next one
+            __atomic_store_n(ring.sqTail, tail, __ATOMIC_RELEASE);
+            return false;
+        }
+    }
+    ring.inFlight++;
+    return true;
+}
+
+/** Handles a completion reaped from the ring. Must be called with the mutex held. */
+static void ringCompleted(FileOperation *operation, int result){
+    ring.inFlight--;
+    if (result < 0) {
+        operationComplete(operation, -result);
+        return;
+    }
+    operation->transferred += result;
+    //A short transfer is only final at the end of the file
+    if (result > 0 && operation->transferred < operation->size) {
+        if (ring.fd >= 0 && ringSubmit(operation)) {
+            return;
+        }
+        workersSubmit(operation);
+        return;
+    }
+    operationComplete(operation, 0);
+}
+
+/** Unmaps the ring and closes @c fd. */
+static void ringRelease(int fd){
+    if (ring.sqRing != MAP_FAILED) {
+        munmap(ring.sqRing, ring.sqRingSize);
+    }
+    if (ring.cqRing != MAP_FAILED && ring.cqRing != ring.sqRing) {
+        munmap(ring.cqRing, ring.cqRingSize);
+    }
+    if (ring.sqes != MAP_FAILED) {
+        munmap(ring.sqes, ring.sqesSize);
+    }
+    close(fd);
+}
+
+/**
+ * Reaps completions until the ring fails. From then on new operations and the rest of short transfers go to the I/O
+ * threads. The kernel may still be transferring the bytes of the operations in flight though, so the thread keeps
+ * polling the completion queue, which does not need the failed system call, and only releases the ring after the last
+ * of them completed.
+ */
+static void* ringReap(void *unused){
+    int fd = ring.fd;
+    bool failed = false;
+    while (true) {
+        if (failed) {
+            usleep(1000);
+        }
+        else {
+            failed = syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+                     errno != EINTR && errno != EAGAIN && errno != EBUSY;
+        }
+        pthread_mutex_lock(&operationsMutex);
+        if (failed) {
+            ring.fd = -1;
+        }
+        unsigned head = *ring.cqHead;
+        unsigned tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            struct io_uring_cqe *cqe = ring.cqes + (head & *ring.cqMask);
+            FileOperation *operation = (FileOperation *)(uintptr_t)cqe->user_data;
+            int result = cqe->res;
+            __atomic_store_n(ring.cqHead, head + 1, __ATOMIC_RELEASE);
+            ringCompleted(operation, result);
+        }
+        if (failed && ring.inFlight == 0) {
+            ringRelease(fd);
+            pthread_mutex_unlock(&operationsMutex);
+            return NULL;
+        }
+        pthread_mutex_unlock(&operationsMutex);
+    }
+}
+
+static void ringSetUp(void){
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, fileRingEntries, &params);
+    if (fd < 0) {
+        return;
+    }
+
+    size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single) {
+        sqSize = cqSize = sqSize > cqSize ? sqSize : cqSize;
+    }
+    ring.sqRingSize = sqSize;
+    ring.cqRingSize = cqSize;
+    ring.sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring.sqRing = mmap(NULL, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_SQ_RING);
+    ring.cqRing = single ? ring.sqRing : mmap(NULL, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_CQ_RING);
+    ring.sqes = mmap(NULL, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, IORING_OFF_SQES);
+    if (ring.sqRing == MAP_FAILED || ring.cqRing == MAP_FAILED || ring.sqes == MAP_FAILED) {
+        ringRelease(fd);
+        return;
+    }
+
+    char *sq = ring.sqRing, *cq = ring.cqRing;
+    ring.sqTail = (unsigned *)(sq + params.sq_off.tail);
+    ring.sqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring.sqArray = (unsigned *)(sq + params.sq_off.array);
+    ring.cqHead = (unsigned *)(cq + params.cq_off.head);
+    ring.cqTail = (unsigned *)(cq + params.cq_off.tail);
+    ring.cqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    //The reaping thread must see the descriptor
+    ring.fd = fd;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, ringReap, NULL) != 0) {
+        ring.fd = -1;
+        ringRelease(fd);
+        return;
+    }
+    pthread_detach(thread);
+}
+
+#endif
+
+//MARK: Operations
+
+static void setUp(void){
+#ifdef FILE_IO_URING
+    ringSetUp();
+#endif
+}
+
+static FileOperation* operationSubmit(FileOperation *operation){
+    pthread_once(&setUpOnce, setUp);
+    pthread_mutex_lock(&operationsMutex);
+#ifdef FILE_IO_URING
+    //The ring never holds more operations than its completion queue has room for
+    if (ring.fd >= 0 && ring.inFlight < fileRingEntries && ringSubmit(operation)) {
+        pthread_mutex_unlock(&operationsMutex);
+        return operation;
+    }
+#endif
+    workersSubmit(operation);
+    pthread_mutex_unlock(&operationsMutex);
+    return operation;
+}
+
+static FileOperation* operationNew(int fd, bool write, off_t offset, size_t size){
+    FileOperation *operation = calloc(1, sizeof(FileOperation));
+    operation->fd = fd;
+    operation->write = write;
+    operation->offset = offset;
+    operation->size = size;
+    operation->bytes = malloc(size > 0 ? size : 1);
+    return operation;
+}
+
+FileOperation* fileOperationRead(int fd, off_t offset, size_t size){
+    return operationSubmit(operationNew(fd, false, offset, size));
+}
+
+FileOperation* fileOperationWrite(int fd, off_t offset, const char *bytes, size_t size){
+    FileOperation *operation = operationNew(fd, true, offset, size);
+    memcpy(operation->bytes, bytes, size);
+    return operationSubmit(operation);
+}
+
+bool fileOperationDone(FileOperation *operation){
+    pthread_mutex_lock(&operationsMutex);
+    bool done = operation->done;
+    pthread_mutex_unlock(&operationsMutex);
+    return done;
+}
+
+void fileOperationWait(FileOperation *operation){
+    pthread_mutex_lock(&operationsMutex);
+    while (!operation->done) {
+        pthread_cond_wait(&operationCompleted, &operationsMutex);
+    }
+    pthread_mutex_unlock(&operationsMutex);
+}
+
+int fileOperationError(FileOperation *operation){
+    return operation->error;
+}
+
+size_t fileOperationTransferred(FileOperation *operation){
+    return operation->transferred;
+}
+
+char* fileOperationTakeBytes(FileOperation *operation){
+    if (operation->write) {
+        return NULL;
+    }
+    char *bytes = operation->bytes;
+    operation->bytes = NULL;
+    return bytes;
+}
+
+void fileOperationRelease(FileOperation *operation){
+    pthread_mutex_lock(&operationsMutex);
+    if (operation->done) {
+        operationFree(operation);
+    }
+    else {
+        operation->released = true;
+    }
+    pthread_mutex_unlock(&operationsMutex);
+}
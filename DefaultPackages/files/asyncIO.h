@@ -0,0 +1,46 @@
+//
+//  asyncIO.h
+//  Emojicode
+//
+
+#ifndef asyncIO_h
+#define asyncIO_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * A read or write performed in the background, either by io_uring or by a pool of I/O threads. Operations never
+ * touch the object heap, their buffers are allocated with malloc.
+ */
+typedef struct FileOperation FileOperation;
+
+/** Starts reading @c size bytes at @c offset of @c fd. */
+FileOperation* fileOperationRead(int fd, off_t offset, size_t size);
+
+/** Starts writing a copy of the @c size @c bytes at @c offset of @c fd. */
+FileOperation* fileOperationWrite(int fd, off_t offset, const char *bytes, size_t size);
+
+/** Returns whether @c operation completed. */
+bool fileOperationDone(FileOperation *operation);
+
+/** Blocks until @c operation completed. Allow the GC to run while calling this. */
+void fileOperationWait(FileOperation *operation);
+
+/** Returns the errno of a failed operation or 0. The operation must have completed. */
+int fileOperationError(FileOperation *operation);
+
+/** Returns the number of bytes read or written. The operation must have completed. */
+size_t fileOperationTransferred(FileOperation *operation);
+
+/**
+ * Hands the buffer of a completed read, which holds @c fileOperationTransferred bytes, over to the caller, who must
+ * free it. Returns NULL if it was already taken or @c operation is a write.
+ */
+char* fileOperationTakeBytes(FileOperation *operation);
+
+/** Releases @c operation, which frees itself once it completed if it has not completed yet. */
+void fileOperationRelease(FileOperation *operation);
+
+#endif /* asyncIO_h */
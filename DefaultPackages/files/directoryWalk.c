@@ -0,0 +1,477 @@
+//
+//  directoryWalk.c
+//  Emojicode
+//
+
+#define _GNU_SOURCE
+#include "directoryWalk.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#define WALK_GETDENTS
+#include <sys/syscall.h>
+#endif
+
+/*
+ * Directories are opened relative to the walked directory with openat and read with getdents64 where available, the
+ * entries of one read form a batch and are stat'ed with fstatat relative to their directory. Without threads the walk
+ * reads the next batch whenever the previous one was returned. With threads every thread takes a directory from the
+ * queue of directories still to be read and queues its batches, the walk returns them in the order they were queued.
+ */
+
+/** The number of bytes of directory entries read at once with getdents64. */
+#define walkReadSize 32768
+
+/** The number of entries read at once with readdir. */
+#define walkBatchEntries 256
+
+/** The number of batches the threads read ahead before they wait for the walk to return them. */
+#define walkQueuedBatches 64
+
+/** A directory still to be read. */
+typedef struct PendingDirectory {
+    /** The path relative to the walked directory, which is empty for the walked directory itself. */
+    char *path;
+    struct PendingDirectory *next;
+} PendingDirectory;
+
+typedef struct DirectoryBatch {
+    DirectoryEntry *entries;
+    size_t count, capacity;
+    /** The NUL-terminated paths of the entries one after the other. */
+    char *paths;
+    size_t pathsLength, pathsCapacity;
+    struct DirectoryBatch *next;
+} DirectoryBatch;
+
+/** A directory being read. */
+typedef struct {
+    /** The descriptor of the directory or -1 if no directory is being read. */
+    int fd;
+    char *path;
+#ifdef WALK_GETDENTS
+    char *buffer;
+#else
+    DIR *dir;
+#endif
+} DirectoryReading;
+
+struct DirectoryWalk {
+    /** The descriptor of the walked directory, all other directories are opened relative to it. */
+    int fd;
+    bool recursive;
+    /** The number of threads reading directories or 0 if the walk reads them itself. */
+    size_t threads;
+    /** Guards everything below. */
+    pthread_mutex_t mutex;
+    /** Signaled when a directory or room for a batch became available or the walk ended or was closed. */
+    pthread_cond_t workAvailable;
+    /** Signaled when a batch was queued or the walk ended. */
+    pthread_cond_t batchQueued;
+    PendingDirectory *pendingHead, *pendingTail;
+    DirectoryBatch *batchesHead, *batchesTail;
+    size_t batchCount;
+    /** The number of directories the threads are reading at the moment. */
+    size_t active;
+    /** The number of threads that have not stopped yet. */
+    size_t running;
+    bool closed;
+    /** The directory being read without threads. */
+    DirectoryReading reading;
+    /** The batch entries are returned from and the index of the next entry to return. */
+    DirectoryBatch *batch;
+    size_t index;
+};
+
+//MARK: Batches
+
+static void batchFree(DirectoryBatch *batch){
+    if (batch) {
+        free(batch->entries);
+        free(batch->paths);
+        free(batch);
+    }
+}
+
+static void batchAdd(DirectoryBatch *batch, const char *directory, const char *name, struct stat *status){
+    size_t directoryLength = strlen(directory);
+    size_t nameLength = strlen(name);
+    size_t pathLength = directoryLength > 0 ? directoryLength + 1 + nameLength : nameLength;
+
+    if (batch->count == batch->capacity) {
+        batch->capacity = batch->capacity > 0 ? batch->capacity * 2 : 64;
+        batch->entries = realloc(batch->entries, batch->capacity * sizeof(DirectoryEntry));
+    }
+    if (batch->pathsLength + pathLength + 1 > batch->pathsCapacity) {
+        batch->pathsCapacity = (batch->pathsLength + pathLength + 1) * 2;
+        batch->paths = realloc(batch->paths, batch->pathsCapacity);
+    }
+
+    char *path = batch->paths + batch->pathsLength;
+    if (directoryLength > 0) {
+        memcpy(path, directory, directoryLength);
+        path[directoryLength] = '/';
+    }
+    memcpy(path + pathLength - nameLength, name, nameLength + 1);
+
+    //The paths might still move, the entries store offsets until the batch is finished
+    DirectoryEntry *entry = batch->entries + batch->count++;
+    entry->path = (const char *)(uintptr_t)batch->pathsLength;
+    entry->pathLength = pathLength;
+    entry->name = (const char *)(uintptr_t)(pathLength - nameLength);
+    entry->status = *status;
+    batch->pathsLength += pathLength + 1;
+}
+
+/** Turns the offsets stored by @c batchAdd into pointers. */
+static void batchFinish(DirectoryBatch *batch){
+    for (size_t i = 0; i < batch->count; i++) {
+        DirectoryEntry *entry = batch->entries + i;
+        entry->path = batch->paths + (uintptr_t)entry->path;
+        entry->name = entry->path + (uintptr_t)entry->name;
+    }
+}
+
+//MARK: Reading directories
+
+/** Queues the directories in the list @c head to be read. */
+static void walkQueueDirectories(DirectoryWalk *walk, PendingDirectory *head, PendingDirectory *tail){
+    pthread_mutex_lock(&walk->mutex);
+    if (walk->pendingTail) {
+        walk->pendingTail->next = head;
+    }
+    else {
+        walk->pendingHead = head;
+    }
+    walk->pendingTail = tail;
+    pthread_cond_broadcast(&walk->workAvailable);
+    pthread_mutex_unlock(&walk->mutex);
+}
+
+/** Removes the next directory to read from the queue. Must be called with the mutex held. */
+static PendingDirectory* walkTakeDirectory(DirectoryWalk *walk){
+    PendingDirectory *pending = walk->pendingHead;
+    if (pending) {
+        walk->pendingHead = pending->next;
+        if (!walk->pendingHead) {
+            walk->pendingTail = NULL;
+        }
+    }
+    return pending;
+}
+
+static void readingClose(DirectoryReading *reading){
+    if (reading->fd < 0) {
+        return;
+    }
+#ifdef WALK_GETDENTS
+    close(reading->fd);
+#else
+    closedir(reading->dir);
+#endif
+    free(reading->path);
+    reading->fd = -1;
+}
+
+/** Starts reading the directory @c pending, which is released. Returns false if it cannot be opened. */
+static bool readingOpen(DirectoryWalk *walk, DirectoryReading *reading, PendingDirectory *pending){
+    char *path = pending->path;
+    free(pending);
+    int fd = openat(walk->fd, path[0] ? path : ".", O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        free(path);
+        return false;
+    }
+#ifdef WALK_GETDENTS
+    if (!reading->buffer) {
+        reading->buffer = malloc(walkReadSize);
+    }
+#else
+    reading->dir = fdopendir(fd);
+    if (!reading->dir) {
+        close(fd);
+        free(path);
+        return false;
+    }
+#endif
+    reading->fd = fd;
+    reading->path = path;
+    return true;
+}
+
+/** Adds the entry @c name of the directory being read to @c batch and remembers it if it must be walked too. */
+static void readingAdd(DirectoryWalk *walk, DirectoryReading *reading, DirectoryBatch *batch, const char *name,
+                       PendingDirectory **foundHead, PendingDirectory **foundTail){
+    if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0))) {
+        return;
+    }
+    struct stat status;
+    if (fstatat(reading->fd, name, &status, AT_SYMLINK_NOFOLLOW) != 0) {
+        //The entry was removed in the meantime
+        return;
+    }
+    batchAdd(batch, reading->path, name, &status);
+
+    if (walk->recursive && S_ISDIR(status.st_mode)) {
+        DirectoryEntry *entry = batch->entries + batch->count - 1;
+        PendingDirectory *found = malloc(sizeof(PendingDirectory));
+        found->path = malloc(entry->pathLength + 1);
+        memcpy(found->path, batch->paths + (uintptr_t)entry->path, entry->pathLength + 1);
+        found->next = NULL;
+        if (*foundTail) {
+            (*foundTail)->next = found;
+        }
+        else {
+            *foundHead = found;
+        }
+        *foundTail = found;
+    }
+}
+
+/**
+ * Reads the next entries of the directory being read into a batch, which might be empty. Returns NULL and closes the
+ * directory once all its entries were read.
+ */
+static DirectoryBatch* readingNext(DirectoryWalk *walk, DirectoryReading *reading){
+    DirectoryBatch *batch = calloc(1, sizeof(DirectoryBatch));
+    PendingDirectory *foundHead = NULL, *foundTail = NULL;
+#ifdef WALK_GETDENTS
+    struct entry {
+        uint64_t inode;
+        int64_t offset;
+        unsigned short length;
+        unsigned char type;
+        char name[];
+    };
+    long n;
+    do {
+        n = syscall(SYS_getdents64, reading->fd, reading->buffer, walkReadSize);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        readingClose(reading);
+        free(batch);
+        return NULL;
+    }
+    for (long offset = 0; offset < n;) {
+        struct entry *entry = (struct entry *)(reading->buffer + offset);
+        readingAdd(walk, reading, batch, entry->name, &foundHead, &foundTail);
+        offset += entry->length;
+    }
+#else
+    struct dirent *entry = NULL;
+    size_t read = 0;
+    while (read < walkBatchEntries && (entry = readdir(reading->dir))) {
+        readingAdd(walk, reading, batch, entry->d_name, &foundHead, &foundTail);
+        read++;
+    }
+    if (read == 0) {
+        readingClose(reading);
+        free(batch);
+        return NULL;
+    }
+#endif
+    batchFinish(batch);
+    if (foundHead) {
+        walkQueueDirectories(walk, foundHead, foundTail);
+    }
+    return batch;
+}
+
+//MARK: Threads
+
+static void walkFree(DirectoryWalk *walk){
+    close(walk->fd);
+    while (walk->pendingHead) {
+        PendingDirectory *pending = walkTakeDirectory(walk);
+        free(pending->path);
+        free(pending);
+    }
+    while (walk->batchesHead) {
+        DirectoryBatch *batch = walk->batchesHead;
+        walk->batchesHead = batch->next;
+        batchFree(batch);
+    }
+    batchFree(walk->batch);
+    readingClose(&walk->reading);
+#ifdef WALK_GETDENTS
+    free(walk->reading.buffer);
+#endif
+    pthread_mutex_destroy(&walk->mutex);
+    pthread_cond_destroy(&walk->workAvailable);
+    pthread_cond_destroy(&walk->batchQueued);
+    free(walk);
+}
+
+/** Queues @c batch for the walk to return. Returns false if the walk was closed. */
+static bool walkQueueBatch(DirectoryWalk *walk, DirectoryBatch *batch){
+    pthread_mutex_lock(&walk->mutex);
+    while (!walk->closed && walk->batchCount >= walkQueuedBatches) {
+        pthread_cond_wait(&walk->workAvailable, &walk->mutex);
+    }
+    if (walk->closed) {
+        pthread_mutex_unlock(&walk->mutex);
+        batchFree(batch);
+        return false;
+    }
+    batch->next = NULL;
+    if (walk->batchesTail) {
+        walk->batchesTail->next = batch;
+    }
+    else {
+        walk->batchesHead = batch;
+    }
+    walk->batchesTail = batch;
+    walk->batchCount++;
+    pthread_cond_signal(&walk->batchQueued);
+    pthread_mutex_unlock(&walk->mutex);
+    return true;
+}
+
+static void* walkRun(void *argument){
+    DirectoryWalk *walk = argument;
+    DirectoryReading reading = { .fd = -1 };
+
+    pthread_mutex_lock(&walk->mutex);
+    while (true) {
+        //Another thread might still find directories
+        while (!walk->closed && !walk->pendingHead && walk->active > 0) {
+            pthread_cond_wait(&walk->workAvailable, &walk->mutex);
+        }
+        PendingDirectory *pending = walk->closed ? NULL : walkTakeDirectory(walk);
+        if (!pending) {
+            break;
+        }
+        walk->active++;
+        pthread_mutex_unlock(&walk->mutex);
+
+        if (readingOpen(walk, &reading, pending)) {
+            DirectoryBatch *batch;
+            while ((batch = readingNext(walk, &reading))) {
+                if (!walkQueueBatch(walk, batch)) {
+                    readingClose(&reading);
+                    break;
+                }
+            }
+        }
+
+        pthread_mutex_lock(&walk->mutex);
+        walk->active--;
+        if (!walk->pendingHead && walk->active == 0) {
+            pthread_cond_broadcast(&walk->workAvailable);
+            pthread_cond_broadcast(&walk->batchQueued);
+        }
+    }
+    bool last = --walk->running == 0 && walk->closed;
+    pthread_mutex_unlock(&walk->mutex);
+
+#ifdef WALK_GETDENTS
+    free(reading.buffer);
+#endif
+    if (last) {
+        walkFree(walk);
+    }
+    return NULL;
+}
+
+/** Returns the next batch queued by the threads or NULL once all directories were read. */
+static DirectoryBatch* walkTakeBatch(DirectoryWalk *walk){
+    pthread_mutex_lock(&walk->mutex);
+    while (!walk->batchesHead && (walk->pendingHead || walk->active > 0)) {
+        pthread_cond_wait(&walk->batchQueued, &walk->mutex);
+    }
+    DirectoryBatch *batch = walk->batchesHead;
+    if (batch) {
+        walk->batchesHead = batch->next;
+        if (!walk->batchesHead) {
+            walk->batchesTail = NULL;
+        }
+        walk->batchCount--;
+        pthread_cond_broadcast(&walk->workAvailable);
+    }
+    pthread_mutex_unlock(&walk->mutex);
+    return batch;
+}
+
+/** Reads the next batch on the calling thread or returns NULL once all directories were read. */
+static DirectoryBatch* walkReadBatch(DirectoryWalk *walk){
+    while (true) {
+        if (walk->reading.fd >= 0) {
+            DirectoryBatch *batch = readingNext(walk, &walk->reading);
+            if (batch) {
+                return batch;
+            }
+        }
+        pthread_mutex_lock(&walk->mutex);
+        PendingDirectory *pending = walkTakeDirectory(walk);
+        pthread_mutex_unlock(&walk->mutex);
+        if (!pending) {
+            return NULL;
+        }
+        readingOpen(walk, &walk->reading, pending);
+    }
+}
+
+//MARK: Walks
+
+DirectoryWalk* directoryWalkOpen(const char *path, bool recursive, size_t threads){
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    DirectoryWalk *walk = calloc(1, sizeof(DirectoryWalk));
+    walk->fd = fd;
+    walk->recursive = recursive;
+    walk->reading.fd = -1;
+    pthread_mutex_init(&walk->mutex, NULL);
+    pthread_cond_init(&walk->workAvailable, NULL);
+    pthread_cond_init(&walk->batchQueued, NULL);
+
+    PendingDirectory *root = malloc(sizeof(PendingDirectory));
+    root->path = strdup("");
+    root->next = NULL;
+    walk->pendingHead = walk->pendingTail = root;
+
+    pthread_mutex_lock(&walk->mutex);
+    for (size_t i = 0; i < threads; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, walkRun, walk) != 0) {
+            break;
+        }
+        pthread_detach(thread);
+        walk->running++;
+    }
+    //If no thread could be started, the walk reads the directories itself
+    walk->threads = walk->running;
+    pthread_mutex_unlock(&walk->mutex);
+    return walk;
+}
+
+const DirectoryEntry* directoryWalkNext(DirectoryWalk *walk){
+    while (!walk->batch || walk->index == walk->batch->count) {
+        batchFree(walk->batch);
+        walk->batch = walk->threads > 0 ? walkTakeBatch(walk) : walkReadBatch(walk);
+        walk->index = 0;
+        if (!walk->batch) {
+            return NULL;
+        }
+    }
+    return walk->batch->entries + walk->index++;
+}
+
+void directoryWalkClose(DirectoryWalk *walk){
+    pthread_mutex_lock(&walk->mutex);
+    walk->closed = true;
+    pthread_cond_broadcast(&walk->workAvailable);
+    bool last = walk->running == 0;
+    pthread_mutex_unlock(&walk->mutex);
+    if (last) {
+        walkFree(walk);
+    }
+}
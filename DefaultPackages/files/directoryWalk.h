@@ -0,0 +1,45 @@
+//
+//  directoryWalk.h
+//  Emojicode
+//
+
+#ifndef directoryWalk_h
+#define directoryWalk_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/stat.h>
+
+/**
+ * A walk over the entries of a directory and, if recursive, of all directories below it. Entries are read and
+ * stat'ed in batches, either on the calling thread or by a pool of threads. A walk never touches the object heap.
+ */
+typedef struct DirectoryWalk DirectoryWalk;
+
+typedef struct {
+    /** The NUL-terminated path relative to the walked directory. */
+    const char *path;
+    size_t pathLength;
+    /** The last component of @c path. */
+    const char *name;
+    /** The status of the entry itself, symbolic links are not followed. */
+    struct stat status;
+} DirectoryEntry;
+
+/**
+ * Starts walking the directory at @c path. Directories below it are walked too if @c recursive is true, but symbolic
+ * links to directories are not followed. If @c threads is greater than 0, that many threads read the directories in
+ * parallel. Returns NULL and sets errno if the directory cannot be opened.
+ */
+DirectoryWalk* directoryWalkOpen(const char *path, bool recursive, size_t threads);
+
+/**
+ * Returns the next entry or NULL if all entries were returned. The entry is valid until the next call. Might block
+ * while the next batch is read, allow the GC to run while calling this.
+ */
+const DirectoryEntry* directoryWalkNext(DirectoryWalk *walk);
+
+/** Stops @c walk and releases it once its threads have stopped. */
+void directoryWalkClose(DirectoryWalk *walk);
+
+#endif /* directoryWalk_h */
@@ -6,10 +6,14 @@
 //  Copyright (c) 2015 Theo Weidmann. All rights reserved.
 //
 
-#define _XOPEN_SOURCE 500
+#define _XOPEN_SOURCE 600
 #include "EmojicodeAPI.h"
 #include "EmojicodeString.h"
+#include "asyncIO.h"
+#include "directoryWalk.h"
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
@@ -25,64 +29,93 @@ if((failureCondition))\
     return somethingObject(newError(strerror(errno), errno));\
 
 
+/** Writes to files are buffered. Reading a file must nevertheless see what was written to it through another 📄. */
+static void flushPendingWrites(){
+    fflush(NULL);
+}
+
 //MARK: files
 Something filesMkdir(Thread *thread){
-    int state = mkdir(stringToChar(stackGetVariable(0, thread).object->value), 0755);
+    char buffer[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    int state;
+    allowingGC(state = mkdir(s, 0755));
+    stringFreeCharInBuffer(s, buffer);
     
     handleNEP(state != 0);
     return NOTHINGNESS;
 }
 
 Something filesSymlink(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    int state = symlink(s, stringToChar(stackGetVariable(1, thread).object->value));
-    free(s);
+    char buffer[PATH_MAX], buffer2[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    char *s2 = stringToCharInBuffer(stackGetVariable(1, thread).object->value, buffer2, sizeof(buffer2));
+    int state;
+    allowingGC(state = symlink(s, s2));
+    stringFreeCharInBuffer(s, buffer);
+    stringFreeCharInBuffer(s2, buffer2);
     
     handleNEP(state != 0);
     return NOTHINGNESS;
 }
 
 Something filesFileExists(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    Something x = (access(s, F_OK) == 0) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
-    free(s);
+    char buffer[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    int state;
+    allowingGC(state = access(s, F_OK));
+    Something x = (state == 0) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+    stringFreeCharInBuffer(s, buffer);
     return x;
 }
 
 Something filesIsReadable(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    Something x = (access(s, R_OK) == 0) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
-    free(s);
+    char buffer[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    int state;
+    allowingGC(state = access(s, R_OK));
+    Something x = (state == 0) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+    stringFreeCharInBuffer(s, buffer);
     return x;
 }
 
 Something filesIsWriteable(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    Something x = (access(s, W_OK) == 0)  ? EMOJICODE_TRUE : EMOJICODE_FALSE;
-    free(s);
+    char buffer[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    int state;
+    allowingGC(state = access(s, W_OK));
+    Something x = (state == 0) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+    stringFreeCharInBuffer(s, buffer);
     return x;
 }
 
 Something filesIsExecuteable(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    Something x = (access(s, X_OK) == 0)  ? EMOJICODE_TRUE : EMOJICODE_FALSE;
-    free(s);
+    char buffer[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    int state;
+    allowingGC(state = access(s, X_OK));
+    Something x = (state == 0) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+    stringFreeCharInBuffer(s, buffer);
     return x;
 }
 
 Something filesRemove(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    int state = remove(s);
-    free(s);
+    char buffer[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    int state;
+    allowingGC(state = remove(s));
+    stringFreeCharInBuffer(s, buffer);
     
     handleNEP(state != 0);
     return NOTHINGNESS;
 }
 
 Something filesRmdir(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    int state = rmdir(s);
-    free(s);
+    char buffer[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    int state;
+    allowingGC(state = rmdir(s));
+    stringFreeCharInBuffer(s, buffer);
     
     handleNEP(state != 0);
     return NOTHINGNESS;
@@ -105,90 +138,126 @@ int filesRecursiveRmdirHelper(const char *fpath, const struct stat *sb, int type
 }
 
 Something filesRecursiveRmdir(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
+    char buffer[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
     
-    int state = nftw(s, filesRecursiveRmdirHelper, 64, FTW_DEPTH | FTW_PHYS);
-    handleNEP(state != 0);
+    int state;
+    allowingGC(state = nftw(s, filesRecursiveRmdirHelper, 64, FTW_DEPTH | FTW_PHYS));
+    stringFreeCharInBuffer(s, buffer);
     
-    free(s);
+    handleNEP(state != 0);
     return NOTHINGNESS;
 }
 
 Something filesSize(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
+    char buffer[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    long length = -1;
     
+    allowGC();
+    flushPendingWrites();
     FILE *file = fopen(s, "r");
-    free(s);
-    
-    if(file == NULL){
-        return somethingInteger(-1);
+    if (file) {
+        fseek(file, 0L, SEEK_END);
+        length = ftell(file);
+        fclose(file);
     }
-    
-    fseek(file, 0L, SEEK_END);
-    
-    long length = ftell(file);
-    
-    fclose(file);
+    disallowGCAndPauseIfNeeded();
+    stringFreeCharInBuffer(s, buffer);
     
     return somethingInteger((EmojicodeInteger)length);
 }
 
 Something filesRealpath(Thread *thread) {
     char path[PATH_MAX];
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    char *x = realpath(s, path);
+    char buffer[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    char *x;
+    allowingGC(x = realpath(s, path));
     
-    free(s);
+    stringFreeCharInBuffer(s, buffer);
     
     if (!x) {
         return NOTHINGNESS;
     }
-    return somethingObject(stringFromChar(path));
+    return somethingObject(stringFromUTF8(path, strlen(path), thread));
 }
 
 //MARK: file
 
+/**
+ * Writes the bytes of @c d to @c file while the GC can run. Bytes on the object heap are copied first because the GC
+ * might move them meanwhile.
+ */
+static void fileWriteBytes(FILE *file, Data *d){
+    const char *bytes = d->bytes;
+    char *copy = NULL;
+    if (d->bytesObject) {
+        bytes = copy = malloc(d->length);
+        memcpy(copy, d->bytes, d->length);
+    }
+    allowingGC(fwrite(bytes, 1, d->length, file));
+    free(copy);
+}
+
 //Shortcuts
 
 Something fileDataPut(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
-    FILE *file = fopen(s, "wb");
-    free(s);
+    char buffer[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    FILE *file;
+    allowingGC(file = fopen(s, "wb"));
+    stringFreeCharInBuffer(s, buffer);
     
     handleNEP(file == NULL);
     
-    Data *d = stackGetVariable(1, thread).object->value;
-    
-    fwrite(d->bytes, 1, d->length, file);
+    fileWriteBytes(file, stackGetVariable(1, thread).object->value);
     
-    handleNEP(ferror(file));
+    if (ferror(file)) {
+        int error = errno;
+        fclose(file);
+        return somethingObject(newError(strerror(error), error));
+    }
     
-    fclose(file);
+    int state;
+    allowingGC(state = fclose(file));
+    handleNEP(state != 0);
     return NOTHINGNESS;
 }
 
 Something fileDataGet(Thread *thread){
-    char *s = stringToChar(stackGetVariable(0, thread).object->value);
+    char buffer[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    
+    //The file is read outside of the heap while the GC can run and copied into it afterwards
+    char *bytes = NULL;
+    size_t length = 0;
+    bool failed = true;
+    allowGC();
+    flushPendingWrites();
     FILE *file = fopen(s, "rb");
-    free(s);
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        if (size >= 0) {
+            bytes = malloc(size > 0 ? size : 1);
+            length = fread(bytes, 1, size, file);
+            failed = ferror(file);
+        }
+        fclose(file);
+    }
+    disallowGCAndPauseIfNeeded();
+    stringFreeCharInBuffer(s, buffer);
     
-    if(file == NULL){
+    if (failed) {
+        free(bytes);
         return NOTHINGNESS;
     }
     
-    int state = fseek(file, 0, SEEK_END);
-    
-    long length = ftell(file);
-    
-    state = fseek(file, 0, SEEK_SET);
-    
     Object *bytesObject = newArray(length);
-    fread(bytesObject->value, 1, length, file);
-    if(ferror(file)){
-        fclose(file);
-        return NOTHINGNESS;
-    }
-    fclose(file);
+    memcpy(bytesObject->value, bytes, length);
+    free(bytes);
     
     stackPush(bytesObject, 0, 0, thread);
     
@@ -203,11 +272,167 @@ Something fileDataGet(Thread *thread){
     return somethingObject(obj);
 }
 
-#define file(obj) (*((FILE**)(obj)->value))
+static void fileUnmapData(Data *data){
+    munmap(data->bytes, data->length);
+}
+
+/**
+ * Maps the file into memory and returns a 📇 whose bytes are the mapping. The bytes are outside of the object heap,
+ * so the file is neither copied into the heap nor by the garbage collector. The mapping is removed when the 📇 is
+ * deallocated.
+ */
+Something fileDataMap(Thread *thread){
+    char buffer[PATH_MAX];
+    char *p = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    bool copyOnWrite = unwrapBool(stackGetVariable(1, thread));
+    EmojicodeInteger access = unwrapInteger(stackGetVariable(2, thread));
+    
+    int fd;
+    allowingGC(flushPendingWrites(); fd = open(p, O_RDONLY));
+    stringFreeCharInBuffer(p, buffer);
+    if (fd < 0) {
+        return NOTHINGNESS;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NOTHINGNESS;
+    }
+    
+    char *bytes = NULL;
+    if (st.st_size > 0) {
+        int protection = copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ, flags = copyOnWrite ? MAP_PRIVATE : MAP_SHARED;
+        bytes = mmap(NULL, st.st_size, protection, flags, fd, 0);
+        if (bytes == MAP_FAILED && errno == ENOMEM) {
+            //Mappings are only removed by the deinitializers of unreachable 📇, which the heap might not require yet
+            forceGC();
+            bytes = mmap(NULL, st.st_size, protection, flags, fd, 0);
+        }
+        if (bytes == MAP_FAILED) {
+            close(fd);
+            return NOTHINGNESS;
+        }
+        //The values of 👣
+        static const int advice[] = { POSIX_MADV_NORMAL, POSIX_MADV_SEQUENTIAL, POSIX_MADV_RANDOM };
+        if (0 <= access && access < 3) {
+            posix_madvise(bytes, st.st_size, advice[access]);
+        }
+    }
+    close(fd);
+    
+    Object *obj = newObject(CL_DATA);
+    Data *data = obj->value;
+    data->length = st.st_size;
+    data->bytes = bytes;
+    if (bytes) {
+        data->release = fileUnmapData;
+    }
+    return somethingObject(obj);
+}
+
+/** Bytes read from a file ahead of what was requested, which lets 🗡 split lines without reading byte by byte. */
+typedef struct {
+    char *bytes;
+    /** The bytes not consumed yet are those from @c start to @c end. */
+    size_t start;
+    size_t end;
+    size_t capacity;
+} FileBuffer;
+
+typedef struct {
+    FILE *file;
+    /** The read-ahead buffer or NULL if nothing was read from the file yet. */
+    FileBuffer *buffer;
+} EmojicodeFile;
+
+#define file(obj) (((EmojicodeFile *)(obj)->value)->file)
+
+/** The size in which files are read ahead. */
+#define fileBufferSize 65536
+
+/** Shared by all 📄 of the standard input so that no 📄 misses the bytes another one read ahead. */
+static FileBuffer standardInputBuffer;
+
+/** Returns the read-ahead buffer of @c f and allocates it if necessary. */
+static FileBuffer* fileBuffer(EmojicodeFile *f){
+    if (!f->buffer) {
+        f->buffer = calloc(1, sizeof(FileBuffer));
+    }
+    return f->buffer;
+}
+
+/**
+ * Reads the standard input through stdio, which 😯 of 🔡 uses as well, and stops after a line break. Thereby the
+ * read-ahead buffer never holds more than the line being read and no bytes are taken away from 😯.
+ */
+static ssize_t fileReadStandardInput(char *bytes, size_t size){
+    size_t n = 0;
+    int c = 0;
+    flockfile(stdin);
+    while (n < size && c != '\n') {
+        c = getc_unlocked(stdin);
+        if (c == EOF) {
+            if (ferror(stdin) && errno == EINTR) {
+                clearerr(stdin);
+                continue;
+            }
+            break;
+        }
+        bytes[n++] = (char)c;
+    }
+    bool failed = n == 0 && ferror(stdin);
+    funlockfile(stdin);
+    return failed ? -1 : (ssize_t)n;
+}
+
+/**
+ * Reads up to @c size bytes into @c bytes, returning as soon as any bytes are available so that reading from a terminal
+ * or pipe does not block until @c size bytes arrived. All reading goes through this function, the FILE’s own buffer is
+ * never used for reading but for the standard input.
+ * @returns The number of bytes read, 0 at the end of the file or -1 on error.
+ */
+static ssize_t fileReadAvailable(FILE *file, char *bytes, size_t size){
+    if (file == stdin) {
+        return fileReadStandardInput(bytes, size);
+    }
+    ssize_t n;
+    do {
+        n = read(fileno(file), bytes, size);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
+/** Reads more bytes into the buffer, growing it if it is full. @returns Whether any bytes were read. */
+static bool fileBufferFill(FileBuffer *buffer, FILE *file){
+    if (buffer->start > 0) {
+        memmove(buffer->bytes, buffer->bytes + buffer->start, buffer->end - buffer->start);
+        buffer->end -= buffer->start;
+        buffer->start = 0;
+    }
+    if (buffer->end == buffer->capacity) {
+        buffer->capacity = buffer->capacity ? buffer->capacity * 2 : fileBufferSize;
+        buffer->bytes = realloc(buffer->bytes, buffer->capacity);
+    }
+    ssize_t n = fileReadAvailable(file, buffer->bytes + buffer->end, buffer->capacity - buffer->end);
+    if (n <= 0) {
+        return false;
+    }
+    buffer->end += n;
+    return true;
+}
+
+/** Discards the bytes read ahead, which must be done whenever the file position is changed. */
+static void fileBufferDiscard(FileBuffer *buffer){
+    if (buffer) {
+        buffer->start = buffer->end = 0;
+    }
+}
 
 Something fileStdinGet(Thread *thread){
     Object *obj = newObject(stackGetThisClass(thread));
     file(obj) = stdin;
+    ((EmojicodeFile *)obj->value)->buffer = &standardInputBuffer;
     return somethingObject(obj);
 }
 
@@ -226,57 +451,136 @@ Something fileStderrGet(Thread *thread){
 //Constructors
 
 void fileForWriting(Thread *thread){
-    char *p = stringToChar(stackGetVariable(0, thread).object->value);
-    FILE *f = fopen(p, "wb");
+    char buffer[PATH_MAX];
+    char *p = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    FILE *f;
+    allowingGC(f = fopen(p, "wb"));
     if (f){
         file(stackGetThis(thread)) = f;
     }
     else {
         stackGetThis(thread)->value = NULL;
     }
-    free(p);
+    stringFreeCharInBuffer(p, buffer);
 }
 
 void fileForReading(Thread *thread){
-    char *p = stringToChar(stackGetVariable(0, thread).object->value);
-    FILE *f = fopen(p, "rb");
+    char buffer[PATH_MAX];
+    char *p = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    FILE *f;
+    allowingGC(flushPendingWrites(); f = fopen(p, "rb"));
     if (f){
         file(stackGetThis(thread)) = f;
     }
     else {
         stackGetThis(thread)->value = NULL;
     }
-    free(p);
+    stringFreeCharInBuffer(p, buffer);
 }
 
 Something fileWriteData(Thread *thread){
     FILE *f = file(stackGetThis(thread));
     Data *d = stackGetVariable(0, thread).object->value;
     
-    fwrite(d->bytes, 1, d->length, f);
-    fflush(f);
+    //The standard output and error go through the runtime's buffers to keep them in order with 😀
+    if (f == stdout) {
+        outputWrite(standardOutput, d->bytes, d->length);
+        return NOTHINGNESS;
+    }
+    if (f == stderr) {
+        outputWrite(standardError, d->bytes, d->length);
+        return NOTHINGNESS;
+    }
+    
+    fileWriteBytes(f, d);
     
     handleNEP(ferror(f));
     return NOTHINGNESS;
 }
 
-Something fileReadData(Thread *thread){
+Something fileWriteJSON(Thread *thread){
     FILE *f = file(stackGetThis(thread));
+    size_t size;
+    char *json = serializeJSON(stackGetVariable(0, thread), unwrapBool(stackGetVariable(1, thread)), &size);
+    if (json == NULL) {
+        return somethingObject(newError("The value cannot be represented as JSON.", EINVAL));
+    }
+    
+    if (f == stdout) {
+        outputWrite(standardOutput, json, size);
+    }
+    else if (f == stderr) {
+        outputWrite(standardError, json, size);
+    }
+    else {
+        allowingGC(fwrite(json, 1, size, f));
+    }
+    free(json);
+    
+    handleNEP(f != stdout && f != stderr && ferror(f));
+    return NOTHINGNESS;
+}
+
+Something fileFlush(Thread *thread){
+    FILE *f = file(stackGetThis(thread));
+    
+    if (f == stdout) {
+        outputFlush(standardOutput);
+        return NOTHINGNESS;
+    }
+    if (f == stderr) {
+        outputFlush(standardError);
+        return NOTHINGNESS;
+    }
+    
+    int state;
+    allowingGC(state = fflush(f));
+    handleNEP(state != 0);
+    return NOTHINGNESS;
+}
+
+Something fileReadData(Thread *thread){
     EmojicodeInteger n = unwrapInteger(stackGetVariable(0, thread));
     
-    Object *bytesObject = newArray(n);
+    EmojicodeFile *f = stackGetThis(thread)->value;
+    size_t read = 0, size = n > 0 ? n : 0;
+    //The bytes are read outside of the heap while the GC can run and only as many as were read are copied into it
+    char *bytes = malloc(size > 0 ? size : 1);
+    if (!bytes) {
+        return NOTHINGNESS;
+    }
     
-    size_t read = fread(bytesObject->value, 1, n, f);
+    //Hand out the bytes read ahead first
+    FileBuffer *buffer = f->buffer;
+    if (buffer && buffer->end > buffer->start) {
+        read = buffer->end - buffer->start < size ? buffer->end - buffer->start : size;
+        memcpy(bytes, buffer->bytes + buffer->start, read);
+        buffer->start += read;
+    }
+    if (read < size) {
+        FILE *file = f->file;
+        ssize_t r;
+        allowGC();
+        while (read < size && (r = fileReadAvailable(file, bytes + read, size - read)) > 0) {
+            read += r;
+        }
+        disallowGCAndPauseIfNeeded();
+    }
     
-    if(read != n || ferror(f)){
+    if(read == 0){
+        free(bytes);
         return NOTHINGNESS;
     }
     
+    Object *bytesObject = newArray(read);
+    memcpy(bytesObject->value, bytes, read);
+    free(bytes);
+    
     stackPush(bytesObject, 0, 0, thread);
     
     Object *obj = newObject(CL_DATA);
     Data *data = obj->value;
-    data->length = n;
+    data->length = read;
     data->bytesObject = stackGetThis(thread);
     data->bytes = data->bytesObject->value;
     
@@ -286,21 +590,285 @@ Something fileReadData(Thread *thread){
 }
 
 Something fileSeekTo(Thread *thread){
-    fseek(file(stackGetThis(thread)), unwrapInteger(stackGetVariable(0, thread)), SEEK_SET);
+    EmojicodeFile *f = stackGetThis(thread)->value;
+    FILE *file = f->file;
+    EmojicodeInteger offset = unwrapInteger(stackGetVariable(0, thread));
+    fileBufferDiscard(f->buffer);
+    allowingGC(fseek(file, offset, SEEK_SET));
     return NOTHINGNESS;
 }
 
 Something fileSeekToEnd(Thread *thread){
-    fseek(file(stackGetThis(thread)), 0, SEEK_END);
+    EmojicodeFile *f = stackGetThis(thread)->value;
+    FILE *file = f->file;
+    fileBufferDiscard(f->buffer);
+    allowingGC(fseek(file, 0, SEEK_END));
     return NOTHINGNESS;
 }
 
-Something fileReadLine(Thread *thread){
+//MARK: Asynchronous reading and writing
+
+/** The value of a 📬. */
+typedef struct {
+    FileOperation *operation;
+    /** The 📄 whose descriptor the operation uses, it must not be closed before the operation completed. */
+    Object *file;
+    /** The 📇 with the bytes read once 📇 was called. */
+    Object *data;
+} FileCompletion;
+
+static Class *fileCompletionClass;
+
+static void fileFreeData(Data *data){
+    free(data->bytes);
+}
+
+/** Returns a 📬 for @c operation on the descriptor of the 📄 in the this-slot. */
+static Something fileCompletionNew(FileOperation *operation, Thread *thread){
+    Object *obj = newObject(fileCompletionClass);
+    FileCompletion *completion = obj->value;
+    completion->operation = operation;
+    completion->file = stackGetThis(thread);
+    return somethingObject(obj);
+}
+
+Something fileReadAsync(Thread *thread){
+    EmojicodeInteger offset = unwrapInteger(stackGetVariable(0, thread));
+    EmojicodeInteger size = unwrapInteger(stackGetVariable(1, thread));
+    allowingGC(flushPendingWrites());
+    return fileCompletionNew(fileOperationRead(fileno(file(stackGetThis(thread))), offset, size > 0 ? size : 0),
+                             thread);
+}
+
+Something fileWriteAsync(Thread *thread){
+    FILE *f = file(stackGetThis(thread));
+    EmojicodeInteger offset = unwrapInteger(stackGetVariable(0, thread));
+    //Bytes written with ✏️ before must reach the file first
+    allowingGC(fflush(f));
+    Data *d = stackGetVariable(1, thread).object->value;
+    return fileCompletionNew(fileOperationWrite(fileno(f), offset, d->bytes, d->length), thread);
+}
+
+/** Waits for the operation of the 📬 in the this-slot to complete while the GC can run. */
+static FileOperation* fileCompletionWait(Thread *thread){
+    FileOperation *operation = ((FileCompletion *)stackGetThis(thread)->value)->operation;
+    if (!fileOperationDone(operation)) {
+        allowGC();
+        fileOperationWait(operation);
+        disallowGCAndPauseIfNeeded();
+    }
+    return operation;
+}
+
+Something fileCompletionDone(Thread *thread){
+    FileOperation *operation = ((FileCompletion *)stackGetThis(thread)->value)->operation;
+    return fileOperationDone(operation) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+Something fileCompletionError(Thread *thread){
+    int error = fileOperationError(fileCompletionWait(thread));
+    if (error) {
+        return somethingObject(newError(strerror(error), error));
+    }
     return NOTHINGNESS;
 }
 
-void closeFile(void *file){
-    fclose((*((FILE**)file)));
+Something fileCompletionTransferred(Thread *thread){
+    return somethingInteger((EmojicodeInteger)fileOperationTransferred(fileCompletionWait(thread)));
+}
+
+Something fileCompletionData(Thread *thread){
+    FileOperation *operation = fileCompletionWait(thread);
+    FileCompletion *completion = stackGetThis(thread)->value;
+    if (completion->data) {
+        return somethingObject(completion->data);
+    }
+    if (fileOperationError(operation)) {
+        return NOTHINGNESS;
+    }
+    char *bytes = fileOperationTakeBytes(operation);
+    if (!bytes) {
+        return NOTHINGNESS;
+    }
+    Object *obj = newObject(CL_DATA);
+    Data *data = obj->value;
+    data->length = fileOperationTransferred(operation);
+    data->bytes = bytes;
+    data->release = fileFreeData;
+    ((FileCompletion *)stackGetThis(thread)->value)->data = obj;
+    return somethingObject(obj);
+}
+
+static void fileCompletionMark(Object *self){
+    FileCompletion *completion = self->value;
+    if (completion->file) {
+        //Once the operation completed the 📄 may be closed
+        if (fileOperationDone(completion->operation)) {
+            completion->file = NULL;
+        }
+        else {
+            mark(&completion->file);
+        }
+    }
+    if (completion->data) {
+        mark(&completion->data);
+    }
+}
+
+static void fileCompletionRelease(void *value){
+    fileOperationRelease(((FileCompletion *)value)->operation);
+}
+
+//MARK: Walking directories
+
+/** The most threads a 🗂 reads directories with. */
+#define directoryWalkerMaxThreads 64
+
+/** The value of a 🗂. */
+typedef struct {
+    DirectoryWalk *walk;
+    /** The current entry or NULL before the first and after the last 🔜. */
+    const DirectoryEntry *entry;
+} DirectoryWalker;
+
+#define directoryWalkerEntry(obj) (((DirectoryWalker *)(obj)->value)->entry)
+
+void directoryWalkerOpen(Thread *thread){
+    char buffer[PATH_MAX];
+    char *s = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
+    bool recursive = unwrapBool(stackGetVariable(1, thread));
+    EmojicodeInteger threads = unwrapInteger(stackGetVariable(2, thread));
+    if (threads < 0) {
+        threads = 0;
+    }
+    else if (threads > directoryWalkerMaxThreads) {
+        threads = directoryWalkerMaxThreads;
+    }
+    DirectoryWalk *walk;
+    allowingGC(walk = directoryWalkOpen(s, recursive, threads));
+    stringFreeCharInBuffer(s, buffer);
+    
+    if (!walk) {
+        stackGetThis(thread)->value = NULL;
+        return;
+    }
+    DirectoryWalker *walker = stackGetThis(thread)->value;
+    walker->walk = walk;
+    walker->entry = NULL;
+}
+
+Something directoryWalkerNext(Thread *thread){
+    DirectoryWalk *walk = ((DirectoryWalker *)stackGetThis(thread)->value)->walk;
+    const DirectoryEntry *entry;
+    allowingGC(entry = directoryWalkNext(walk));
+    directoryWalkerEntry(stackGetThis(thread)) = entry;
+    return entry ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+Something directoryWalkerPath(Thread *thread){
+    const DirectoryEntry *entry = directoryWalkerEntry(stackGetThis(thread));
+    if (!entry) {
+        return somethingObject(emptyString);
+    }
+    return somethingObject(stringFromUTF8(entry->path, entry->pathLength, thread));
+}
+
+Something directoryWalkerName(Thread *thread){
+    const DirectoryEntry *entry = directoryWalkerEntry(stackGetThis(thread));
+    if (!entry) {
+        return somethingObject(emptyString);
+    }
+    return somethingObject(stringFromUTF8(entry->name, entry->path + entry->pathLength - entry->name, thread));
+}
+
+Something directoryWalkerIsDirectory(Thread *thread){
+    const DirectoryEntry *entry = directoryWalkerEntry(stackGetThis(thread));
+    return entry && S_ISDIR(entry->status.st_mode) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+Something directoryWalkerIsSymlink(Thread *thread){
+    const DirectoryEntry *entry = directoryWalkerEntry(stackGetThis(thread));
+    return entry && S_ISLNK(entry->status.st_mode) ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+Something directoryWalkerSize(Thread *thread){
+    const DirectoryEntry *entry = directoryWalkerEntry(stackGetThis(thread));
+    return somethingInteger(entry ? (EmojicodeInteger)entry->status.st_size : 0);
+}
+
+Something directoryWalkerModified(Thread *thread){
+    const DirectoryEntry *entry = directoryWalkerEntry(stackGetThis(thread));
+    return somethingInteger(entry ? (EmojicodeInteger)entry->status.st_mtime : 0);
+}
+
+Something directoryWalkerMode(Thread *thread){
+    const DirectoryEntry *entry = directoryWalkerEntry(stackGetThis(thread));
+    return somethingInteger(entry ? (EmojicodeInteger)(entry->status.st_mode & 07777) : 0);
+}
+
+static void directoryWalkerClose(void *value){
+    if (value) {
+        directoryWalkClose(((DirectoryWalker *)value)->walk);
+    }
+}
+
+/**
+ * Reads the next line from the read-ahead buffer, which is refilled in large blocks, and finds its end with memchr.
+ * The line break, which is either LF or CR LF, is not part of the returned string.
+ */
+Something fileReadLine(Thread *thread){
+    EmojicodeFile *f = stackGetThis(thread)->value;
+    FileBuffer *buffer = fileBuffer(f);
+    FILE *file = f->file;
+    
+    size_t scanned = 0;
+    char *newline = NULL;
+    while (true) {
+        size_t available = buffer->end - buffer->start;
+        if (available > scanned &&
+            (newline = memchr(buffer->bytes + buffer->start + scanned, '\n', available - scanned))) {
+            break;
+        }
+        scanned = available;
+        bool filled;
+        allowingGC(filled = fileBufferFill(buffer, file));
+        if (!filled) {
+            break;
+        }
+    }
+    
+    const char *line = buffer->bytes + buffer->start;
+    size_t length;
+    if (newline) {
+        length = newline - line;
+        buffer->start += length + 1;
+    }
+    else if (buffer->end > buffer->start) {
+        //The last line of the file is not terminated
+        length = buffer->end - buffer->start;
+        buffer->start = buffer->end;
+    }
+    else {
+        return NOTHINGNESS;
+    }
+    if (length > 0 && line[length - 1] == '\r') {
+        length--;
+    }
+    return somethingObject(stringFromUTF8(line, length, thread));
+}
+
+void closeFile(void *value){
+    EmojicodeFile *f = value;
+    if (!f) {
+        return;
+    }
+    if (f->buffer && f->buffer != &standardInputBuffer) {
+        free(f->buffer->bytes);
+        free(f->buffer);
+    }
+    if (f->file != stdin && f->file != stdout && f->file != stderr) {
+        fclose(f->file);
+    }
 }
 
 ClassMethodHandler handlerPointerForClassMethod(EmojicodeChar cl, EmojicodeChar symbol){
@@ -336,6 +904,8 @@ ClassMethodHandler handlerPointerForClassMethod(EmojicodeChar cl, EmojicodeChar
                 return fileDataPut;
             case 0x1F4C7:
                 return fileDataGet;
+            case 0x1F5FA: //🗺
+                return fileDataMap;
             case 0x1F4E5:
                 return fileStdinGet;
             case 0x1F4E4:
@@ -348,6 +918,40 @@ ClassMethodHandler handlerPointerForClassMethod(EmojicodeChar cl, EmojicodeChar
 }
 
 MethodHandler handlerPointerForMethod(EmojicodeChar cl, EmojicodeChar symbol){
+    if (cl == 0x1F4EC) { //📬
+        switch (symbol) {
+            case 0x2753: //❓
+                return fileCompletionDone;
+            case 0x23F3: //⏳
+                return fileCompletionError;
+            case 0x1F4CF: //📏
+                return fileCompletionTransferred;
+            case 0x1F4C7: //📇
+                return fileCompletionData;
+        }
+        return NULL;
+    }
+    if (cl == 0x1F5C2) { //🗂
+        switch (symbol) {
+            case 0x1F51C: //🔜
+                return directoryWalkerNext;
+            case 0x1F521: //🔡
+                return directoryWalkerPath;
+            case 0x1F3F7: //🏷
+                return directoryWalkerName;
+            case 0x1F4C1: //📁
+                return directoryWalkerIsDirectory;
+            case 0x1F517: //🔗
+                return directoryWalkerIsSymlink;
+            case 0x1F4CF: //📏
+                return directoryWalkerSize;
+            case 0x23F0: //⏰
+                return directoryWalkerModified;
+            case 0x1F510: //🔐
+                return directoryWalkerMode;
+        }
+        return NULL;
+    }
     switch (symbol) {
         case 0x270F:
             return fileWriteData;
@@ -359,11 +963,22 @@ MethodHandler handlerPointerForMethod(EmojicodeChar cl, EmojicodeChar symbol){
             return fileSeekToEnd;
         case 0x1F5E1:
             return fileReadLine;
+        case 0x1F6BD: //🚽
+            return fileFlush;
+        case 0x1F4F0: //📰
+            return fileWriteJSON;
+        case 0x1F4E8: //📨
+            return fileReadAsync;
+        case 0x1F4EE: //📮
+            return fileWriteAsync;
     }
     return NULL;
 }
 
 InitializerHandler handlerPointerForInitializer(EmojicodeChar cl, EmojicodeChar symbol){
+    if (cl == 0x1F5C2) { //🗂
+        return directoryWalkerOpen;
+    }
     switch (symbol) {
         case 0x1F4DD:
             return fileForWriting;
@@ -374,13 +989,21 @@ InitializerHandler handlerPointerForInitializer(EmojicodeChar cl, EmojicodeChar
 }
 
 Marker markerPointerForClass(EmojicodeChar cl){
+    if (cl == 0x1F4EC) {
+        return fileCompletionMark;
+    }
     return NULL;
 }
 
 uint_fast32_t sizeForClass(Class *cl, EmojicodeChar name) {
     switch (name) {
         case 0x1F4C4:
-            return sizeof(FILE*);
+            return sizeof(EmojicodeFile);
+        case 0x1F4EC: //📬
+            fileCompletionClass = cl;
+            return sizeof(FileCompletion);
+        case 0x1F5C2: //🗂
+            return sizeof(DirectoryWalker);
     }
     return 0;
 }
@@ -389,5 +1012,11 @@ Deinitializer deinitializerPointerForClass(EmojicodeChar cl){
     if(cl == 0x1F4C4){
         return closeFile;
     }
+    if(cl == 0x1F4EC){
+        return fileCompletionRelease;
+    }
+    if(cl == 0x1F5C2){
+        return directoryWalkerClose;
+    }
     return NULL;
 }
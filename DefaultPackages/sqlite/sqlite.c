@@ -13,169 +13,527 @@
 #include "sqlite3.h"
 #include <string.h>
 
-#define goSqlite3(obj) (*((sqlite3**)(obj)->value))
-#define goSqlite3_stmt(obj) (*((sqlite3_stmt**)(obj)->value))
+/** The number of prepared statements no 💬 uses that a database keeps to be reused by the next 💬 with their SQL. */
+#ifndef sqliteStatementCacheSize
+#define sqliteStatementCacheSize 16
+#endif
+
+/**
+ * The connection of a 📚, which is shared with the 💬 prepared on it. The GC deinitializes objects in no particular
+ * order, so the connection lives until the last of them was deallocated.
+ */
+typedef struct {
+    sqlite3 *db;
+    /** Guards the cache and the reference count. */
+    pthread_mutex_t mutex;
+    /** The statements available for reuse, the least recently used first. */
+    sqlite3_stmt *cache[sqliteStatementCacheSize];
+    size_t cacheCount;
+    /** The number of statements that were taken from the cache instead of being compiled. */
+    size_t hits;
+    /** The number of objects referring to this connection. */
+    size_t references;
+    /** Whether the 📚 was deallocated, statements are then finalized instead of being cached. */
+    bool closed;
+} SQLiteConnection;
+
+#define goSQLiteConnection(obj) (*((SQLiteConnection **)(obj)->value))
+#define goSqlite3(obj) (goSQLiteConnection(obj)->db)
+#define goSqlite3_stmt(obj) (((SQLiteStatement *)(obj)->value)->statement)
+
+/** A code @c bridgeSQLiteBind returns for values SQLite cannot store. */
+#define sqliteUnbindable -2
+/** A code for operations on a 💬 that was finished with 🗑. */
+#define sqliteFinished -3
+
+/** The value of a 💬. */
+typedef struct {
+    sqlite3_stmt *statement;
+    SQLiteConnection *connection;
+    /** A 🍨 of the names of the columns, which is created the first time they are needed. */
+    Object *columnNames;
+    /** Whether 🔜 went past the last row, SQLite would otherwise start over on the next step. */
+    bool done;
+} SQLiteStatement;
 
 PackageVersion getVersion(){
     return (PackageVersion){0, 1};
 }
 
+//MARK: Connections
+
+/** Drops a reference to @c connection and closes it if it was the last one. Must be called with the mutex held. */
+static void connectionRelease(SQLiteConnection *connection){
+    if (--connection->references > 0) {
+        pthread_mutex_unlock(&connection->mutex);
+        return;
+    }
+    pthread_mutex_unlock(&connection->mutex);
+    sqlite3_close(connection->db);
+    pthread_mutex_destroy(&connection->mutex);
+    free(connection);
+}
+
+/** Removes the most recently used statement with the SQL text @c sql from the cache or returns NULL. */
+static sqlite3_stmt* connectionTakeStatement(SQLiteConnection *connection, const char *sql){
+    pthread_mutex_lock(&connection->mutex);
+    for (size_t i = connection->cacheCount; i-- > 0;) {
+        sqlite3_stmt *statement = connection->cache[i];
+        if (strcmp(sqlite3_sql(statement), sql) == 0) {
+            connection->cacheCount--;
+            connection->hits++;
+            memmove(connection->cache + i, connection->cache + i + 1,
+                    (connection->cacheCount - i) * sizeof(sqlite3_stmt *));
+            pthread_mutex_unlock(&connection->mutex);
+            return statement;
+        }
+    }
+    pthread_mutex_unlock(&connection->mutex);
+    return NULL;
+}
+
+/** Hands @c statement, which is no longer used, back to @c connection. */
+static void connectionPutStatement(SQLiteConnection *connection, sqlite3_stmt *statement){
+    //A reset statement holds no locks, and bound values might refer to memory that is about to be freed
+    sqlite3_reset(statement);
+    sqlite3_clear_bindings(statement);
+    pthread_mutex_lock(&connection->mutex);
+    if (connection->closed) {
+        sqlite3_finalize(statement);
+    }
+    else {
+        if (connection->cacheCount == sqliteStatementCacheSize) {
+            sqlite3_finalize(connection->cache[0]);
+            connection->cacheCount--;
+            memmove(connection->cache, connection->cache + 1, connection->cacheCount * sizeof(sqlite3_stmt *));
+        }
+        connection->cache[connection->cacheCount++] = statement;
+    }
+    pthread_mutex_unlock(&connection->mutex);
+}
+
+//MARK: Database
+
 static void bridgeSQLiteOpen(Thread *thread){
     char *path = stringToChar(stackGetVariable(0, thread).object->value);
-    int state = sqlite3_open(path, (sqlite3**)stackGetThis(thread)->value);
+    sqlite3 *db;
+    int state;
+    allowingGC(state = sqlite3_open(path, &db));
     free(path);
     
     if(state != SQLITE_OK){
+        sqlite3_close(db);
         stackGetThis(thread)->value = NULL;
-        puts(sqlite3_errmsg(goSqlite3(stackGetThis(thread))));
+        return;
     }
+    
+    SQLiteConnection *connection = calloc(1, sizeof(SQLiteConnection));
+    connection->db = db;
+    connection->references = 1;
+    pthread_mutex_init(&connection->mutex, NULL);
+    goSQLiteConnection(stackGetThis(thread)) = connection;
 }
 
-static void bridgeSQLiteRelease(void *db){
-    sqlite3_close_v2(db);
+static void bridgeSQLiteRelease(void *value){
+    if (!value) {
+        return;
+    }
+    SQLiteConnection *connection = *(SQLiteConnection **)value;
+    pthread_mutex_lock(&connection->mutex);
+    connection->closed = true;
+    for (size_t i = 0; i < connection->cacheCount; i++) {
+        sqlite3_finalize(connection->cache[i]);
+    }
+    connection->cacheCount = 0;
+    connectionRelease(connection);
 }
 
+//MARK: Statements
+
 static void bridgeSQLitePrepare(Thread *thread){
     char *sql = stringToChar(stackGetVariable(1, thread).object->value);
-    sqlite3_stmt *statement;
-    if(sqlite3_prepare_v2(goSqlite3(stackGetVariable(0, thread).object), sql, -1, &statement, NULL) != SQLITE_OK){
-        puts(sqlite3_errmsg(goSqlite3(stackGetVariable(0, thread).object)));
+    SQLiteConnection *connection = goSQLiteConnection(stackGetVariable(0, thread).object);
+    sqlite3_stmt *statement = connectionTakeStatement(connection, sql);
+    int state = SQLITE_OK;
+    if (!statement) {
+        allowingGC(state = sqlite3_prepare_v2(connection->db, sql, -1, &statement, NULL));
     }
-    goSqlite3_stmt(stackGetThis(thread)) = statement;
     free(sql);
+    if(state != SQLITE_OK){
+        stackGetThis(thread)->value = NULL;
+        return;
+    }
+    
+    pthread_mutex_lock(&connection->mutex);
+    connection->references++;
+    pthread_mutex_unlock(&connection->mutex);
+    
+    SQLiteStatement *value = stackGetThis(thread)->value;
+    value->statement = statement;
+    value->connection = connection;
+    value->columnNames = NULL;
+    value->done = false;
+}
+
+/**
+ * Binds @c value to the placeholder @c i of @c statement and returns the SQLite result code or @c sqliteUnbindable.
+ * Pass true for @c scoped if the binding is cleared before the GC can run again, bytes outside of the object heap
+ * are then bound without being copied.
+ */
+static int bridgeSQLiteBind(sqlite3_stmt *statement, int i, Something value, bool scoped){
+    if (isNothingness(value)) {
+        return sqlite3_bind_null(statement, i);
+    }
+    switch (value.type) {
+        case T_INTEGER:
+            return sqlite3_bind_int64(statement, i, unwrapInteger(value));
+        case T_DOUBLE:
+            return sqlite3_bind_double(statement, i, value.doubl);
+        case T_OBJECT:
+            break;
+        default:
+            return sqliteUnbindable;
+    }
+    
+    if (instanceof(value.object, CL_STRING)) {
+        String *string = value.object->value;
+        size_t size = stringUTF8Size(string);
+        //An ASCII string already is its UTF-8
+        if (string->compact && size == (size_t)string->length) {
+            return sqlite3_bind_text(statement, i, stringCharacters(string), (int)size, SQLITE_TRANSIENT);
+        }
+        char *text = malloc(size + 1);
+        stringToUTF8Buffer(string, text, size + 1);
+        return sqlite3_bind_text(statement, i, text, (int)size, free);
+    }
+    if (instanceof(value.object, CL_DATA)) {
+        Data *data = value.object->value;
+        //Bytes on the object heap move with the GC, SQLite must copy them
+        bool copy = !scoped || data->bytesObject;
+        return sqlite3_bind_blob(statement, i, data->bytes, (int)data->length, copy ? SQLITE_TRANSIENT : SQLITE_STATIC);
+    }
+    return sqliteUnbindable;
+}
+
+/** Returns the 🚨 for the result code @c state of @c bridgeSQLiteBind or a statement of @c db. */
+static Object* bridgeSQLiteError(sqlite3 *db, int state){
+    if (state == sqliteUnbindable) {
+        return newError("Unbindable type", sqliteUnbindable);
+    }
+    if (state == sqliteFinished) {
+        return newError("The query was finished", sqliteFinished);
+    }
+    return newError(sqlite3_errmsg(db), state);
 }
 
 static Something bridgeSQLiteBindInteger(Thread *thread){
     EmojicodeInteger i = unwrapInteger(stackGetVariable(0, thread));
-    Something toBind = stackGetVariable(1, thread);
+    sqlite3_stmt *statement = goSqlite3_stmt(stackGetThis(thread));
+    if (!statement) {
+        return somethingObject(bridgeSQLiteError(NULL, sqliteFinished));
+    }
+    int state = bridgeSQLiteBind(statement, (int)i, stackGetVariable(1, thread), false);
+    if (state != SQLITE_OK) {
+        return somethingObject(bridgeSQLiteError(sqlite3_db_handle(statement), state));
+    }
+    return NOTHINGNESS;
+}
+
+/**
+ * Executes the statement once for every 🍨 in the 🍨 in variable 0, binding its items to the placeholders in order,
+ * within a savepoint, so that either all rows are executed or none.
+ */
+static Something bridgeSQLiteExecuteMany(Thread *thread){
+    SQLiteStatement *value = stackGetThis(thread)->value;
+    sqlite3_stmt *statement = value->statement;
+    if (!statement) {
+        return somethingObject(bridgeSQLiteError(NULL, sqliteFinished));
+    }
+    sqlite3 *db = sqlite3_db_handle(statement);
+    value->done = false;
+    sqlite3_reset(statement);
     
     int state;
-    if(toBind.type == T_INTEGER){
-        state = sqlite3_bind_int(goSqlite3_stmt(stackGetThis(thread)), (int)i, (int)unwrapInteger(toBind));
-    }
-    else if(toBind.type == T_OBJECT && instanceof(toBind.object, CL_STRING)){
-            String *string = toBind.object->value;
-            char *text = stringToChar(string);
-            state = sqlite3_bind_text(goSqlite3_stmt(stackGetThis(thread)), (int)i, text, (int)string->length, free);
-    }
-    else if(toBind.type == T_OBJECT && instanceof(toBind.object, CL_DATA)){
-        Data *data = toBind.object->value;
-        char* bytes = malloc(data->length);
-        memcpy(bytes, data->bytes, data->length);
-        state = sqlite3_bind_blob(goSqlite3_stmt(stackGetThis(thread)), (int)i, bytes, (int)data->length, free);
-    }
-//    else if(toBind.type == T_FLOAT){
-//        state = sqlite3_bind_double(stackGetThis(thread)->value, i, *(float *)toBind->value);
-//    }
-    else if(isNothingness(toBind)){
-        state = sqlite3_bind_null(goSqlite3_stmt(stackGetThis(thread)), (int)i);
+    allowingGC(state = sqlite3_exec(db, "SAVEPOINT executeMany", NULL, NULL, NULL));
+    if (state != SQLITE_OK) {
+        return somethingObject(bridgeSQLiteError(db, state));
     }
-    else {
-        return somethingObject(newError("Unbindable type", -2));
+    
+    for (size_t r = 0; r < ((List *)stackGetVariable(0, thread).object->value)->count; r++) {
+        List *row = listItemAt(stackGetVariable(0, thread).object->value, r).object->value;
+        sqlite3_clear_bindings(statement);
+        for (size_t i = 0; i < row->count; i++) {
+            state = bridgeSQLiteBind(statement, (int)i + 1, listItemAt(row, i), true);
+            if (state != SQLITE_OK) {
+                goto fail;
+            }
+        }
+        //Bytes bound without copying are outside of the object heap and stay where they are while the GC runs
+        do {
+            allowingGC(state = sqlite3_step(statement));
+        } while (state == SQLITE_ROW);
+        if (state != SQLITE_DONE) {
+            goto fail;
+        }
+        sqlite3_reset(statement);
     }
     
+    sqlite3_clear_bindings(statement);
+    allowingGC(state = sqlite3_exec(db, "RELEASE executeMany", NULL, NULL, NULL));
     if (state != SQLITE_OK) {
-        return somethingObject(newError("See error code", state));
+        return somethingObject(bridgeSQLiteError(db, state));
     }
     return NOTHINGNESS;
+    
+    fail: {
+        Object *error = bridgeSQLiteError(db, state);
+        sqlite3_reset(statement);
+        sqlite3_clear_bindings(statement);
+        sqlite3_exec(db, "ROLLBACK TO executeMany", NULL, NULL, NULL);
+        sqlite3_exec(db, "RELEASE executeMany", NULL, NULL, NULL);
+        return somethingObject(error);
+    }
 }
 
 static Something bridgeSQLiteLastError(Thread *thread){
-    int code = sqlite3_errcode(stackGetThis(thread)->value);
-    if (code != SQLITE_OK) {
-        return somethingObject(newError(sqlite3_errmsg(stackGetThis(thread)->value), code));
+    sqlite3 *db = goSqlite3(stackGetThis(thread));
+    int code = sqlite3_errcode(db);
+    if (code != SQLITE_OK && code != SQLITE_ROW && code != SQLITE_DONE) {
+        return somethingObject(newError(sqlite3_errmsg(db), code));
     }
     return NOTHINGNESS;
 }
 
 static Something bridgeSQLiteLastInsertID(Thread *thread){
-    return somethingInteger((EmojicodeInteger)sqlite3_last_insert_rowid(stackGetThis(thread)->value));
+    return somethingInteger((EmojicodeInteger)sqlite3_last_insert_rowid(goSqlite3(stackGetThis(thread))));
+}
+
+static Something bridgeSQLiteCacheHits(Thread *thread){
+    SQLiteConnection *connection = goSQLiteConnection(stackGetThis(thread));
+    pthread_mutex_lock(&connection->mutex);
+    size_t hits = connection->hits;
+    pthread_mutex_unlock(&connection->mutex);
+    return somethingInteger((EmojicodeInteger)hits);
+}
+
+/** Steps @c statement while the GC can run, as it might have to wait for the disk or a lock on the database. */
+static bool bridgeSQLiteStepRow(sqlite3_stmt *statement){
+    int state;
+    allowingGC(state = sqlite3_step(statement));
+    return state == SQLITE_ROW;
+}
+
+/**
+ * Returns the 🍨 of the column names of the 💬 in the this-slot. The names are read from SQLite and turned into
+ * strings only once per statement.
+ * @warning GC-invoking
+ */
+static Object* bridgeSQLiteColumnNames(Thread *thread){
+    SQLiteStatement *statement = stackGetThis(thread)->value;
+    if (statement->columnNames) {
+        return statement->columnNames;
+    }
+    
+    int columns = sqlite3_column_count(statement->statement);
+    stackPush(stackGetThis(thread), 1, 0, thread);
+    stackSetVariable(0, somethingObject(newObject(CL_LIST)), thread);
+    for (int i = 0; i < columns; i++) {
+        const char *name = sqlite3_column_name(goSqlite3_stmt(stackGetThis(thread)), i);
+        Object *string = name ? stringFromUTF8(name, strlen(name), thread) : stringFromChar("");
+        listAppend(stackGetVariable(0, thread).object, somethingObject(string), thread);
+    }
+    Object *names = stackGetVariable(0, thread).object;
+    stackPop(thread);
+    ((SQLiteStatement *)stackGetThis(thread)->value)->columnNames = names;
+    return names;
+}
+
+/**
+ * Returns a 📇 with a copy of the @c length @c bytes, as blobs are only valid until the next step.
+ * @warning GC-invoking
+ */
+static Something bridgeSQLiteData(const void *bytes, int length, Thread *thread){
+    Object *bytesObject = newArray(length);
+    if (length > 0) {
+        memcpy(bytesObject->value, bytes, length);
+    }
+    stackPush(bytesObject, 0, 0, thread);
+    
+    Object *obj = newObject(CL_DATA);
+    Data *data = obj->value;
+    data->length = length;
+    data->bytesObject = stackGetThis(thread);
+    data->bytes = data->bytesObject->value;
+    
+    stackPop(thread);
+    return somethingObject(obj);
+}
+
+/**
+ * Returns the value of column @c i of the current row of the 💬 in the this-slot as 🚂, 🚀, 🔡, 📇 or nothingness.
+ * @warning GC-invoking
+ */
+static Something bridgeSQLiteColumnValue(int i, Thread *thread){
+    sqlite3_stmt *statement = goSqlite3_stmt(stackGetThis(thread));
+    switch (sqlite3_column_type(statement, i)) {
+        case SQLITE_INTEGER:
+            return somethingInteger((EmojicodeInteger)sqlite3_column_int64(statement, i));
+        case SQLITE_FLOAT:
+            return somethingDouble(sqlite3_column_double(statement, i));
+        case SQLITE_TEXT: {
+            const char *text = (const char *)sqlite3_column_text(statement, i);
+            if (!text) {
+                return NOTHINGNESS;
+            }
+            return somethingObject(stringFromUTF8(text, sqlite3_column_bytes(statement, i), thread));
+        }
+        case SQLITE_BLOB:
+            return bridgeSQLiteData(sqlite3_column_blob(statement, i), sqlite3_column_bytes(statement, i), thread);
+    }
+    return NOTHINGNESS;
 }
 
 static Something bridgeSQLiteStep(Thread *thread){
-    stackPush(NULL, 3, 0, thread);
+    stackPush(stackGetThis(thread), 3, 0, thread);
     
-    int colnamed = 0;
     stackSetVariable(0, somethingObject(newObject(CL_LIST)), thread);
-    stackSetVariable(1, somethingObject(newObject(CL_LIST)), thread);
+    stackSetVariable(1, somethingObject(bridgeSQLiteColumnNames(thread)), thread);
+    int columns = sqlite3_column_count(goSqlite3_stmt(stackGetThis(thread)));
     
-    while(sqlite3_step(goSqlite3_stmt(stackGetThis(thread))) == SQLITE_ROW){
+    while(bridgeSQLiteStepRow(goSqlite3_stmt(stackGetThis(thread)))){
         Object *dicto = newObject(CL_DICTIONARY);
         stackPush(dicto, 0, 0, thread);
         dictionaryInit(thread);
+        dictionaryReserve(stackGetThis(thread), columns, thread);
         dicto = stackGetThis(thread);
         stackPop(thread);
         stackSetVariable(2, somethingObject(dicto), thread);
         
-        int columns = sqlite3_column_count(goSqlite3_stmt(stackGetThis(thread)));
         for (int i = 0; i < columns; i++) {
-            if(colnamed == i){
-                colnamed++;
-                
-                const char *colname = sqlite3_column_name(goSqlite3_stmt(stackGetThis(thread)), i);
-            
-                if(colname == NULL){
-                    stackPop(thread);
-                    return NOTHINGNESS;
-                }
-            
-                listAppend(stackGetVariable(1, thread).object->value, somethingObject(stringFromChar(colname)), thread);
-            }
-                
-            Something sth = NOTHINGNESS;
-            switch(sqlite3_column_type(goSqlite3_stmt(stackGetThis(thread)), i)){
-                case SQLITE_INTEGER: {
-                    sth = somethingInteger(sqlite3_column_int(goSqlite3_stmt(stackGetThis(thread)), i));
-                    break;
-                }
-                case SQLITE_TEXT: {
-                    const char *text = (const char*)sqlite3_column_text(goSqlite3_stmt(stackGetThis(thread)), i);
-                    if(text != NULL){
-                        sth = somethingObject(stringFromChar(text));
-                    }
-                    break;
-                }
-                case SQLITE_BLOB: {
-                    const char *data = sqlite3_column_blob(goSqlite3_stmt(stackGetThis(thread)), i);
-                    if(data != NULL){
-                        int length = sqlite3_column_bytes(goSqlite3_stmt(stackGetThis(thread)), i);
-                        
-                        Object *bytesObject = newArray(length);
-                        memcpy(bytesObject->value, data, length);
-                        
-                        stackPush(bytesObject, 0, 0, thread);
-                        
-                        Object *obj = newObject(CL_DATA);
-                        Data *data = obj->value;
-                        data->length = length;
-                        data->bytesObject = stackGetThis(thread);
-                        data->bytes = data->bytesObject->value;
-                        
-                        stackPop(thread);
-
-                        sth = somethingObject(obj);
-                    }
-                    break;
-                }
-                case SQLITE_FLOAT: {
-                    sth = somethingInteger((EmojicodeInteger)(int)sqlite3_column_double(goSqlite3_stmt(stackGetThis(thread)), i));
-                    break;
-                }
-                // SQLITE_NULL: nothing to do
+            Something value = bridgeSQLiteColumnValue(i, thread);
+            if (isNothingness(value)) {
+                continue;
             }
-            
-            dictionarySet(stackGetVariable(2, thread).object->value, listGet(stackGetVariable(1, thread).object->value, i).object, sth, thread);
+            dictionarySet(stackGetVariable(2, thread).object,
+                          listGet(stackGetVariable(1, thread).object->value, i), value, thread);
         }
         
-        listAppend(stackGetVariable(0, thread).object->value, somethingObject(dicto), thread);
+        listAppend(stackGetVariable(0, thread).object, stackGetVariable(2, thread), thread);
     }
     Something sth = stackGetVariable(0, thread);
     stackPop(thread);
     return sth;
 }
 
-static void bridgeSQLiteFinalize(void *stmt){
-    sqlite3_finalize(stmt);
+//MARK: Cursor
+
+static Something bridgeSQLiteNextRow(Thread *thread){
+    SQLiteStatement *statement = stackGetThis(thread)->value;
+    if (statement->done) {
+        return EMOJICODE_FALSE;
+    }
+    if (bridgeSQLiteStepRow(statement->statement)) {
+        return EMOJICODE_TRUE;
+    }
+    //The GC might have moved the object while stepping
+    ((SQLiteStatement *)stackGetThis(thread)->value)->done = true;
+    return EMOJICODE_FALSE;
+}
+
+static Something bridgeSQLiteReset(Thread *thread){
+    SQLiteStatement *statement = stackGetThis(thread)->value;
+    if (!statement->statement) {
+        return NOTHINGNESS;
+    }
+    statement->done = false;
+    sqlite3_reset(statement->statement);
+    return NOTHINGNESS;
+}
+
+/**
+ * Hands the compiled statement back to the 📚 so that the next 💬 with the same SQL does not have to compile it
+ * again. The column names stay available, everything else behaves as if the query had no rows.
+ */
+static Something bridgeSQLiteFinish(Thread *thread){
+    SQLiteStatement *statement = stackGetThis(thread)->value;
+    if (statement->statement) {
+        connectionPutStatement(statement->connection, statement->statement);
+        statement->statement = NULL;
+    }
+    statement->done = true;
+    return NOTHINGNESS;
+}
+
+static Something bridgeSQLiteColumnCount(Thread *thread){
+    return somethingInteger((EmojicodeInteger)sqlite3_column_count(goSqlite3_stmt(stackGetThis(thread))));
+}
+
+static Something bridgeSQLiteColumnName(Thread *thread){
+    EmojicodeInteger i = unwrapInteger(stackGetVariable(0, thread));
+    return listGet(bridgeSQLiteColumnNames(thread)->value, i);
+}
+
+static Something bridgeSQLiteColumnIndex(Thread *thread){
+    List *names = bridgeSQLiteColumnNames(thread)->value;
+    String *name = stackGetVariable(0, thread).object->value;
+    for (size_t i = 0; i < names->count; i++) {
+        if (stringEqual(listItemAt(names, i).object->value, name)) {
+            return somethingInteger((EmojicodeInteger)i);
+        }
+    }
+    return NOTHINGNESS;
+}
+
+static Something bridgeSQLiteColumnInteger(Thread *thread){
+    int i = (int)unwrapInteger(stackGetVariable(0, thread));
+    return somethingInteger((EmojicodeInteger)sqlite3_column_int64(goSqlite3_stmt(stackGetThis(thread)), i));
+}
+
+static Something bridgeSQLiteColumnDouble(Thread *thread){
+    int i = (int)unwrapInteger(stackGetVariable(0, thread));
+    return somethingDouble(sqlite3_column_double(goSqlite3_stmt(stackGetThis(thread)), i));
+}
+
+static Something bridgeSQLiteColumnText(Thread *thread){
+    int i = (int)unwrapInteger(stackGetVariable(0, thread));
+    sqlite3_stmt *statement = goSqlite3_stmt(stackGetThis(thread));
+    const char *text = (const char *)sqlite3_column_text(statement, i);
+    if (!text) {
+        return NOTHINGNESS;
+    }
+    return somethingObject(stringFromUTF8(text, sqlite3_column_bytes(statement, i), thread));
+}
+
+static Something bridgeSQLiteColumnBlob(Thread *thread){
+    int i = (int)unwrapInteger(stackGetVariable(0, thread));
+    sqlite3_stmt *statement = goSqlite3_stmt(stackGetThis(thread));
+    if (sqlite3_column_type(statement, i) == SQLITE_NULL) {
+        return NOTHINGNESS;
+    }
+    return bridgeSQLiteData(sqlite3_column_blob(statement, i), sqlite3_column_bytes(statement, i), thread);
+}
+
+static Something bridgeSQLiteColumnIsNull(Thread *thread){
+    int i = (int)unwrapInteger(stackGetVariable(0, thread));
+    return sqlite3_column_type(goSqlite3_stmt(stackGetThis(thread)), i) == SQLITE_NULL ? EMOJICODE_TRUE : EMOJICODE_FALSE;
+}
+
+static void bridgeSQLiteStatementMark(Object *self){
+    SQLiteStatement *statement = self->value;
+    if (statement->columnNames) {
+        mark(&statement->columnNames);
+    }
+}
+
+static void bridgeSQLiteFinalize(void *value){
+    if (value) {
+        SQLiteStatement *statement = value;
+        if (statement->statement) {
+            connectionPutStatement(statement->connection, statement->statement);
+        }
+        pthread_mutex_lock(&statement->connection->mutex);
+        connectionRelease(statement->connection);
+    }
 }
 
 ClassMethodHandler handlerPointerForClassMethod(EmojicodeChar cl, EmojicodeChar symbol){
@@ -190,14 +548,42 @@ MethodHandler handlerPointerForMethod(EmojicodeChar cl, EmojicodeChar symbol){
                     return bridgeSQLiteLastError;
                 case 0x1F511:
                     return bridgeSQLiteLastInsertID;
+                case 0x267B: //♻️
+                    return bridgeSQLiteCacheHits;
             }
+            break;
         case 0x1F4AC:
             switch (symbol) {
                 case 0x1F4CD:
                     return bridgeSQLiteBindInteger;
                 case 0x1F53D:
                     return bridgeSQLiteStep;
+                case 0x1F69A: //🚚
+                    return bridgeSQLiteExecuteMany;
+                case 0x1F51C: //🔜
+                    return bridgeSQLiteNextRow;
+                case 0x1F504: //🔄
+                    return bridgeSQLiteReset;
+                case 0x1F5D1: //🗑
+                    return bridgeSQLiteFinish;
+                case 0x1F4CF: //📏
+                    return bridgeSQLiteColumnCount;
+                case 0x1F3F7: //🏷
+                    return bridgeSQLiteColumnName;
+                case 0x1F50D: //🔍
+                    return bridgeSQLiteColumnIndex;
+                case 0x1F682: //🚂
+                    return bridgeSQLiteColumnInteger;
+                case 0x1F680: //🚀
+                    return bridgeSQLiteColumnDouble;
+                case 0x1F521: //🔡
+                    return bridgeSQLiteColumnText;
+                case 0x1F4C7: //📇
+                    return bridgeSQLiteColumnBlob;
+                case 0x1F573: //🕳
+                    return bridgeSQLiteColumnIsNull;
             }
+            break;
     }
     return NULL;
 }
@@ -213,15 +599,18 @@ InitializerHandler handlerPointerForInitializer(EmojicodeChar cl, EmojicodeChar
 }
 
 Marker markerPointerForClass(EmojicodeChar cl){
+    if (cl == 0x1F4AC) {
+        return bridgeSQLiteStatementMark;
+    }
     return NULL;
 }
 
-uint_fast32_t sizeForClass(EmojicodeChar cl) {
-    switch (cl) {
+uint_fast32_t sizeForClass(Class *cl, EmojicodeChar name) {
+    switch (name) {
         case 0x1F4DA:
-            return sizeof(sqlite3*);
+            return sizeof(SQLiteConnection *);
         case 0x1F4AC:
-            return sizeof(sqlite3_stmt*);
+            return sizeof(SQLiteStatement);
     }
     return 0;
 }
@@ -234,4 +623,4 @@ Deinitializer deinitializerPointerForClass(EmojicodeChar cl){
             return bridgeSQLiteFinalize; //0x1F44B
     }
     return NULL;
-}
\ No newline at end of file
+}
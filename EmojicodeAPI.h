@@ -36,6 +36,7 @@ extern Class *CL_DICTIONARY;
 extern Class *CL_CAPTURED_METHOD_CALL;
 extern Class *CL_CLOSURE;
 extern Class *CL_RANGE;
+extern Class *CL_DICTIONARY_ENUMERATOR;
 
 typedef struct Object {
     /** The object’s class. */
@@ -101,14 +102,30 @@ extern bool isRealObject(Something sth);
 typedef struct String {
     /** The number of code points in @c characters. Strings are not null terminated! */
     EmojicodeInteger length;
-    /** The characters of this string. Strings are not null terminated! */
+    /**
+     * The characters of this string. Use the accessors in EmojicodeString.h to read them as their layout depends
+     * on @c compact. Strings are not null terminated!
+     */
     Object *characters;
+    /** The index of the first code point of this string in @c characters. Substrings share their parent’s array. */
+    EmojicodeInteger offset;
+    /**
+     * Whether @c characters stores every code point in one byte (Latin-1) instead of an @c EmojicodeChar.
+     * A string is compact if and only if all of its code points are smaller than 256.
+     */
+    bool compact;
+    /** The hash of the characters, computed on demand by @c dictionaryHash. 0 until computed. */
+    uint64_t hash;
 } String;
 
-typedef struct {
+typedef struct Data {
     EmojicodeInteger length;
+    /** The bytes, which are either the value of @c bytesObject or outside of the object heap. */
     char *bytes;
+    /** The array holding the bytes or NULL if they are outside of the object heap. */
     Object *bytesObject;
+    /** Releases bytes outside of the object heap when the 📇 is deallocated. May be NULL. */
+    void (*release)(struct Data *data);
 } Data;
 
 typedef struct {
@@ -184,6 +201,14 @@ extern bool instanceof(Object *object, Class *cl);
  * @warning This function will modify @c P to point to an exact copy of @c O after the function call.
  */
 extern void mark(Object **of);
+/**
+ * Marks the array @c A pointed to by the pointer @c P to which @c of points, but only retains @c size bytes
+ * starting at @c offset of its value area by copying them into a new array, unless @c A has already been marked.
+ * This allows to release a huge array of which only a small part is still used.
+ * @returns Whether the bytes were copied, in which case they now start at offset zero.
+ * @warning This function will modify @c P to point to the copy.
+ */
+extern bool markArraySlice(Object **of, size_t offset, size_t size);
 /**
  * If the calling thread needs to be paused for the GC to run, this function will first
  * unlock @c mutex if it is not a @c NULL pointer, then block until the GC cycle is complete
@@ -205,6 +230,21 @@ extern void allowGC();
  * See @c allowGC
  */
 extern void disallowGCAndPauseIfNeeded();
+/**
+ * Runs the given statements while the GC can run. Use this around every call that might block, like reading or
+ * writing files, waiting for processes or sleeping, as any other thread that needs to collect garbage waits until
+ * the calling thread allows it.
+ *
+ * @warning The statements must not access the object heap. Copy what they need, like a path or the bytes to write,
+ * out of the heap before and re-fetch all objects from the stack afterwards, as they might have been moved.
+ */
+#define allowingGC(...) do { allowGC(); __VA_ARGS__; disallowGCAndPauseIfNeeded(); } while (0)
+/**
+ * Collects garbage now, which calls the deinitializers of all unreachable objects. Use this if a resource that
+ * deinitializers release, for instance memory outside the object heap, runs out before the heap does.
+ * @warning GC-invoking
+ */
+extern void forceGC();
 
 //MARK: Stack
 
@@ -243,6 +283,26 @@ Object* stackGetThis(Thread *);
 Class* stackGetThisClass(Thread *thread);
 
 
+//MARK: Output
+
+/**
+ * The runtime buffers everything written to the standard output and the standard error. The standard output is
+ * flushed whenever the buffer is full, after every line if it is a terminal, and when the program exits.
+ * The standard error is flushed after every write. Writing is thread-safe. As writing might wait for another thread or
+ * block, the GC might run during the calls below, re-fetch all objects from the stack afterwards.
+ */
+typedef struct OutputBuffer OutputBuffer;
+
+extern OutputBuffer *standardOutput;
+extern OutputBuffer *standardError;
+
+/** Writes @c length bytes to @c output. */
+extern void outputWrite(OutputBuffer *output, const void *bytes, size_t length);
+/** Writes @c string encoded as UTF-8 to @c output and a line feed if @c newline is true. */
+extern void outputWriteString(OutputBuffer *output, String *string, bool newline);
+/** Writes everything @c output buffered to its file descriptor. */
+extern void outputFlush(OutputBuffer *output);
+
 //MARK: Packages
 
 typedef Something (*MethodHandler)(Thread *thread);
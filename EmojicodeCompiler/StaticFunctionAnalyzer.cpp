@@ -398,16 +398,19 @@ Type StaticFunctionAnalyzer::unsafeParseIdentifier(const Token *token) {
         case E_ICE_CREAM: {
             writer.writeCoin(0x51);
             
-            auto placeholder = writer.writeCoinsCountPlaceholderCoin();
+            // The Real-Time Engine allocates room for all elements at once
+            auto placeholder = writer.writeCoinPlaceholder();
+            EmojicodeCoin count = 0;
             
             CommonTypeFinder ct;
             
             const Token *aToken;
             while (aToken = consumeToken(), !(aToken->type == IDENTIFIER && aToken->value[0] == E_AUBERGINE)) {
                 ct.addType(parse(aToken, token), typeContext);
+                count++;
             }
             
-            placeholder.write();
+            placeholder.write(count);
             
             Type type = Type(CL_LIST);
             type.genericArguments[0] = ct.getCommonType(token);
@@ -416,21 +419,33 @@ Type StaticFunctionAnalyzer::unsafeParseIdentifier(const Token *token) {
         }
         case E_HONEY_POT: {
             writer.writeCoin(0x50);
-           
-            auto placeholder = writer.writeCoinsCountPlaceholderCoin();
+            
+            // The Real-Time Engine allocates room for all key-value pairs at once
+            auto placeholder = writer.writeCoinPlaceholder();
+            auto keyKindPlaceholder = writer.writeCoinPlaceholder();
+            EmojicodeCoin count = 0;
             
             CommonTypeFinder ct;
+            CommonTypeFinder keyCt;
             
             const Token *aToken;
             while (aToken = consumeToken(), !(aToken->type == IDENTIFIER && aToken->value[0] == E_AUBERGINE)) {
-                parse(aToken, token, Type(CL_STRING));
+                keyCt.addType(parse(aToken, token), typeContext);
                 ct.addType(parse(consumeToken(), token), typeContext);
+                count++;
             }
             
-            placeholder.write();
+            placeholder.write(count);
             
             Type type = Type(CL_DICTIONARY);
             type.genericArguments[0] = ct.getCommonType(token);
+            type.genericArguments[1] = count == 0 ? Type(CL_STRING) : keyCt.getCommonType(token);
+            
+            if (!type.genericArguments[1].canBeDictionaryKey(typeContext)) {
+                auto name = type.genericArguments[1].toString(typeContext, true);
+                compilerError(token, "%s cannot be used as 🍯 key. Use 🔡, 🚂, 🔣 or an object type.", name.c_str());
+            }
+            keyKindPlaceholder.write(type.genericArguments[1].dictionaryKeyKind());
             
             return type;
         }
@@ -502,11 +517,37 @@ Type StaticFunctionAnalyzer::unsafeParseIdentifier(const Token *token) {
             uint8_t vID = nextVariableID();
             writer.writeCoin(vID);
             
+            // 🔂 key value dictionary 🍇: A variable that is not followed by the block cannot be the iteratee
+            const Token *valueVariableToken = nullptr;
+            if (nextToken()->type == VARIABLE && nextToken()->nextToken != nullptr &&
+                !(nextToken()->nextToken->type == IDENTIFIER && nextToken()->nextToken->value[0] == E_GRAPES)) {
+                valueVariableToken = consumeToken(VARIABLE);
+                
+                if (scoper.currentScope()->getLocalVariable(valueVariableToken) != nullptr) {
+                    compilerError(valueVariableToken, "Cannot redeclare variable.");
+                }
+            }
+            
             Type iteratee = parse(consumeToken(), token, typeSomeobject);
             
             Type itemType = typeNothingness;
             
-            if (iteratee.type() == TT_CLASS && iteratee.eclass == CL_LIST) {
+            if (valueVariableToken && !(iteratee.type() == TT_CLASS && iteratee.eclass == CL_DICTIONARY)) {
+                compilerError(valueVariableToken, "Only a 🍯 can be enumerated with a key and a value variable.");
+            }
+            
+            if (iteratee.type() == TT_CLASS && iteratee.eclass == CL_DICTIONARY) {
+                // Dictionaries are enumerated by the Real-Time Engine without an enumerator object
+                placeholder.write(0x67);
+                writer.writeCoin(nextVariableID());  //Internally needed
+                uint8_t valueID = nextVariableID();
+                writer.writeCoin(valueID);
+                scoper.currentScope()->setLocalVariable(variableToken, new CompilerVariable(iteratee.genericArguments[1], vID, true, true, variableToken));
+                if (valueVariableToken) {
+                    scoper.currentScope()->setLocalVariable(valueVariableToken, new CompilerVariable(iteratee.genericArguments[0], valueID, true, true, valueVariableToken));
+                }
+            }
+            else if (iteratee.type() == TT_CLASS && iteratee.eclass == CL_LIST) {
                 // If the iteratee is a list, the Real-Time Engine has some special sugar
                 placeholder.write(0x65);
                 writer.writeCoin(nextVariableID());  //Internally needed
@@ -685,12 +726,24 @@ Type StaticFunctionAnalyzer::unsafeParseIdentifier(const Token *token) {
                 case TT_CLASS: {
                     auto offset = type.eclass->numberOfGenericArgumentsWithSuperArguments() - type.eclass->numberOfOwnGenericArguments();
                     for (size_t i = 0; i < type.eclass->numberOfOwnGenericArguments(); i++) {
+                        if (type.eclass == CL_DICTIONARY && i == 1) {
+                            // The Real-Time Engine checks the key kind the dictionary was created with
+                            if (type.genericArguments[i].dictionaryKeyKind() == DictionaryKeyOther) {
+                                compilerError(token, "Dynamic casts to 🍯 are only possible with 🔡, 🚂 or 🔣 keys.");
+                            }
+                            continue;
+                        }
                         if(!type.eclass->genericArgumentConstraints()[offset + i].compatibleTo(type.genericArguments[i], type) ||
                            !type.genericArguments[i].compatibleTo(type.eclass->genericArgumentConstraints()[offset + i], type)) {
                             compilerError(token, "Dynamic casts involving generic type arguments are not possible yet. Please specify the generic argument constraints of the class for compatibility with future versions.");
                         }
                     }
                     
+                    if (type.eclass == CL_DICTIONARY) {
+                        placeholder.write(0x49);
+                        writer.writeCoin(type.genericArguments[1].dictionaryKeyKind());
+                        break;
+                    }
                     placeholder.write(originalType.type() == TT_SOMETHING || originalType.optional() ? 0x44 : 0x40);
                     writer.writeCoin(type.eclass->index);
                     break;
@@ -851,12 +904,17 @@ Type StaticFunctionAnalyzer::unsafeParseIdentifier(const Token *token) {
             return method->returnType.resolveOn(tc);
         }
         case E_LARGE_BLUE_DIAMOND: {
-            writer.writeCoin(0x4);
-            
             TypeDynamism dynamism;
             Type type = Type::parseAndFetchType(typeContext, AllKindsOfDynamism, package, &dynamism)
             .typeConstraintForReference(typeContext);
             
+            if (type.type() == TT_CLASS && type.eclass == CL_DICTIONARY && !dynamism) {
+                // Sets the key kind of the new dictionary
+                writer.writeCoin(0x48);
+                writer.writeCoin(type.genericArguments[1].dictionaryKeyKind());
+            }
+            writer.writeCoin(0x4);
+            
             if (type.type() != TT_CLASS) {
                 compilerError(token, "The given type cannot be initiatied.");
             }
@@ -415,6 +415,17 @@ void Type::parseGenericArguments(TypeContext ct, TypeDynamism dynamism, Package
                 count++;
             }
             
+            if (eclass == CL_DICTIONARY && count == 1) {
+                // 🍯🐚Element is short for 🍯🐚Element🐚🔡
+                genericArguments.push_back(Type(CL_STRING));
+                count++;
+            }
+            else if (eclass == CL_DICTIONARY && count == 2 && !genericArguments[offset + 1].canBeDictionaryKey(ct)) {
+                auto name = genericArguments[offset + 1].toString(ct, true);
+                compilerError(errorToken, "%s cannot be used as 🍯 key. Use 🔡, 🚂, 🔣 or an object type.",
+                              name.c_str());
+            }
+            
             if (count != typeDef->numberOfOwnGenericArguments()) {
                 auto str = toString(typeNothingness, true);
                 compilerError(errorToken, "Type %s requires %d generic arguments, but %d were given.",
@@ -424,6 +435,42 @@ void Type::parseGenericArguments(TypeContext ct, TypeDynamism dynamism, Package
     }
 }
 
+bool Type::canBeDictionaryKey(TypeContext tc) const {
+    if (optional()) {
+        return false;
+    }
+    switch (type()) {
+        case TT_CLASS:
+        case TT_PROTOCOL:
+        case TT_SOMEOBJECT:
+        case TT_INTEGER:
+        case TT_SYMBOL:
+            return true;
+        case TT_REFERENCE:
+        case TT_LOCAL_REFERENCE:
+        case TT_SELF:
+            return typeConstraintForReference(tc).canBeDictionaryKey(tc);
+        default:
+            return false;
+    }
+}
+
+DictionaryKeyKind Type::dictionaryKeyKind() const {
+    if (optional()) {
+        return DictionaryKeyOther;
+    }
+    switch (type()) {
+        case TT_CLASS:
+            return eclass == CL_STRING ? DictionaryKeyString : DictionaryKeyOther;
+        case TT_INTEGER:
+            return DictionaryKeyInteger;
+        case TT_SYMBOL:
+            return DictionaryKeySymbol;
+        default:
+            return DictionaryKeyOther;
+    }
+}
+
 //MARK: Type Interferring
 
 void CommonTypeFinder::addType(Type t, TypeContext typeContext) {
@@ -102,6 +102,10 @@ public:
      * Mainly used to determine compatibility of generics.
      */
     bool identicalTo(Type to) const;
+    /** Whether values of this type can be used as keys of a 🍯: 🔡, 🚂, 🔣 and objects. */
+    bool canBeDictionaryKey(TypeContext tc) const;
+    /** The kind of this type as key of a 🍯, which is passed to the Real-Time Engine to check casts. */
+    DictionaryKeyKind dictionaryKeyKind() const;
     
     /** Called by @c parseAndFetchType and in the class parser. You usually should not call this method. */
     void parseGenericArguments(TypeContext tc, TypeDynamism dynamism, Package *package, const Token *errorToken);
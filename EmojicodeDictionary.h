@@ -11,66 +11,111 @@
 
 #include "EmojicodeString.h"
 
-/** Default initial capacity. MUST be a power of two, default: 8 */
+/** Default initial capacity of the index table. MUST be a power of two, default: 8 */
 #define DICTIONARY_DEFAULT_INITIAL_CAPACITY (1 << 3)
 
-/** Factor for determining whether the dictionary should be resized. */
+/** The maximum share of the index table slots that refer to entries. */
 #define DICTIONARY_DEFAULT_LOAD_FACTOR (0.75f)
 
 #define DICTIONARY_MAXIMUM_CAPACTIY (1 << 30)
 
-#define DICTIONARY_MAXIMUM_CAPACTIY_THRESHOLD (1 << 16)
-
 typedef uint64_t EmojicodeDictionaryHash;
 
-/** The datastructure with the key-value pair */
+/** A slot of the index table refers to an entry by its index or is one of these. */
+typedef int32_t EmojicodeDictionaryIndex;
+
+/** The index table slot has never been used. Probing stops here. */
+#define DICTIONARY_EMPTY ((EmojicodeDictionaryIndex)-1)
+
+/** The entry of the index table slot has been removed. Probing continues past it. */
+#define DICTIONARY_DELETED ((EmojicodeDictionaryIndex)-2)
+
+/** A key-value pair, which is stored inline in the entries array. */
 typedef struct {
-    /** The user specified key. */
-    Object *key;
-    
-    /** The user specified value. */
-    Something value;
-    
     /** The cached hash for the key. Calculated on item addition. */
     EmojicodeDictionaryHash hash;
     
-    /** EmojicodeDictionary stores a bucket's elements in a linked list. */
-    Object *next;
+    /** The user specified key. Nothingness if the entry was removed. */
+    Something key;
     
-} EmojicodeDictionaryNode;
+    /** The user specified value. */
+    Something value;
+} EmojicodeDictionaryEntry;
 
-/** Structure for the Emojicode standard Dictionary. The implementation is similar to Java's Hashmap. */
+/**
+ * Structure for the Emojicode standard Dictionary. The dictionary is a flat open addressing hash table: The entries
+ * are stored inline in one array in the order they were inserted. An index table, which is probed linearly, maps
+ * hashes to indices into the entries array.
+ */
 typedef struct {
-    /** An array with pointers to linked lists. Initializes when the first item is inserted. */
-    Object *buckets;
+    /** An array of @c capacity EmojicodeDictionaryIndex. @c NULL until the first item is inserted. */
+    Object *indices;
+    
+    /** An array with room for dictionaryEntriesCapacity(capacity) entries. */
+    Object *entries;
+    
+    /** Length of the index table. Always a power of two. */
+    size_t capacity;
     
-    /** Length of buckets array. */
-    size_t bucketsCounter;
+    /** The number of used entries including removed ones. New entries are appended after them. */
+    size_t entriesCount;
     
-    /** The number of items stored in this dictionary. Used for determining whether to resize. */
+    /** The number of items stored in this dictionary. */
     size_t size;
     
-    /** When size * loadFactor >= bucketsCounter the dictionary doubles the amount of buckets */
-    float loadFactor;
+    /**
+     * Whether an object other than a string was used as key. The hashes of such keys are derived from their
+     * addresses and must be recalculated after each garbage collection.
+     */
+    bool identityKeys;
     
-    /** Stores the next threshold for resizing. Is 0 until first resize when item is inserted. */
-    size_t nextThreshold;
+    /** The kind of the key type the dictionary was created with, a DictionaryKeyKind. */
+    uint8_t keyKind;
 } EmojicodeDictionary;
 
+/** Returns the number of entries a dictionary with an index table of length @c capacity can store. */
+#define dictionaryEntriesCapacity(capacity) ((size_t)((capacity) * DICTIONARY_DEFAULT_LOAD_FACTOR))
+
+/** Returns the entries array of the dictionary. Only valid if @c entries is not @c NULL. */
+#define dictionaryEntries(dict) ((EmojicodeDictionaryEntry *)(dict)->entries->value)
+
+/** The value area of 🔑, which enumerates the keys of a dictionary. */
+typedef struct {
+    /** The enumerated dictionary. */
+    Object *dictionary;
+    /** The index of the next entry to examine. */
+    size_t index;
+} EmojicodeDictionaryEnumerator;
+
+/**
+ * Returns the hash of @c key. Strings are hashed by their characters, integers and symbols by their value and all
+ * other objects by their identity.
+ */
+EmojicodeDictionaryHash dictionaryHash(Something key);
+
+/** Whether the two keys are equal. Strings are compared by their characters, other objects by identity. */
+bool dictionaryKeyEqual(Something key1, Something key2);
+
 /**
- * Insert an item and use keyString as key 
+ * Insert an item and use key as key
  * @warning GC-invoking
  */
-void dictionarySet(Object *dicto, Object *key, Something value, Thread *thread);
+void dictionarySet(Object *dicto, Something key, Something value, Thread *thread);
 
-/** Remove an item by keyString as key */
-void dictionaryRemove(EmojicodeDictionary *dict, Object *key, Thread *thread);
+/**
+ * Makes room for @c size items, so that inserting up to @c size items in total does not rebuild the dictionary.
+ * @warning GC-invoking
+ */
+void dictionaryReserve(Object *dicto, size_t size, Thread *thread);
 
-/** Get an item by keyString as key */
-Something dictionaryLookup(EmojicodeDictionary *dict, Object *key, Thread *thread);
+/** Remove an item by key */
+void dictionaryRemove(EmojicodeDictionary *dict, Something key, Thread *thread);
+
+/** Get an item by key */
+Something dictionaryLookup(EmojicodeDictionary *dict, Something key, Thread *thread);
 
 /** Check whether a key is in the dictionary */
-bool dictionaryContains(EmojicodeDictionary *dict, Object *key);
+bool dictionaryContains(EmojicodeDictionary *dict, Something key);
 
 /** 
  * Get all keys as a list
@@ -87,4 +132,8 @@ void dictionaryInit(Thread *thread);
 
 MethodHandler dictionaryMethodForName(EmojicodeChar name);
 
+void dictionaryEnumeratorMark(Object *enumerator);
+
+MethodHandler dictionaryEnumeratorMethodForName(EmojicodeChar name);
+
 #endif /* EmojicodeDictionary_h */
@@ -17,18 +17,88 @@ struct List {
     /** The capacity of the list. */
     size_t capacity;
     /**
-     * The array which stores the list items which has a size of @c capacity * sizeof(Something).
+     * The array which stores the list items which has a size of @c capacity * listItemSize(list).
      * Can be @c NULL if @c capacity is 0.
      */
     Object *items;
+    /**
+     * @c T_INTEGER, @c T_DOUBLE or @c T_BOOLEAN if all items are of this type and stored packed without their type,
+     * which also spares the GC from looking at them. @c T_OBJECT if the items are stored as Somethings.
+     * An empty list packs itself when an item is stored and unpacks as soon as an item of another type is stored.
+     * Use the accessors below to read the items.
+     */
+    Type packedType;
 };
 
+/** Returns the number of bytes every item of @c list takes up in @c items. */
+static inline size_t listItemSize(List *list){
+    switch (list->packedType) {
+        case T_INTEGER:
+            return sizeof(EmojicodeInteger);
+        case T_DOUBLE:
+            return sizeof(double);
+        case T_BOOLEAN:
+            return sizeof(bool);
+        default:
+            return sizeof(Something);
+    }
+}
+
+/** Returns a pointer to the item at @c index of @c list in its storage. */
+static inline void* listItemPointer(List *list, size_t index){
+    return (Byte *)list->items->value + index * listItemSize(list);
+}
+
+/** Returns the item at @c index, which must be smaller than @c list->count. */
+static inline Something listItemAt(List *list, size_t index){
+    void *items = list->items->value;
+    switch (list->packedType) {
+        case T_INTEGER:
+            return somethingInteger(((EmojicodeInteger *)items)[index]);
+        case T_DOUBLE:
+            return somethingDouble(((double *)items)[index]);
+        case T_BOOLEAN:
+            return somethingBoolean(((bool *)items)[index]);
+        default:
+            return ((Something *)items)[index];
+    }
+}
+
+/** Whether @c value can be stored in @c list without unpacking it. */
+static inline bool listCanStore(List *list, Something value){
+    return list->packedType == T_OBJECT || list->packedType == value.type;
+}
+
+/** Stores @c value at @c index, which must be smaller than @c list->capacity. @c value must fit: see listCanStore. */
+static inline void listSetItemAt(List *list, size_t index, Something value){
+    void *items = list->items->value;
+    switch (list->packedType) {
+        case T_INTEGER:
+            ((EmojicodeInteger *)items)[index] = value.raw;
+            break;
+        case T_DOUBLE:
+            ((double *)items)[index] = value.doubl;
+            break;
+        case T_BOOLEAN:
+            ((bool *)items)[index] = value.raw > 0;
+            break;
+        default:
+            ((Something *)items)[index] = value;
+    }
+}
+
 /** 
  * Inserts @c o at the end of the list. O(1) 
  * @warning GC-invoking
  */
 void listAppend(Object *lo, Something o, Thread *thread);
 
+/**
+ * Makes sure the list in this of the current stack frame can hold @c size items without growing.
+ * @warning GC-invoking
+ */
+void listEnsureCapacity(Thread *thread, size_t size);
+
 /** Removes the last element of the list and returns it. O(1) */
 Something listPop(List *list);
 
@@ -60,5 +130,7 @@ void listMark(Object *self);
 
 MethodHandler listMethodForName(EmojicodeChar method);
 InitializerHandler listInitializerForName(EmojicodeChar method);
+/** Returns the 🚄 class method that reduces a list of primitives, or @c NULL. */
+ClassMethodHandler listReductionForName(EmojicodeChar method);
 
 #endif /* EmojicodeList_h */
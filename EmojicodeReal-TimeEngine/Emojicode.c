@@ -16,6 +16,7 @@
 #include "EmojicodeList.h"
 #include "EmojicodeString.h"
 #include "EmojicodeDictionary.h"
+#include "StringKernels.h"
 #include "utf8.h"
 
 Class *CL_OBJECT = NULL;
@@ -27,6 +28,7 @@ Class *CL_DICTIONARY;
 Class *CL_CAPTURED_METHOD_CALL;
 Class *CL_CLOSURE;
 Class *CL_RANGE;
+Class *CL_DICTIONARY_ENUMERATOR;
 
 char **cliArguments;
 int cliArgumentCount;
@@ -50,12 +52,24 @@ _Noreturn void error(char *err, ...){
     char error[350];
     vsprintf(error, err, list);
     
+    outputFlushAtExit(standardOutput);
     fprintf(stderr, "🚨 Fatal Error: %s\n", error);
     
     va_end(list);
     exit(1);
 }
 
+#ifdef nativeBlockingLimit
+/** Calls a native function and reports it if it blocked the GC for too long. */
+#define runNative(handler, call) do {\
+    void *nativeCaller = nativeCallBegin((void *)(handler));\
+    call;\
+    nativeCallEnd(nativeCaller);\
+} while (0)
+#else
+#define runNative(handler, call) call
+#endif
+
 //MARK: Block utilities
 
 static void passBlock(Thread *thread){
@@ -144,7 +158,7 @@ Something executeCallableExtern(Object *callable, Something *args, Thread *threa
             Something *t = stackReserveFrame(object, method->argumentCount, thread);
             memcpy(t, args, method->argumentCount * sizeof(Something));
             stackPushReservedFrame(thread);
-            ret = method->handler(thread);
+            runNative(method->handler, ret = method->handler(thread));
         }
         else {
             Something *t = stackReserveFrame(object, method->variableCount, thread);
@@ -191,8 +205,9 @@ Something performInitializer(Class *class, Initializer *initializer, Object *obj
     
     if (initializer->native) {
         stackPush(object, initializer->argumentCount, initializer->argumentCount, thread);
-        initializer->handler(thread);
+        runNative(initializer->handler, initializer->handler(thread));
         
+        object = stackGetThis(thread);
         if(object->value == NULL){
             stackPop(thread);
             return NOTHINGNESS;
@@ -216,6 +231,7 @@ Something performInitializer(Class *class, Initializer *initializer, Object *obj
         }
         
         thread->tokenStream = preCoinStream;
+        object = stackGetThis(thread);
     }
     stackPop(thread);
 
@@ -226,7 +242,7 @@ Something performMethod(Method *method, Object *object, Thread *thread){
     Something ret;
     if (method->native) {
         stackPush(object, method->argumentCount, method->argumentCount, thread);
-        ret = method->handler(thread);
+        runNative(method->handler, ret = method->handler(thread));
     }
     else {
         stackPush(object, method->variableCount, method->argumentCount, thread);
@@ -248,7 +264,7 @@ Something performClassMethod(ClassMethod *method, Class *class, Thread *thread){
     Something ret;
     if (method->native) {
         stackPush(class, method->argumentCount, method->argumentCount, thread);
-        ret = method->handler(thread);
+        runNative(method->handler, ret = method->handler(thread));
     }
     else {
         stackPush(class, method->variableCount, method->argumentCount, thread);
@@ -529,32 +545,62 @@ Something parse(EmojicodeCoin coin, Thread *thread){
             
             return NOTHINGNESS;
         }
+        case 0x48: { //The dictionary being created has keys of the following kind
+            EmojicodeCoin keyKind = consumeCoin(thread);
+            Something sth = parse(consumeCoin(thread), thread);
+            ((EmojicodeDictionary *)sth.object->value)->keyKind = keyKind;
+            return sth;
+        }
+        case 0x49: {
+            Something sth = parse(consumeCoin(thread), thread);
+            EmojicodeCoin keyKind = consumeCoin(thread);
+            if(sth.type == T_OBJECT && !isNothingness(sth) && instanceof(sth.object, CL_DICTIONARY) &&
+               ((EmojicodeDictionary *)sth.object->value)->keyKind == keyKind){
+                return sth;
+            }
+            
+            return NOTHINGNESS;
+        }
         //MARK: Literals
         case 0x50: {
-            stackPush(newObject(CL_DICTIONARY), 0, 0, thread);
-            dictionaryInit(thread);
+            EmojicodeCoin count = consumeCoin(thread);
+            EmojicodeCoin keyKind = consumeCoin(thread);
+            Something *t = stackReserveFrame(NULL, 2, thread);
             
-            EmojicodeCoin *end = thread->tokenStream + consumeCoin(thread);
-            while (thread->tokenStream < end){
-                Object *key = parse(consumeCoin(thread), thread).object;
+            t[0] = somethingObject(newObject(CL_DICTIONARY));
+            ((EmojicodeDictionary *)t[0].object->value)->keyKind = keyKind;
+            dictionaryReserve(t[0].object, count, thread);
+            
+            for (EmojicodeCoin i = 0; i < count; i++) {
+                //The key must survive a garbage collection caused by the value
+                t[1] = parse(consumeCoin(thread), thread);
                 Something sth = parse(consumeCoin(thread), thread);
                 
-                dictionarySet(stackGetThis(thread), key, sth, thread);
+                dictionarySet(t[0].object, t[1], sth, thread);
             }
             
-            Object *dict = stackGetThis(thread);
+            Something sth = t[0];
+            
+            stackPushReservedFrame(thread);
             stackPop(thread);
             
-            return somethingObject(dict);
+            return sth;
         }
         case 0x51: {
+            EmojicodeCoin count = consumeCoin(thread);
             Something *t = stackReserveFrame(NULL, 1, thread);
             
             t[0] = somethingObject(newObject(CL_LIST));
+            if (count > 0) {
+                Object *items = newArray(sizeCalculationWithOverflowProtection(count, sizeof(Something)));
+                List *list = t[0].object->value;
+                list->items = items;
+                list->capacity = count;
+            }
             
-            EmojicodeCoin *end = thread->tokenStream + consumeCoin(thread);
-            while (thread->tokenStream < end){
-                listAppend(t[0].object, parse(consumeCoin(thread), thread), thread);
+            for (EmojicodeCoin i = 0; i < count; i++) {
+                Something item = parse(consumeCoin(thread), thread);
+                listAppend(t[0].object, item, thread);
             }
             
             Something sth = t[0];
@@ -569,12 +615,14 @@ Something parse(EmojicodeCoin coin, Thread *thread){
             Something *t = stackReserveFrame(NULL, stringCount + 1, thread);
             
             EmojicodeInteger length = 0;
+            bool compact = true;
             
             for (EmojicodeCoin i = 0; i < stringCount; i++) {
                 Something sm = parse(consumeCoin(thread), thread);
                 t[i] = sm;
                 String *string = sm.object->value;
                 length += string->length;
+                compact = compact && string->compact;
             }
             
             stackPushReservedFrame(thread);
@@ -583,23 +631,22 @@ Something parse(EmojicodeCoin coin, Thread *thread){
             
             stackSetVariable(stringCount, somethingObject(object), thread);
             
-            Object *characters = newArray(length * sizeof(EmojicodeChar));
-            EmojicodeChar *chars = characters->value;
-            EmojicodeChar *writeChars = chars;
+            Object *characters = newStringCharacters(length, compact);
             
             Something sm = stackGetVariable(stringCount, thread);
             String *string = sm.object->value;
+            string->length = length;
+            string->compact = compact;
+            string->characters = characters;
             
+            EmojicodeInteger at = 0;
             for (int i = 0; i < stringCount; i++) {
                 Object *o = stackGetVariable(i, thread).object;
-                String *string = o->value;
-                memcpy(writeChars, string->characters->value, string->length * sizeof(EmojicodeChar));
-                writeChars += string->length;
+                String *part = o->value;
+                stringCopyCharacters(string, at, part, 0, part->length);
+                at += part->length;
             }
             
-            string->length = length;
-            string->characters = characters;
-            
             stackPop(thread);
             
             return sm;
@@ -771,6 +818,36 @@ Something parse(EmojicodeCoin coin, Thread *thread){
             
             return NOTHINGNESS;
         }
+        case 0x67: { //MARK: foreach for dictionaries
+            //The destination variables
+            EmojicodeCoin keyVariable = consumeCoin(thread);
+            
+            Something dsm = parse(consumeCoin(thread), thread);
+            
+            EmojicodeCoin dictionaryObjectVariable = consumeCoin(thread);
+            EmojicodeCoin valueVariable = consumeCoin(thread);
+            stackSetVariable(dictionaryObjectVariable, dsm, thread);
+            EmojicodeDictionary *dict = dsm.object->value;
+            
+            EmojicodeCoin *begin = thread->tokenStream;
+            
+            for (size_t i = 0; i < (dict = stackGetVariable(dictionaryObjectVariable, thread).object->value)->entriesCount; i++) {
+                EmojicodeDictionaryEntry *entry = dictionaryEntries(dict) + i;
+                if (isNothingness(entry->key)) {
+                    continue;
+                }
+                stackSetVariable(keyVariable, entry->key, thread);
+                stackSetVariable(valueVariable, entry->value, thread);
+                
+                if(runBlock(thread)){
+                    return NOTHINGNESS;
+                }
+                thread->tokenStream = begin;
+            }
+            passBlock(thread);
+            
+            return NOTHINGNESS;
+        }
         case 0x70: {
             stackPush(stackGetThis(thread), 1, 0, thread);
             stackSetVariable(0, somethingObject(newObject(CL_CLOSURE)), thread);
@@ -785,14 +862,15 @@ Something parse(EmojicodeCoin coin, Thread *thread){
             
             EmojicodeCoin argumentCount = consumeCoin(thread);
             c->argumentCount = argumentCount;
-            
-            stackPop(thread);
-            
             c->capturedVariablesCount = consumeCoin(thread);
             
             Object *capturedVariables = newArray(sizeof(Something) * c->capturedVariablesCount);
+            co = stackGetVariable(0, thread).object;
+            c = co->value;
             c->capturedVariables = capturedVariables;
             
+            stackPop(thread);
+            
             Something *t = capturedVariables->value;
             for (uint_fast8_t i = 0; i < c->capturedVariablesCount; i++) {
                 t[i] = stackGetVariable(i, thread);
@@ -860,6 +938,8 @@ int main(int argc, char *argv[]) {
     Thread *mainThread = allocateThread();
     
     allocateHeap();
+    selectStringKernels();
+    outputInitialize();
     
     Class *cl;
     ClassMethod *flagMethod = readBytecode(f, &cl);
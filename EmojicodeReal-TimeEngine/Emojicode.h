@@ -35,6 +35,29 @@ Thread* allocateThread(void);
 /** Removes the thread from the linked list. */
 void removeThread(Thread *);
 
+/**
+ * A function run by @c runWorkers on every worker. @c index is the index of the worker and @c thread its thread, whose
+ * current stack frame retains the root given to @c runWorkers as this.
+ */
+typedef void (*WorkerFunction)(void *context, size_t index, Thread *thread);
+
+/**
+ * Returns how many workers should process @c items items if every worker should process at least
+ * @c minimumItemsPerWorker items. 1 means that the items should be processed on the calling thread.
+ */
+size_t workerCount(size_t items, size_t minimumItemsPerWorker);
+
+/**
+ * Runs @c function on @c count worker threads and blocks until all of them returned. If @c count is 1 @c function
+ * is run on @c thread instead.
+ *
+ * The workers are registered with the GC, which therefore waits for them to call @c pauseForGC. They must do so
+ * regularly, and must re-fetch every pointer into the heap from @c root afterwards. The calling thread allows the
+ * GC while it waits, so it must not hold such pointers across the call either.
+ * @warning GC-invoking
+ */
+void runWorkers(WorkerFunction function, void *context, size_t count, Object *root, Thread *thread);
+
 /** Marks all variables on the stack */
 void stackMark(Thread *);
 
@@ -44,6 +67,19 @@ void stackMark(Thread *);
  */
 void gc();
 
+#ifdef nativeBlockingLimit
+/*
+ * If the engine is compiled with nativeBlockingLimit, every native function that keeps the GC from running for longer
+ * than nativeBlockingLimit milliseconds, by neither allocating nor calling allowGC, is reported. Any other thread that
+ * needs to collect garbage meanwhile has to wait for it.
+ */
+
+/** Marks that the calling thread runs the native function @c handler. Returns the native function it ran before. */
+void* nativeCallBegin(void *handler);
+/** Marks that the native function returned and @c caller, as returned by @c nativeCallBegin, runs again. */
+void nativeCallEnd(void *caller);
+#endif
+
 struct Thread {
     EmojicodeCoin *tokenStream;
     Something returnValue;
@@ -80,6 +116,17 @@ Object **stringPool;
 /** Whether the given pointer points into the heap. */
 extern bool isPossibleObjectPointer(void *);
 
+//MARK: Output
+
+/** Sets up the output buffers and flushes them when the program exits. Call once at startup. */
+void outputInitialize(void);
+
+/** Writes every string in @c list on its own line to @c output, which is flushed at most once. */
+void outputWriteStringList(OutputBuffer *output, List *list);
+
+/** Flushes @c output like @c outputFlush but without allowing the GC, for when the program terminates. */
+void outputFlushAtExit(OutputBuffer *output);
+
 extern char **cliArguments;
 extern int cliArgumentCount;
 
@@ -6,316 +6,324 @@
 //  Copyright (c) 2015 Theo Weidmann. All rights reserved.
 //
 
-#include "EmojicodeAPI.h"
+#include "Emojicode.h"
 #include "EmojicodeDictionary.h"
 #include "EmojicodeString.h"
+#include "EmojicodeList.h"
 
-#define FNV_PRIME_64 1099511628211
-#define FNV_OFFSET_64 14695981039346656037U
-EmojicodeDictionaryHash fnv64(const char *k, size_t length) {
-    EmojicodeDictionaryHash hash = FNV_OFFSET_64;
-    for(size_t i = 0; i < length; i++){
-        hash = hash ^ k[i];
-        hash = hash * FNV_PRIME_64;
-    }
-    return hash;
+#include <string.h>
+
+/*
+ * wyhash by Wang Yi (public domain). It consumes 16 or 48 bytes per step and mixes them with a single
+ * 64 × 64 → 128 bit multiplication.
+ */
+
+static const uint64_t wySecret[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+/** Multiplies @c a and @c b and stores the lower half of the result in @c a and the upper half in @c b. */
+static inline void wyMultiply(uint64_t *a, uint64_t *b){
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32), c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
 }
 
-EmojicodeDictionaryHash dictionaryHash(EmojicodeDictionary *dict, Object *key) {
-    #define hashString(keyString) fnv64((char*)characters(keyString), ((keyString)->length) * sizeof(EmojicodeChar))
-    return hashString((String *) key->value);
+static inline uint64_t wyMix(uint64_t a, uint64_t b){
+    wyMultiply(&a, &b);
+    return a ^ b;
 }
 
-bool dictionaryKeyEqual(EmojicodeDictionary *dict, Object *key1, Object *key2) {
-    return stringEqual((String *) key1->value, (String *) key2->value);
+static inline uint64_t wyRead8(const uint8_t *p){
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
 }
 
-bool dictionaryKeyHashEqual(EmojicodeDictionary *dict, EmojicodeDictionaryHash hash1, EmojicodeDictionaryHash hash2, Object *key1, Object *key2) {
-    return (hash1 == hash2) && dictionaryKeyEqual(dict, key1, key2);
+static inline uint64_t wyRead4(const uint8_t *p){
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
 }
 
-// MARK: Internal dictionary
-EmojicodeDictionaryNode* dictionaryGetNode(EmojicodeDictionary *dict, EmojicodeDictionaryHash hash, Object *key) {
-    EmojicodeDictionaryNode *e;
-    Object** bucko;
-    size_t n = 0;
-    if (dict->buckets != NULL) {
-        bucko = (Object**) dict->buckets->value;
-        if ((n = dict->bucketsCounter) > 0) {
-            Object *firsto = bucko[hash & (n - 1)];
-            if (firsto != NULL) {
-                e = firsto->value;
-                if (dictionaryKeyHashEqual(dict, hash, e->hash, key, e->key)) {
-                    return e;
-                }
-                Object *eo;
-                while ((eo = e->next)) {
-                    e = eo->value;
-                    if (dictionaryKeyHashEqual(dict, hash, e->hash, key, e->key)) {
-                        return e;
-                    }
-                }
-            }
+/** Reads one to three bytes. */
+static inline uint64_t wyRead3(const uint8_t *p, size_t length){
+    return (((uint64_t)p[0]) << 16) | (((uint64_t)p[length >> 1]) << 8) | p[length - 1];
+}
+
+static EmojicodeDictionaryHash wyhash(const void *bytes, size_t length){
+    const uint8_t *p = bytes;
+    uint64_t seed = wyMix(wySecret[0], wySecret[1]);
+    uint64_t a, b;
+    
+    if (length <= 16) {
+        if (length >= 4) {
+            a = (wyRead4(p) << 32) | wyRead4(p + ((length >> 3) << 2));
+            b = (wyRead4(p + length - 4) << 32) | wyRead4(p + length - 4 - ((length >> 3) << 2));
+        }
+        else if (length > 0) {
+            a = wyRead3(p, length);
+            b = 0;
+        }
+        else {
+            a = b = 0;
         }
     }
-    return NULL;
+    else {
+        size_t i = length;
+        if (i > 48) {
+            uint64_t seed1 = seed, seed2 = seed;
+            do {
+                seed = wyMix(wyRead8(p) ^ wySecret[1], wyRead8(p + 8) ^ seed);
+                seed1 = wyMix(wyRead8(p + 16) ^ wySecret[2], wyRead8(p + 24) ^ seed1);
+                seed2 = wyMix(wyRead8(p + 32) ^ wySecret[3], wyRead8(p + 40) ^ seed2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (i > 16) {
+            seed = wyMix(wyRead8(p) ^ wySecret[1], wyRead8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wyRead8(p + i - 16);
+        b = wyRead8(p + i - 8);
+    }
+    
+    a ^= wySecret[1];
+    b ^= seed;
+    wyMultiply(&a, &b);
+    return wyMix(a ^ wySecret[0] ^ length, b ^ wySecret[1]);
 }
 
-/** @warning GC-Invoking */
-Object* dictionaryNewNode(Object **dicto, EmojicodeDictionaryHash hash, Object *key, Something value, Object *next, Thread *thread){
-    stackPush(*dicto, 0, 0, thread);
-    Object *nodeo = newArray(sizeof(EmojicodeDictionaryNode));
-    EmojicodeDictionaryNode *node = (EmojicodeDictionaryNode *) nodeo->value;
-    *dicto = stackGetThis(thread);
-    stackPop(thread);
-    
-    node->hash = hash;
-    node->key = key;
-    node->value = value;
-    node->next = next;
-    return nodeo;
+/** Whether the hash of @c key is derived from the address of an object, which the garbage collector changes. */
+static inline bool dictionaryIdentityKey(Something key) {
+    return key.type == T_OBJECT && key.object->class != CL_STRING;
 }
 
-/** @warning GC-Invoking */
-Object* dictionaryResize(Object *dicto, Thread *thread) {
-    EmojicodeDictionary *dict = dicto->value;
+EmojicodeDictionaryHash dictionaryHash(Something key) {
+    if (key.type != T_OBJECT) {
+        //Consecutive integers must not end up in consecutive slots of the index table
+        return wyMix((uint64_t)key.raw ^ wySecret[1], wySecret[0]);
+    }
+    if (dictionaryIdentityKey(key)) {
+        return wyMix((uint64_t)(uintptr_t)key.object ^ wySecret[2], wySecret[0]);
+    }
+    String *string = key.object->value;
+    //Strings are immutable and their representation is canonical, so the hash of the characters can be kept
+    if (string->hash == 0) {
+        EmojicodeDictionaryHash hash = wyhash(stringCharacters(string), string->length * stringCharacterSize(string));
+        string->hash = hash ? hash : 1;
+    }
+    return string->hash;
+}
 
-    Object *oldBuckoo = dict->buckets;
-    size_t oldCap = (oldBuckoo == NULL) ? 0 : dict->bucketsCounter;
-    size_t oldThr = dict->nextThreshold;
-    size_t newCap = oldCap << 1, newThr = 0;
-    
-    if (oldCap > 0) {
-        if (oldCap >= DICTIONARY_MAXIMUM_CAPACTIY) {
-            dict->nextThreshold = DICTIONARY_MAXIMUM_CAPACTIY_THRESHOLD;
-            return dicto;
+bool dictionaryKeyEqual(Something key1, Something key2) {
+    if (key1.type != key2.type) {
+        return false;
+    }
+    if (key1.type != T_OBJECT) {
+        return key1.raw == key2.raw;
+    }
+    if (key1.object == key2.object) {
+        return true;
+    }
+    if (key1.object->class == CL_STRING && key2.object->class == CL_STRING) {
+        return stringEqual((String *) key1.object->value, (String *) key2.object->value);
+    }
+    return false;
+}
+
+// MARK: Internal dictionary
+
+static inline EmojicodeDictionaryIndex* dictionaryIndices(EmojicodeDictionary *dict){
+    return dict->indices->value;
+}
+
+/**
+ * Returns the entry for @c key or @c NULL if the key is not in the dictionary. If @c slot is not @c NULL the index
+ * table slot referring to the entry is stored in it.
+ */
+static EmojicodeDictionaryEntry* dictionaryGetEntry(EmojicodeDictionary *dict, EmojicodeDictionaryHash hash,
+                                                    Something key, size_t *slot){
+    if (dict->capacity == 0) {
+        return NULL;
+    }
+    EmojicodeDictionaryIndex *indices = dictionaryIndices(dict);
+    EmojicodeDictionaryEntry *entries = dictionaryEntries(dict);
+    size_t mask = dict->capacity - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        EmojicodeDictionaryIndex index = indices[i];
+        if (index == DICTIONARY_EMPTY) {
+            return NULL;
         }
-        else if (newCap < DICTIONARY_MAXIMUM_CAPACTIY && oldCap >= DICTIONARY_DEFAULT_INITIAL_CAPACITY) {
-            newThr = oldThr << 1; // double threshold
+        if (index >= 0 && entries[index].hash == hash && dictionaryKeyEqual(key, entries[index].key)) {
+            if (slot) {
+                *slot = i;
+            }
+            return entries + index;
         }
     }
-    else if (oldThr > 0) { // initial capacity was placed in threshold
-        newCap = oldThr;
+}
+
+/** Stores @c index in the first free slot of the index table for @c hash. */
+static void dictionaryInsertIndex(EmojicodeDictionary *dict, EmojicodeDictionaryHash hash,
+                                  EmojicodeDictionaryIndex index){
+    EmojicodeDictionaryIndex *indices = dictionaryIndices(dict);
+    size_t mask = dict->capacity - 1;
+    size_t i = hash & mask;
+    while (indices[i] >= 0) {
+        i = (i + 1) & mask;
     }
-    else { // zero initial threshold signifies using defaults
-        newCap = DICTIONARY_DEFAULT_INITIAL_CAPACITY;
-        newThr = (size_t) (DICTIONARY_DEFAULT_LOAD_FACTOR * DICTIONARY_DEFAULT_INITIAL_CAPACITY);
+    indices[i] = index;
+}
+
+/**
+ * Rebuilds the dictionary in this of the current stack frame with room for at least @c size items. Removed entries
+ * are dropped, the order of the remaining entries is kept.
+ * @warning GC-Invoking
+ */
+static void dictionaryResize(size_t size, Thread *thread) {
+    size_t capacity = DICTIONARY_DEFAULT_INITIAL_CAPACITY;
+    while (dictionaryEntriesCapacity(capacity) < size && capacity < DICTIONARY_MAXIMUM_CAPACTIY) {
+        capacity <<= 1;
     }
-    
-    if (newThr == 0) {
-        float ft = (float) newCap * dict->loadFactor;
-        newThr = (newCap < DICTIONARY_MAXIMUM_CAPACTIY && ft < (float)DICTIONARY_MAXIMUM_CAPACTIY) ? (size_t)ft : DICTIONARY_MAXIMUM_CAPACTIY_THRESHOLD;
+    if (dictionaryEntriesCapacity(capacity) < size) {
+        error("Dictionary capacity exceeded.");
     }
     
-    stackPush(dicto, 0, 0, thread);
-    Object *newBuckoo = newArray(newCap * sizeof(Object *));
-    dicto = stackGetThis(thread);
-    dict = dicto->value;
+    stackPush(stackGetThis(thread), 1, 0, thread);
+    stackSetVariable(0, somethingObject(newArray(capacity * sizeof(EmojicodeDictionaryIndex))), thread);
+    Object *entrieso = newArray(dictionaryEntriesCapacity(capacity) * sizeof(EmojicodeDictionaryEntry));
+    Object *indiceso = stackGetVariable(0, thread).object;
+    EmojicodeDictionary *dict = stackGetThis(thread)->value;
     stackPop(thread);
     
-    dict->buckets = newBuckoo;
-    dict->nextThreshold = newThr;
-    dict->bucketsCounter = newCap;
-    
-    Object **newBucko = newBuckoo->value;
-    if (oldBuckoo != NULL) {
-        for (int j = 0; j < oldCap; ++j) {
-            Object **oldBucko = oldBuckoo->value;
-            Object *eo = oldBucko[j];
-            if (eo != NULL) {
-                EmojicodeDictionaryNode *e = eo->value;
-                oldBucko[j] = NULL;
-                if (e->next == NULL) {
-                    newBucko[e->hash & (newCap - 1)] = eo;
-                }
-                else { // preserve order
-                    Object *loHeado = NULL, *loTailo = NULL;
-                    Object *hiHeado = NULL, *hiTailo = NULL;
-                    Object *nexto;
-                    do {
-                        e = eo->value;
-                        nexto = e->next;
-                        if ((e->hash & oldCap) == 0) {
-                            if (loTailo == NULL) {
-                                loHeado = eo;
-                            }
-                            else {
-                                EmojicodeDictionaryNode *loTail = loTailo->value;
-                                loTail->next = eo;
-                            }
-                            loTailo = eo;
-                        }
-                        else {
-                            if (hiTailo == NULL) {
-                                hiHeado = eo;
-                            }
-                            else {
-                                EmojicodeDictionaryNode *hiTail = hiTailo->value;
-                                hiTail->next = eo;
-                            }
-                            hiTailo = eo;
-                        }
-                    } while ((eo = nexto) != NULL);
-                    
-                    if (loTailo != NULL) {
-                        EmojicodeDictionaryNode *loTail = loTailo->value;
-                        loTail->next = NULL;
-                        newBucko[j] = loHeado;
-                    }
-                    if(hiTailo != NULL) {
-                        EmojicodeDictionaryNode *hiTail = hiTailo->value;
-                        hiTail->next = NULL;
-                        newBucko[j + oldCap] = hiHeado;
-                    }
-                }
+    EmojicodeDictionaryEntry *entries = entrieso->value;
+    size_t count = 0;
+    if (dict->entries) {
+        EmojicodeDictionaryEntry *oldEntries = dictionaryEntries(dict);
+        for (size_t i = 0; i < dict->entriesCount; i++) {
+            if (!isNothingness(oldEntries[i].key)) {
+                entries[count++] = oldEntries[i];
             }
         }
     }
-    return dicto;
+    
+    dict->indices = indiceso;
+    dict->entries = entrieso;
+    dict->capacity = capacity;
+    dict->entriesCount = count;
+    memset(indiceso->value, 0xFF, capacity * sizeof(EmojicodeDictionaryIndex));  // DICTIONARY_EMPTY
+    for (size_t i = 0; i < count; i++) {
+        dictionaryInsertIndex(dict, entries[i].hash, (EmojicodeDictionaryIndex)i);
+    }
 }
 
-void dictionaryPutVal(Object *dicto, Object *key, Something value, Thread *thread) {
-    EmojicodeDictionaryHash hash = dictionaryHash(dicto->value, key);
+void dictionaryPutVal(Object *dicto, Something key, Something value, Thread *thread) {
+    EmojicodeDictionaryHash hash = dictionaryHash(key);
     
     EmojicodeDictionary *dict = dicto->value;
-    
-    if (dict->buckets == NULL || dict->bucketsCounter == 0) {
-        dicto = dictionaryResize(dicto, thread);
-        dict = dicto->value;
+    EmojicodeDictionaryEntry *entry = dictionaryGetEntry(dict, hash, key, NULL);
+    if (entry) { // existing mapping for key
+        entry->value = value;
+        return;
     }
     
-    Object **bucko;
-    size_t n = 0, i = 0;
-    bucko = dict->buckets->value;
-    n = dict->bucketsCounter;
-    
-    Object *po;
-    
-    if ((po = bucko[i = (hash & (n - 1))]) == NULL) {
-        bucko[i] = dictionaryNewNode(&dicto, hash, key, value, NULL, thread);
+    if (dict->entriesCount == dictionaryEntriesCapacity(dict->capacity)) {
+        stackPush(dicto, 2, 0, thread);
+        stackSetVariable(0, key, thread);
+        stackSetVariable(1, value, thread);
+        // Leave room for half as many items again, so that the table is not rebuilt again too soon
+        dictionaryResize(dict->size + 1 + (dict->size + 1) / 2, thread);
+        dicto = stackGetThis(thread);
+        key = stackGetVariable(0, thread);
+        value = stackGetVariable(1, thread);
+        stackPop(thread);
         dict = dicto->value;
-    }
-    else {
-        EmojicodeDictionaryNode *p = po->value;
-        Object *eo = NULL;
-        if (dictionaryKeyHashEqual(dict, hash, p->hash, key, p->key)) {
-            eo = po;
-        }
-        else {
-            for (int binCount = 0; ; ++binCount) {
-                if (p->next == NULL) {
-                    p->next = dictionaryNewNode(&dicto, hash, key, value, NULL, thread);
-                    dict = dicto->value;
-                    break;
-                }
-                EmojicodeDictionaryNode *e = p->next->value;
-                
-                if (dictionaryKeyHashEqual(dict, hash, e->hash, key, e->key)) {
-                    break;
-                }
-                p = e;
-            }
-        }
-        if (eo != NULL) { // existing mapping for key
-            EmojicodeDictionaryNode *e = eo->value;
-            e->value = value;
-            return;
+        if (dictionaryIdentityKey(key)) {
+            hash = dictionaryHash(key);
         }
     }
-    if(++(dict->size) > dict->nextThreshold) {
-        dicto = dictionaryResize(dicto, thread);
-        dict = dicto->value;
+    
+    EmojicodeDictionaryIndex index = (EmojicodeDictionaryIndex)dict->entriesCount++;
+    EmojicodeDictionaryEntry *entries = dictionaryEntries(dict);
+    entries[index].hash = hash;
+    entries[index].key = key;
+    entries[index].value = value;
+    dictionaryInsertIndex(dict, hash, index);
+    dict->size++;
+    if (dictionaryIdentityKey(key)) {
+        dict->identityKeys = true;
     }
 }
 
-EmojicodeDictionaryNode* dictionaryRemoveNode(EmojicodeDictionary *dict, EmojicodeDictionaryHash hash, Object *key, Thread *thread) {
-    size_t n = 0, index = 0;
-    if (dict->buckets != NULL && (n = dict->bucketsCounter) > 0) {
-        Object **bucko = dict->buckets->value;
-        Object *po = bucko[index = hash & (n - 1)];
-        if (po != NULL) {
-            EmojicodeDictionaryNode *p = po->value;
-            EmojicodeDictionaryNode *node = NULL;
-            if (dictionaryKeyHashEqual(dict, hash, p->hash, key, p->key)) {
-                node = p;
-            }
-            else {
-                Object *nexto = p->next;
-                while (nexto) {
-                    EmojicodeDictionaryNode *e = nexto->value;
-                    if (dictionaryKeyHashEqual(dict, hash, e->hash, key, e->key)) {
-                        node = e;
-                        break;
-                    }
-                    p = e;
-                    nexto = e->next;
-                }
-            }
-            if(node != NULL) {
-                if (node == p) {
-                    bucko[index] = node->next;
-                }
-                else {
-                    p->next = node->next;
-                }
-                dict->size--;
-                return node;
-            }
-        }
+// MARK: Bridge -> Dictionary interface
+void dictionaryReserve(Object *dicto, size_t size, Thread *thread) {
+    EmojicodeDictionary *dict = dicto->value;
+    if (size > dict->size && dict->entriesCount + (size - dict->size) > dictionaryEntriesCapacity(dict->capacity)) {
+        stackPush(dicto, 0, 0, thread);
+        dictionaryResize(size, thread);
+        stackPop(thread);
     }
-    return NULL;
 }
 
+void dictionaryRemove(EmojicodeDictionary *dict, Something key, Thread *thread) {
+    size_t slot;
+    EmojicodeDictionaryEntry *entry = dictionaryGetEntry(dict, dictionaryHash(key), key, &slot);
+    if (entry) {
+        dictionaryIndices(dict)[slot] = DICTIONARY_DELETED;
+        entry->key = NOTHINGNESS;
+        entry->value = NOTHINGNESS;
+        dict->size--;
+    }
+}
 
-// MARK: Bridge -> Dictionary interface
-void dictionaryRemove(EmojicodeDictionary *dict, Object *key, Thread *thread) {
-    dictionaryRemoveNode(dict, dictionaryHash(dict, key), key, thread);
+Something dictionaryLookup(EmojicodeDictionary *dict, Something key, Thread *thread) {
+    EmojicodeDictionaryEntry *entry = dictionaryGetEntry(dict, dictionaryHash(key), key, NULL);
+    return entry ? entry->value : NOTHINGNESS;
 }
 
-bool dictionaryContains(EmojicodeDictionary *dict, Object *key) {
-    return dictionaryGetNode(dict, dictionaryHash(dict, key), key) != NULL;
+bool dictionaryContains(EmojicodeDictionary *dict, Something key) {
+    return dictionaryGetEntry(dict, dictionaryHash(key), key, NULL) != NULL;
 }
 
 size_t dictionaryClear(EmojicodeDictionary *dict) {
     size_t sizeBefore = dict->size;
-    dict->loadFactor = DICTIONARY_DEFAULT_LOAD_FACTOR;
     dict->size = 0;
-    dict->buckets = NULL;
-    dict->nextThreshold = 0;
+    dict->indices = NULL;
+    dict->entries = NULL;
+    dict->capacity = 0;
+    dict->entriesCount = 0;
+    dict->identityKeys = false;
     return sizeBefore;
 }
 
 Something dictionaryKeys(Object *dicto, Thread *thread) {
-    stackPush(dicto, 2, 0, thread);
+    stackPush(dicto, 1, 0, thread);
     
-    {
-        Object *listObject = newObject(CL_LIST);
-        stackSetVariable(0, somethingObject(listObject), thread);
-        
-        dicto = stackGetThis(thread);
-        EmojicodeDictionary *dict = dicto->value;
-        
-        List *newList = listObject->value;
-        newList->capacity = dict->size;
-        Object *items = newArray(sizeof(Something) * dict->size);
-        ((List *)stackGetVariable(0, thread).object->value)->items = items;
-    }
+    Object *listObject = newObject(CL_LIST);
+    stackSetVariable(0, somethingObject(listObject), thread);
+    size_t size = ((EmojicodeDictionary *)stackGetThis(thread)->value)->size;
+    Object *items = newArray(sizeof(Something) * size);
     
-    dicto = stackGetThis(thread);
-    EmojicodeDictionary *dict = dicto->value;
+    List *list = stackGetVariable(0, thread).object->value;
+    list->items = items;
+    list->capacity = size;
     
-    for (size_t i = 0; i < dict->bucketsCounter; i++) {
-        Object **bucko = (Object **)dict->buckets->value;
-        Object *nodeo = bucko[i];
-        while (nodeo) {
-            stackSetVariable(1, somethingObject(nodeo), thread);
-            
-            listAppend(stackGetVariable(0, thread).object, somethingObject(((EmojicodeDictionaryNode *) nodeo->value)->key), thread);
-
-            nodeo = ((EmojicodeDictionaryNode *) stackGetVariable(1, thread).object->value)->next;
-            
-            dicto = stackGetThis(thread);
-            dict = dicto->value;
+    EmojicodeDictionary *dict = stackGetThis(thread)->value;
+    for (size_t i = 0; i < dict->entriesCount; i++) {
+        Something key = dictionaryEntries(dict)[i].key;
+        if (!isNothingness(key)) {
+            ((Something *)items->value)[list->count++] = key;
         }
     }
     
@@ -326,57 +334,59 @@ Something dictionaryKeys(Object *dicto, Thread *thread) {
 }
 
 void dictionaryInit(Thread *thread) {
-    EmojicodeDictionary *dict = stackGetThis(thread)->value;
-    dict->loadFactor = DICTIONARY_DEFAULT_LOAD_FACTOR;
+    //Nothing to do: The index table is allocated when the first item is inserted.
 }
 
 void dictionaryMark(Object *object) {
     EmojicodeDictionary *dict = object->value;
     
-    if(dict->buckets == NULL){
+    if(dict->indices == NULL){
         return;
     }
-    mark(&dict->buckets);
+    mark(&dict->indices);
+    mark(&dict->entries);
+    
+    EmojicodeDictionaryEntry *entries = dictionaryEntries(dict);
+    for (size_t i = 0; i < dict->entriesCount; i++) {
+        if (isRealObject(entries[i].key)) {
+            mark(&entries[i].key.object);
+        }
+        if (isRealObject(entries[i].value)){
+            mark(&entries[i].value.object);
+        }
+    }
     
-    Object **buckets = dict->buckets->value;
-    for (size_t i = 0; i < dict->bucketsCounter; i++) {
-        Object **eo = &buckets[i];
-        while (*(eo)) {
-            mark(eo);
-            EmojicodeDictionaryNode *e = (*eo)->value;
-            mark(&(e->key));
-            if (isRealObject(e->value)){
-                mark(&(e->value.object));
+    if (dict->identityKeys) {
+        //The keys have been moved, the index table is rebuilt with their new addresses
+        memset(dict->indices->value, 0xFF, dict->capacity * sizeof(EmojicodeDictionaryIndex));  // DICTIONARY_EMPTY
+        for (size_t i = 0; i < dict->entriesCount; i++) {
+            if (dictionaryIdentityKey(entries[i].key)) {
+                entries[i].hash = dictionaryHash(entries[i].key);
+            }
+            if (!isNothingness(entries[i].key)) {
+                dictionaryInsertIndex(dict, entries[i].hash, (EmojicodeDictionaryIndex)i);
             }
-            eo = &(e->next);
         }
     }
 }
 
-void dictionarySet(Object *dicto, Object *key, Something value, Thread *thread){
+void dictionarySet(Object *dicto, Something key, Something value, Thread *thread){
     dictionaryPutVal(dicto, key, value, thread);
 }
 
 //MARK: Bridges
 
 static Something bridgeDictionarySet(Thread *thread) {
-    dictionarySet(stackGetThis(thread), stackGetVariable(0, thread).object, stackGetVariable(1, thread), thread);
+    dictionarySet(stackGetThis(thread), stackGetVariable(0, thread), stackGetVariable(1, thread), thread);
     return NOTHINGNESS;
 }
 
 static Something bridgeDictionaryGet(Thread *thread) {
-    Object *key = stackGetVariable(0, thread).object;
-    EmojicodeDictionaryNode *node = dictionaryGetNode(stackGetThis(thread)->value, dictionaryHash(stackGetThis(thread)->value, key), key);
-    if(node == NULL){
-        return NOTHINGNESS;
-    }
-    else {
-        return node->value;
-    }
+    return dictionaryLookup(stackGetThis(thread)->value, stackGetVariable(0, thread), thread);
 }
 
 static Something bridgeDictionaryRemove(Thread *thread) {
-    dictionaryRemove(stackGetThis(thread)->value, stackGetVariable(0, thread).object, thread);
+    dictionaryRemove(stackGetThis(thread)->value, stackGetVariable(0, thread), thread);
     return NOTHINGNESS;
 }
 
@@ -389,14 +399,20 @@ static Something bridgeDictionaryClear(Thread *thread) {
 }
 
 static Something bridgeDictionaryContains(Thread *thread) {
-    Object *key = stackGetVariable(0, thread).object;
-    return somethingBoolean(dictionaryContains(stackGetThis(thread)->value, key));
+    return somethingBoolean(dictionaryContains(stackGetThis(thread)->value, stackGetVariable(0, thread)));
 }
 
 static Something bridgeDictionarySize(Thread *thread) {
     return somethingInteger(((EmojicodeDictionary *) stackGetThis(thread)->value)->size);
 }
 
+static Something bridgeDictionaryEnumerator(Thread *thread) {
+    Object *enumeratorObject = newObject(CL_DICTIONARY_ENUMERATOR);
+    EmojicodeDictionaryEnumerator *enumerator = enumeratorObject->value;
+    enumerator->dictionary = stackGetThis(thread);
+    return somethingObject(enumeratorObject);
+}
+
 void bridgeDictionaryInit(Thread *thread) {
     dictionaryInit(thread);
 }
@@ -417,6 +433,52 @@ MethodHandler dictionaryMethodForName(EmojicodeChar name) {
             return bridgeDictionaryContains;
         case 0x1F414: //🐔
             return bridgeDictionarySize;
+        case 0x1F361: //🍡
+            return bridgeDictionaryEnumerator;
+    }
+    return NULL;
+}
+
+//MARK: Enumerator
+
+/** Skips removed entries. Returns whether the enumerator points to an entry. */
+static bool dictionaryEnumeratorSkipRemoved(EmojicodeDictionaryEnumerator *enumerator) {
+    EmojicodeDictionary *dict = enumerator->dictionary->value;
+    while (enumerator->index < dict->entriesCount) {
+        if (!isNothingness(dictionaryEntries(dict)[enumerator->index].key)) {
+            return true;
+        }
+        enumerator->index++;
+    }
+    return false;
+}
+
+static Something bridgeDictionaryEnumeratorNext(Thread *thread) {
+    EmojicodeDictionaryEnumerator *enumerator = stackGetThis(thread)->value;
+    if (!dictionaryEnumeratorSkipRemoved(enumerator)) {
+        return NOTHINGNESS;
+    }
+    EmojicodeDictionary *dict = enumerator->dictionary->value;
+    return dictionaryEntries(dict)[enumerator->index++].key;
+}
+
+static Something bridgeDictionaryEnumeratorMoreComing(Thread *thread) {
+    return somethingBoolean(dictionaryEnumeratorSkipRemoved(stackGetThis(thread)->value));
+}
+
+void dictionaryEnumeratorMark(Object *object) {
+    EmojicodeDictionaryEnumerator *enumerator = object->value;
+    if (enumerator->dictionary) {
+        mark(&enumerator->dictionary);
+    }
+}
+
+MethodHandler dictionaryEnumeratorMethodForName(EmojicodeChar name) {
+    switch (name) {
+        case 0x1F53D: //🔽
+            return bridgeDictionaryEnumeratorNext;
+        case 0x2753: //❓
+            return bridgeDictionaryEnumeratorMoreComing;
     }
     return NULL;
 }
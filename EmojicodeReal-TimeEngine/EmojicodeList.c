@@ -6,25 +6,29 @@
 //  Copyright (c) 2015 Theo Weidmann. All rights reserved.
 //
 
+#include "Emojicode.h"
 #include "EmojicodeList.h"
 #include "EmojicodeString.h"
 
 #include <string.h>
+#include <stddef.h>
+#include <math.h>
 
+/** The items of a list that is not packed. */
 #define items(list) ((Something *)(list)->items->value)
 
 void expandListSize(Thread *thread){
 #define initialSize 7
     List *list = stackGetThis(thread)->value;
     if (list->capacity == 0) {
-        Object *object = newArray(sizeof(Something) * initialSize);
+        Object *object = newArray(listItemSize(list) * initialSize);
         list = stackGetThis(thread)->value;
         list->items = object;
         list->capacity = initialSize;
     }
     else {
         size_t newSize = list->capacity + (list->capacity >> 1);
-        Object *object = resizeArray(list->items, sizeCalculationWithOverflowProtection(newSize, sizeof(Something)));
+        Object *object = resizeArray(list->items, sizeCalculationWithOverflowProtection(newSize, listItemSize(list)));
         list = stackGetThis(thread)->value;
         list->items = object;
         list->capacity = newSize;
@@ -37,10 +41,10 @@ void listEnsureCapacity(Thread *thread, size_t size) {
     if (list->capacity < size) {
         Object *object;
         if (list->capacity == 0) {
-            object = newArray(sizeCalculationWithOverflowProtection(size, sizeof(Something)));
+            object = newArray(sizeCalculationWithOverflowProtection(size, listItemSize(list)));
         }
         else {
-            object = resizeArray(list->items, sizeCalculationWithOverflowProtection(size, sizeof(Something)));
+            object = resizeArray(list->items, sizeCalculationWithOverflowProtection(size, listItemSize(list)));
         }
         list = stackGetThis(thread)->value;
         list->items = object;
@@ -48,11 +52,53 @@ void listEnsureCapacity(Thread *thread, size_t size) {
     }
 }
 
+/**
+ * Converts the packed items of the list in this of the current stack frame into Somethings.
+ * @warning GC-invoking
+ */
+static void listUnpack(Thread *thread){
+    size_t capacity = ((List *)stackGetThis(thread)->value)->capacity;
+    Object *items = newArray(sizeCalculationWithOverflowProtection(capacity, sizeof(Something)));
+    List *list = stackGetThis(thread)->value;
+    for (size_t i = 0; i < list->count; i++) {
+        ((Something *)items->value)[i] = listItemAt(list, i);
+    }
+    list->items = items;
+    list->packedType = T_OBJECT;
+}
+
+/**
+ * Prepares the list in this of the current stack frame to store @c value. An empty list packs itself if @c value is
+ * a primitive that can be packed, a packed list that cannot store @c value is unpacked. Pass @c false for
+ * @c contiguous if the items between the last item and @c value will be nothingness.
+ * @warning GC-invoking
+ */
+static void listPrepareStorage(Something value, bool contiguous, Thread *thread){
+    List *list = stackGetThis(thread)->value;
+    Type type = T_OBJECT;
+    if (contiguous && (value.type == T_INTEGER || value.type == T_DOUBLE || value.type == T_BOOLEAN)) {
+        type = value.type;
+    }
+    
+    if (list->count == 0) {
+        // No item has to be converted, the array can simply be reinterpreted
+        size_t bytes = list->capacity * listItemSize(list);
+        list->packedType = type;
+        list->capacity = bytes / listItemSize(list);
+    }
+    else if (list->packedType != T_OBJECT && list->packedType != type) {
+        listUnpack(thread);
+    }
+}
+
 void listMark(Object *self){
     List *list = self->value;
     if (list->items) {
         mark(&list->items); 
     }
+    if (list->packedType != T_OBJECT) {
+        return;
+    }
     for (size_t i = 0; i < list->count; i++) {
         if(isRealObject(items(list)[i]))
            mark(&items(list)[i].object);
@@ -60,13 +106,15 @@ void listMark(Object *self){
 }
 
 void listAppend(Object *lo, Something o, Thread *thread){
-    stackPush(lo, 0, 0, thread);
-    List *list = lo->value;
+    stackPush(lo, 1, 0, thread);
+    stackSetVariable(0, o, thread);  // The GC might move o while the list is expanded
+    listPrepareStorage(o, true, thread);
+    List *list = stackGetThis(thread)->value;
     if (list->capacity - list->count == 0) {
         expandListSize(thread);
     }
     list = stackGetThis(thread)->value;
-    items(list)[list->count++] = o;
+    listSetItemAt(list, list->count++, stackGetVariable(0, thread));
     stackPop(thread);
 }
 
@@ -75,8 +123,10 @@ Something listPop(List *list){
         return NOTHINGNESS;
     }
     size_t index = --list->count;
-    Something v = items(list)[index];
-    items(list)[index] = NOTHINGNESS;
+    Something v = listItemAt(list, index);
+    if (list->packedType == T_OBJECT) {
+        items(list)[index] = NOTHINGNESS;
+    }
     return v;
 }
 
@@ -87,8 +137,12 @@ bool listRemoveByIndex(List *list, EmojicodeInteger index){
     if (index < 0 || list->count <= index){
         return false;
     }
-    memmove(items(list) + index, items(list) + index + 1, sizeof(Something) * (list->count - index - 1));
-    items(list)[--list->count] = NOTHINGNESS;
+    memmove(listItemPointer(list, index), listItemPointer(list, index + 1),
+            listItemSize(list) * (list->count - index - 1));
+    list->count--;
+    if (list->packedType == T_OBJECT) {
+        items(list)[list->count] = NOTHINGNESS;
+    }
     return true;
 }
 
@@ -99,19 +153,22 @@ Something listGet(List *list, EmojicodeInteger i){
     if (i < 0 || list->count <= i){
         return NOTHINGNESS;
     }
-    return items(list)[i];
+    return listItemAt(list, i);
 }
 
 Something listSet(EmojicodeInteger index, Something value, Thread *thread) {
-    List *list = stackGetThis(thread)->value;
+    stackPush(stackGetThis(thread), 1, 0, thread);
+    stackSetVariable(0, value, thread);
     
+    listPrepareStorage(value, index <= ((List *)stackGetThis(thread)->value)->count, thread);
     listEnsureCapacity(thread, index + 1);
-    list = stackGetThis(thread)->value;
+    List *list = stackGetThis(thread)->value;
     
     if (list->count <= index)
         list->count = index + 1;
     
-    items(list)[index] = value;
+    listSetItemAt(list, index, stackGetVariable(0, thread));
+    stackPop(thread);
     return NOTHINGNESS;
 }
 
@@ -121,9 +178,9 @@ void listShuffleInPlace(List *list) {
     
     for (i = n - 1; i > 0; i--) {
         j = secureRandomNumber(0, i);
-        tmp = items(list)[j];
-        items(list)[j] = items(list)[i];
-        items(list)[i] = tmp;
+        tmp = listItemAt(list, j);
+        listSetItemAt(list, j, listItemAt(list, i));
+        listSetItemAt(list, i, tmp);
     }
 }
 
@@ -161,61 +218,702 @@ static Something listInsertBridge(Thread *thread){
         return NOTHINGNESS;
     }
     
+    listPrepareStorage(stackGetVariable(1, thread), true, thread);
+    list = stackGetThis(thread)->value;
     if (list->capacity - list->count == 0) {
         expandListSize(thread);
     }
     
     list = stackGetThis(thread)->value;
     
-    memmove(items(list) + index + 1, items(list) + index, sizeof(Something) * (list->count++ - index));
-    items(list)[index] = stackGetVariable(1, thread);
+    memmove(listItemPointer(list, index + 1), listItemPointer(list, index),
+            listItemSize(list) * (list->count++ - index));
+    listSetItemAt(list, index, stackGetVariable(1, thread));
     
     return NOTHINGNESS;
 }
 
-static void listQSort(Thread *thread, size_t off, size_t n) {
-    if (n < 2)
-        return;
+/* MARK: Sorting */
+
+/** Runs up to this length are sorted by insertion sort before they are merged. */
+#define listSortRunLength 32
+
+/**
+ * Calls the comparator in variable 0 of the current stack frame with @c a and @c b.
+ * @warning GC-invoking. Re-fetch the items afterwards.
+ */
+static inline EmojicodeInteger listCompare(Something a, Something b, Thread *thread){
+    Something args[2] = {a, b};
+    return executeCallableExtern(stackGetVariable(0, thread).object, args, thread).raw;
+}
+
+/** The list being sorted, which is this of the current stack frame. */
+#define listSortList(thread) ((List *)stackGetThis(thread)->value)
+/** The buffer list in variable 1 of the current stack frame which holds the items currently being merged. */
+#define listSortBuffer(thread) ((List *)stackGetVariable(1, thread).object->value)
+
+/** Sorts the items from @c from up to @c to by binary insertion sort. */
+static void listInsertionSort(Thread *thread, size_t from, size_t to){
+    for (size_t i = from + 1; i < to; i++) {
+        size_t left = from, right = i;
+        while (left < right) {
+            size_t middle = left + (right - left) / 2;
+            List *list = listSortList(thread);
+            if (listCompare(listItemAt(list, i), listItemAt(list, middle), thread) < 0) {
+                right = middle;
+            }
+            else {
+                left = middle + 1;
+            }
+        }
+        List *list = listSortList(thread);
+        Something item = listItemAt(list, i);
+        memmove(listItemPointer(list, left + 1), listItemPointer(list, left), (i - left) * listItemSize(list));
+        listSetItemAt(list, left, item);
+    }
+}
+
+/**
+ * Merges the sorted runs from @c from up to @c middle and from @c middle up to @c to. The shorter run is moved into
+ * the buffer, so that every item is always either in the list or in the buffer and thus seen by the GC.
+ */
+static void listMerge(Thread *thread, size_t from, size_t middle, size_t to){
+    List *list = listSortList(thread);
+    if (listCompare(listItemAt(list, middle - 1), listItemAt(list, middle), thread) <= 0) {
+        return;  // The runs are already in order
+    }
     
-    Something *items = items((List *)stackGetThis(thread)->value) + off;
-    Something pivot = items[n / 2];
-    size_t i, j;
-    
-    for (i = 0, j = n - 1; ; i++, j--) {
-        while (true) {
-            Something args[2] = {items[i], pivot};
-            EmojicodeInteger c = executeCallableExtern(stackGetVariable(0, thread).object, args, thread).raw;
-            items = items((List *)stackGetThis(thread)->value) + off;
-            if (c >= 0) break;
-            i++;
+    list = listSortList(thread);
+    size_t size = listItemSize(list);
+    if (middle - from <= to - middle) {
+        size_t i = 0, j = middle, k = from, n = middle - from;
+        memcpy(listItemPointer(listSortBuffer(thread), 0), listItemPointer(list, from), n * size);
+        while (i < n && j < to) {
+            bool right = listCompare(listItemAt(listSortList(thread), j), listItemAt(listSortBuffer(thread), i),
+                                     thread) < 0;
+            list = listSortList(thread);
+            listSetItemAt(list, k++, right ? listItemAt(list, j++) : listItemAt(listSortBuffer(thread), i++));
+        }
+        memcpy(listItemPointer(listSortList(thread), k), listItemPointer(listSortBuffer(thread), i), (n - i) * size);
+    }
+    else {
+        size_t i = middle, j = to - middle, k = to;
+        memcpy(listItemPointer(listSortBuffer(thread), 0), listItemPointer(list, middle), j * size);
+        while (i > from && j > 0) {
+            bool left = listCompare(listItemAt(listSortBuffer(thread), j - 1), listItemAt(listSortList(thread), i - 1),
+                                    thread) < 0;
+            list = listSortList(thread);
+            listSetItemAt(list, --k, left ? listItemAt(list, --i) : listItemAt(listSortBuffer(thread), --j));
         }
+        memcpy(listItemPointer(listSortList(thread), from), listItemPointer(listSortBuffer(thread), 0), j * size);
+    }
+}
+
+/**
+ * Sorts the list with a stable merge sort: Runs of @c listSortRunLength items are sorted by insertion sort and then
+ * merged bottom-up. Merging two runs that are already in order costs only one comparison, so sorted and almost sorted
+ * lists are sorted in linear time. The sort needs no recursion and at most count / 2 items of extra space.
+ */
+static Something listSortBridge(Thread *thread) {
+    Something comparator = stackGetVariable(0, thread);
+    size_t count = ((List *)stackGetThis(thread)->value)->count;
+    if (count < 2) {
+        return NOTHINGNESS;
+    }
+    
+    stackPush(stackGetThis(thread), 2, 0, thread);
+    stackSetVariable(0, comparator, thread);
+    
+    for (size_t from = 0; from < count; from += listSortRunLength) {
+        listInsertionSort(thread, from, from + listSortRunLength < count ? from + listSortRunLength : count);
+    }
+    
+    if (count > listSortRunLength) {
+        // The buffer stores its items like the list
+        Object *buffer = newObject(CL_LIST);
+        stackSetVariable(1, somethingObject(buffer), thread);
+        Object *bufferItems = newArray(sizeCalculationWithOverflowProtection(count / 2, listItemSize(listSortList(thread))));
+        List *bufferList = listSortBuffer(thread);
+        bufferList->items = bufferItems;
+        bufferList->packedType = listSortList(thread)->packedType;
+        bufferList->capacity = bufferList->count = count / 2;
         
-        while (true) {
-            Something args[2] = {pivot, items[j]};
-            EmojicodeInteger c = executeCallableExtern(stackGetVariable(0, thread).object, args, thread).raw;
-            items = items((List *)stackGetThis(thread)->value) + off;
-            if (c >= 0) break;
-            j--;
+        for (size_t width = listSortRunLength; width < count; width *= 2) {
+            for (size_t from = 0; from + width < count; from += 2 * width) {
+                listMerge(thread, from, from + width, from + 2 * width < count ? from + 2 * width : count);
+            }
         }
+    }
+    
+    stackPop(thread);
+    return NOTHINGNESS;
+}
+
+/** The minimum number of keys every worker sorts. Smaller lists are sorted on the calling thread. */
+#ifndef listParallelSortMinimum
+#define listParallelSortMinimum 100000
+#endif
+
+typedef struct {
+    /** An unsigned integer whose order is the order of the keys. Unused for strings. */
+    uint64_t bits;
+    /** The index of the item the key belongs to, which is also the index of its key string. */
+    size_t index;
+} ListSortKey;
+
+typedef enum {
+    ListSortKeyInteger, ListSortKeyDouble, ListSortKeySymbol, ListSortKeyString
+} ListSortKeyType;
+
+typedef struct {
+    ListSortKey *keys;
+    /** A buffer as large as @c keys. */
+    ListSortKey *buffer;
+    size_t count;
+    bool strings;
+    /** The number of runs, which are sorted independently and then merged. */
+    size_t runs;
+    /** The number of runs already merged into one while merging. */
+    size_t width;
+} ListKeySort;
+
+/** The key strings, which are retained as this of the current stack frame of @c thread while sorting. */
+#define listSortStrings(thread) items((List *)stackGetThis(thread)->value)
+
+/** Returns an unsigned integer that orders like @c key. */
+static uint64_t listSortKeyBits(Something key, ListSortKeyType type){
+    switch (type) {
+        case ListSortKeyInteger:
+            return (uint64_t)key.raw ^ (UINT64_C(1) << 63);
+        case ListSortKeyDouble: {
+            uint64_t bits;
+            memcpy(&bits, &key.doubl, sizeof(bits));
+            // Negative doubles order reversed, so flip all their bits, and move the positive ones above them
+            return (bits >> 63) ? ~bits : bits | (UINT64_C(1) << 63);
+        }
+        default:
+            return (uint64_t)unwrapSymbol(key);
+    }
+}
+
+/** Whether key @c a orders before key @c b. @c strings are the key strings or @c NULL if the keys are bits. */
+static inline bool listSortKeyLess(ListSortKey a, ListSortKey b, Something *strings){
+    if (strings) {
+        return stringCompare(strings[a.index].object->value, strings[b.index].object->value) < 0;
+    }
+    return a.bits < b.bits;
+}
+
+/** Sorts @c keys by their bits with a stable LSD radix sort. Bytes that are equal in all keys are skipped. */
+static void listRadixSortKeys(ListSortKey *keys, ListSortKey *buffer, size_t count){
+    size_t (*histograms)[256] = calloc(8, sizeof(*histograms));
+    for (size_t i = 0; i < count; i++) {
+        for (int byte = 0; byte < 8; byte++) {
+            histograms[byte][(keys[i].bits >> (byte * 8)) & 0xFF]++;
+        }
+    }
+    
+    ListSortKey *source = keys, *destination = buffer;
+    for (int byte = 0; byte < 8; byte++) {
+        size_t *histogram = histograms[byte];
+        if (histogram[(keys[0].bits >> (byte * 8)) & 0xFF] == count) {
+            continue;
+        }
+        pauseForGC(NULL);
         
-        if (i >= j)
-            break;
+        size_t offset = 0;
+        for (int i = 0; i < 256; i++) {
+            size_t n = histogram[i];
+            histogram[i] = offset;
+            offset += n;
+        }
+        for (size_t i = 0; i < count; i++) {
+            destination[histogram[(source[i].bits >> (byte * 8)) & 0xFF]++] = source[i];
+        }
         
-        Something temp = items[i];
-        items[i] = items[j];
-        items[j] = temp;
+        ListSortKey *swap = source;
+        source = destination;
+        destination = swap;
+    }
+    
+    if (source != keys) {
+        memcpy(keys, source, count * sizeof(ListSortKey));
+    }
+    free(histograms);
+}
+
+/**
+ * Merges the sorted keys from @c from up to @c middle and from @c middle up to @c to. The keys from @c from up to
+ * @c middle are moved to the same place in @c buffer first.
+ */
+static void listMergeKeys(ListSortKey *keys, ListSortKey *buffer, size_t from, size_t middle, size_t to, bool strings,
+                          Thread *thread){
+    pauseForGC(NULL);
+    Something *s = strings ? listSortStrings(thread) : NULL;
+    if (!listSortKeyLess(keys[middle], keys[middle - 1], s)) {
+        return;  // The runs are already in order
+    }
+    
+    memcpy(buffer + from, keys + from, (middle - from) * sizeof(ListSortKey));
+    size_t i = from, j = middle, k = from;
+    while (i < middle && j < to) {
+        if ((k & 0xFFFF) == 0) {
+            pauseForGC(NULL);
+            s = strings ? listSortStrings(thread) : NULL;
+        }
+        keys[k++] = listSortKeyLess(keys[j], buffer[i], s) ? keys[j++] : buffer[i++];
+    }
+    memcpy(keys + k, buffer + i, (middle - i) * sizeof(ListSortKey));
+}
+
+/** Sorts @c keys by their strings with a stable merge sort. */
+static void listMergeSortStringKeys(ListSortKey *keys, ListSortKey *buffer, size_t count, Thread *thread){
+    if (count <= listSortRunLength) {
+        pauseForGC(NULL);
+        Something *strings = listSortStrings(thread);
+        for (size_t i = 1; i < count; i++) {
+            ListSortKey key = keys[i];
+            size_t j = i;
+            for (; j > 0 && listSortKeyLess(key, keys[j - 1], strings); j--) {
+                keys[j] = keys[j - 1];
+            }
+            keys[j] = key;
+        }
+        return;
     }
     
-    listQSort(thread, off, i);
-    listQSort(thread, off + i, n - i);
+    size_t half = count / 2;
+    listMergeSortStringKeys(keys, buffer, half, thread);
+    listMergeSortStringKeys(keys + half, buffer, count - half, thread);
+    listMergeKeys(keys, buffer, 0, half, count, true, thread);
+}
+
+/** Returns the index of the first key of run @c run. */
+static inline size_t listKeySortRunStart(ListKeySort *sort, size_t run){
+    if (run >= sort->runs) {
+        return sort->count;
+    }
+    return run * (sort->count / sort->runs);
+}
+
+static void listSortRunWorker(void *context, size_t index, Thread *thread){
+    ListKeySort *sort = context;
+    size_t from = listKeySortRunStart(sort, index);
+    size_t count = listKeySortRunStart(sort, index + 1) - from;
+    if (sort->strings) {
+        listMergeSortStringKeys(sort->keys + from, sort->buffer + from, count, thread);
+    }
+    else {
+        listRadixSortKeys(sort->keys + from, sort->buffer + from, count);
+    }
+}
+
+static void listMergeRunsWorker(void *context, size_t index, Thread *thread){
+    ListKeySort *sort = context;
+    size_t run = index * 2 * sort->width;
+    listMergeKeys(sort->keys, sort->buffer, listKeySortRunStart(sort, run), listKeySortRunStart(sort, run + sort->width),
+                  listKeySortRunStart(sort, run + 2 * sort->width), sort->strings, thread);
 }
 
-static Something listSort(Thread *thread) {
+/**
+ * Sorts the list by the keys the closure in variable 0 returns for its items. The closure is called exactly once for
+ * every item, the keys are then sorted natively without any further calls. Large lists are split into runs, which
+ * are sorted and then merged pairwise by workers.
+ */
+static void listSortByKey(Thread *thread, ListSortKeyType type){
+    Something callable = stackGetVariable(0, thread);
+    size_t count = ((List *)stackGetThis(thread)->value)->count;
+    if (count < 2) {
+        return;
+    }
+    
+    stackPush(stackGetThis(thread), 2, 0, thread);
+    stackSetVariable(0, callable, thread);
+    
+    if (type == ListSortKeyString) {
+        // The key strings must be retained until they are sorted
+        Object *strings = newObject(CL_LIST);
+        stackSetVariable(1, somethingObject(strings), thread);
+        Object *stringsItems = newArray(sizeCalculationWithOverflowProtection(count, sizeof(Something)));
+        List *stringsList = stackGetVariable(1, thread).object->value;
+        stringsList->items = stringsItems;
+        stringsList->capacity = count;
+    }
+    
+    ListSortKey *keys = malloc(sizeCalculationWithOverflowProtection(count, sizeof(ListSortKey)));
+    for (size_t i = 0; i < count; i++) {
+        Something args[1] = {listItemAt(stackGetThis(thread)->value, i)};
+        Something key = executeCallableExtern(stackGetVariable(0, thread).object, args, thread);
+        keys[i].index = i;
+        if (type == ListSortKeyString) {
+            List *stringsList = stackGetVariable(1, thread).object->value;
+            items(stringsList)[stringsList->count++] = key;
+        }
+        else {
+            keys[i].bits = listSortKeyBits(key, type);
+        }
+    }
+    
+    ListKeySort sort = {
+        .keys = keys, .buffer = malloc(count * sizeof(ListSortKey)), .count = count,
+        .strings = type == ListSortKeyString, .runs = workerCount(count, listParallelSortMinimum)
+    };
+    Object *root = sort.strings ? stackGetVariable(1, thread).object : NULL;
+    runWorkers(listSortRunWorker, &sort, sort.runs, root, thread);
+    for (sort.width = 1; sort.width < sort.runs; sort.width *= 2) {
+        root = sort.strings ? stackGetVariable(1, thread).object : NULL;
+        runWorkers(listMergeRunsWorker, &sort, (sort.runs + sort.width - 1) / (2 * sort.width), root, thread);
+    }
+    
     List *list = stackGetThis(thread)->value;
-    listQSort(thread, 0, list->count);
+    size_t size = listItemSize(list);
+    Byte *sorted = malloc(count * size);
+    for (size_t i = 0; i < count; i++) {
+        memcpy(sorted + i * size, listItemPointer(list, keys[i].index), size);
+    }
+    memcpy(listItemPointer(list, 0), sorted, count * size);
+    
+    free(sorted);
+    free(sort.buffer);
+    free(keys);
+    stackPop(thread);
+}
+
+static Something listSortByIntegerBridge(Thread *thread) {
+    listSortByKey(thread, ListSortKeyInteger);
+    return NOTHINGNESS;
+}
+
+static Something listSortByDoubleBridge(Thread *thread) {
+    listSortByKey(thread, ListSortKeyDouble);
     return NOTHINGNESS;
 }
 
+static Something listSortBySymbolBridge(Thread *thread) {
+    listSortByKey(thread, ListSortKeySymbol);
+    return NOTHINGNESS;
+}
+
+static Something listSortByStringBridge(Thread *thread) {
+    listSortByKey(thread, ListSortKeyString);
+    return NOTHINGNESS;
+}
+
+/* MARK: Reductions */
+
+/** The minimum number of items every worker reduces. Smaller lists are reduced on the calling thread. */
+#ifndef listParallelReduceMinimum
+#define listParallelReduceMinimum 250000
+#endif
+
+/** The number of items a worker reduces between two calls to @c pauseForGC. */
+#define listReduceBlockSize 65536
+
+typedef enum {
+    ListReduceIntegerSum, ListReduceIntegerMinimum, ListReduceIntegerMaximum, ListReduceIntegerCount,
+    ListReduceDoubleSum, ListReduceDoubleMinimum, ListReduceDoubleMaximum
+} ListReduceOperation;
+
+typedef struct {
+    ListReduceOperation operation;
+    size_t count;
+    size_t workers;
+    /** The integer to count. */
+    EmojicodeInteger value;
+    /** The result of every worker. */
+    Something *results;
+} ListReduce;
+
+/** Reads the integer at @c index from @c values whose items are @c stride bytes apart. */
+#define listReduceInteger(values, stride, index) (*(EmojicodeInteger *)((values) + (index) * (stride)))
+/** Reads the double at @c index from @c values whose items are @c stride bytes apart. */
+#define listReduceDouble(values, stride, index) (*(double *)((values) + (index) * (stride)))
+
+/**
+ * Reduces the values from @c from up to @c to into @c result. This function is inlined with a constant @c stride for
+ * packed and unpacked lists, so that the loops over packed lists can be vectorized.
+ */
+static inline Something listReduceBlock(ListReduce *reduce, const Byte *values, size_t stride, size_t from, size_t to,
+                                        Something result){
+    switch (reduce->operation) {
+        case ListReduceIntegerSum: {
+            // Overflows wrap around
+            uint64_t sum = (uint64_t)result.raw;
+            for (size_t i = from; i < to; i++) {
+                sum += (uint64_t)listReduceInteger(values, stride, i);
+            }
+            result.raw = (EmojicodeInteger)sum;
+            break;
+        }
+        case ListReduceIntegerMinimum:
+            for (size_t i = from; i < to; i++) {
+                EmojicodeInteger value = listReduceInteger(values, stride, i);
+                if (value < result.raw) result.raw = value;
+            }
+            break;
+        case ListReduceIntegerMaximum:
+            for (size_t i = from; i < to; i++) {
+                EmojicodeInteger value = listReduceInteger(values, stride, i);
+                if (value > result.raw) result.raw = value;
+            }
+            break;
+        case ListReduceIntegerCount:
+            for (size_t i = from; i < to; i++) {
+                result.raw += listReduceInteger(values, stride, i) == reduce->value;
+            }
+            break;
+        case ListReduceDoubleSum:
+            for (size_t i = from; i < to; i++) {
+                result.doubl += listReduceDouble(values, stride, i);
+            }
+            break;
+        case ListReduceDoubleMinimum:
+            for (size_t i = from; i < to; i++) {
+                result.doubl = fmin(result.doubl, listReduceDouble(values, stride, i));
+            }
+            break;
+        case ListReduceDoubleMaximum:
+            for (size_t i = from; i < to; i++) {
+                result.doubl = fmax(result.doubl, listReduceDouble(values, stride, i));
+            }
+            break;
+    }
+    return result;
+}
+
+static void listReduceWorker(void *context, size_t index, Thread *thread){
+    ListReduce *reduce = context;
+    size_t from = index * (reduce->count / reduce->workers);
+    size_t to = index + 1 == reduce->workers ? reduce->count : from + reduce->count / reduce->workers;
+    
+    pauseForGC(NULL);
+    // Sums and counts start at 0 in either representation
+    Something result = listItemAt(stackGetThis(thread)->value, from);
+    if (reduce->operation == ListReduceIntegerSum || reduce->operation == ListReduceIntegerCount ||
+        reduce->operation == ListReduceDoubleSum) {
+        result.raw = 0;
+    }
+    
+    for (size_t block = from; block < to; block += listReduceBlockSize) {
+        pauseForGC(NULL);
+        List *list = stackGetThis(thread)->value;
+        size_t end = block + listReduceBlockSize < to ? block + listReduceBlockSize : to;
+        if (list->packedType == T_OBJECT) {
+            const Byte *values = (Byte *)list->items->value + offsetof(Something, raw);
+            result = listReduceBlock(reduce, values, sizeof(Something), block, end, result);
+        }
+        else {
+            result = listReduceBlock(reduce, list->items->value, sizeof(EmojicodeInteger), block, end, result);
+        }
+    }
+    reduce->results[index] = result;
+}
+
+/**
+ * Reduces the list in variable 0 of the current stack frame. Large lists are split into parts, which are reduced by
+ * workers, whose results are then combined.
+ */
+static Something listReduce(Thread *thread, ListReduceOperation operation){
+    Object *listObject = stackGetVariable(0, thread).object;
+    ListReduce reduce = {operation, ((List *)listObject->value)->count};
+    if (operation == ListReduceIntegerCount) {
+        reduce.value = stackGetVariable(1, thread).raw;
+    }
+    
+    if (reduce.count == 0) {
+        switch (operation) {
+            case ListReduceIntegerSum:
+            case ListReduceIntegerCount:
+                return somethingInteger(0);
+            case ListReduceDoubleSum:
+                return somethingDouble(0.0);
+            default:
+                return NOTHINGNESS;
+        }
+    }
+    
+    reduce.workers = workerCount(reduce.count, listParallelReduceMinimum);
+    reduce.results = malloc(reduce.workers * sizeof(Something));
+    runWorkers(listReduceWorker, &reduce, reduce.workers, listObject, thread);
+    
+    Something result = reduce.results[0];
+    for (size_t i = 1; i < reduce.workers; i++) {
+        Something part = reduce.results[i];
+        switch (operation) {
+            case ListReduceIntegerSum:
+                result.raw = (EmojicodeInteger)((uint64_t)result.raw + (uint64_t)part.raw);
+                break;
+            case ListReduceIntegerMinimum:
+                if (part.raw < result.raw) result.raw = part.raw;
+                break;
+            case ListReduceIntegerMaximum:
+                if (part.raw > result.raw) result.raw = part.raw;
+                break;
+            case ListReduceIntegerCount:
+                result.raw += part.raw;
+                break;
+            case ListReduceDoubleSum:
+                result.doubl += part.doubl;
+                break;
+            case ListReduceDoubleMinimum:
+                result.doubl = fmin(result.doubl, part.doubl);
+                break;
+            case ListReduceDoubleMaximum:
+                result.doubl = fmax(result.doubl, part.doubl);
+                break;
+        }
+    }
+    free(reduce.results);
+    
+    if (operation >= ListReduceDoubleSum) {
+        return somethingDouble(result.doubl);
+    }
+    return somethingInteger(result.raw);
+}
+
+static Something listIntegerSumBridge(Thread *thread) {
+    return listReduce(thread, ListReduceIntegerSum);
+}
+
+static Something listIntegerMinimumBridge(Thread *thread) {
+    return listReduce(thread, ListReduceIntegerMinimum);
+}
+
+static Something listIntegerMaximumBridge(Thread *thread) {
+    return listReduce(thread, ListReduceIntegerMaximum);
+}
+
+static Something listIntegerCountBridge(Thread *thread) {
+    return listReduce(thread, ListReduceIntegerCount);
+}
+
+static Something listDoubleSumBridge(Thread *thread) {
+    return listReduce(thread, ListReduceDoubleSum);
+}
+
+static Something listDoubleMinimumBridge(Thread *thread) {
+    return listReduce(thread, ListReduceDoubleMinimum);
+}
+
+static Something listDoubleMaximumBridge(Thread *thread) {
+    return listReduce(thread, ListReduceDoubleMaximum);
+}
+
+/* MARK: Callbacks */
+
+/**
+ * Calls the callable in variable @c callable of the current stack frame with the item at @c index of this list.
+ * @warning GC-invoking. Re-fetch the items afterwards.
+ */
+static inline Something listCallWithItem(uint8_t callable, size_t index, Thread *thread){
+    Something item = listItemAt(stackGetThis(thread)->value, index);
+    return executeCallableExtern(stackGetVariable(callable, thread).object, &item, thread);
+}
+
+/** Whether @c index is still a valid index of this list, which the callback may have changed. */
+static inline bool listHasIndex(size_t index, Thread *thread){
+    return index < ((List *)stackGetThis(thread)->value)->count;
+}
+
+static Something listMapBridge(Thread *thread) {
+    Something callback = stackGetVariable(0, thread);
+    size_t count = ((List *)stackGetThis(thread)->value)->count;
+    
+    stackPush(stackGetThis(thread), 2, 0, thread);
+    stackSetVariable(0, callback, thread);
+    stackSetVariable(1, somethingObject(newObject(CL_LIST)), thread);
+    if (count > 0) {
+        Object *items = newArray(sizeCalculationWithOverflowProtection(count, sizeof(Something)));
+        List *mapped = stackGetVariable(1, thread).object->value;
+        mapped->items = items;
+        mapped->capacity = count;
+    }
+    
+    for (size_t i = 0; i < count && listHasIndex(i, thread); i++) {
+        Something value = listCallWithItem(0, i, thread);
+        listAppend(stackGetVariable(1, thread).object, value, thread);
+    }
+    
+    Something mapped = stackGetVariable(1, thread);
+    stackPop(thread);
+    return mapped;
+}
+
+static Something listFilterBridge(Thread *thread) {
+    Something callback = stackGetVariable(0, thread);
+    
+    stackPush(stackGetThis(thread), 2, 0, thread);
+    stackSetVariable(0, callback, thread);
+    stackSetVariable(1, somethingObject(newObject(CL_LIST)), thread);
+    
+    for (size_t i = 0; listHasIndex(i, thread); i++) {
+        if (listCallWithItem(0, i, thread).raw && listHasIndex(i, thread)) {
+            listAppend(stackGetVariable(1, thread).object, listItemAt(stackGetThis(thread)->value, i), thread);
+        }
+    }
+    
+    Something filtered = stackGetVariable(1, thread);
+    stackPop(thread);
+    return filtered;
+}
+
+static Something listAllBridge(Thread *thread) {
+    for (size_t i = 0; listHasIndex(i, thread); i++) {
+        if (!listCallWithItem(0, i, thread).raw) {
+            return EMOJICODE_FALSE;
+        }
+    }
+    return EMOJICODE_TRUE;
+}
+
+static Something listEqualBridge(Thread *thread) {
+    for (size_t i = 0; ; i++) {
+        List *list = stackGetThis(thread)->value;
+        List *other = stackGetVariable(0, thread).object->value;
+        if (list->count != other->count) {
+            return EMOJICODE_FALSE;
+        }
+        if (i == list->count) {
+            return EMOJICODE_TRUE;
+        }
+        
+        Something args[2] = {listItemAt(list, i), listItemAt(other, i)};
+        if (!executeCallableExtern(stackGetVariable(1, thread).object, args, thread).raw) {
+            return EMOJICODE_FALSE;
+        }
+    }
+}
+
+/**
+ * Folds the items from @c from on into the value in variable 0 of the current stack frame by calling the callable in
+ * variable 1 with the value and each item. The variable always holds the latest value so that the GC sees it.
+ */
+static Something listFold(size_t from, Thread *thread){
+    for (size_t i = from; listHasIndex(i, thread); i++) {
+        Something args[2] = {stackGetVariable(0, thread), listItemAt(stackGetThis(thread)->value, i)};
+        stackSetVariable(0, executeCallableExtern(stackGetVariable(1, thread).object, args, thread), thread);
+    }
+    return stackGetVariable(0, thread);
+}
+
+static Something listFoldBridge(Thread *thread) {
+    return listFold(0, thread);
+}
+
+static Something listReduceBridge(Thread *thread) {
+    if (!listHasIndex(0, thread)) {
+        return NOTHINGNESS;
+    }
+    
+    Something callback = stackGetVariable(0, thread);
+    stackPush(stackGetThis(thread), 2, 0, thread);
+    stackSetVariable(0, listItemAt(stackGetThis(thread)->value, 0), thread);
+    stackSetVariable(1, callback, thread);
+    Something result = listFold(1, thread);
+    stackPop(thread);
+    return result;
+}
+
 static Something listFromListBridge(Thread *thread) {
     Object *listO = newObject(CL_LIST);
     stackPush(stackGetThis(thread), 1, 0, thread);
@@ -226,21 +924,26 @@ static Something listFromListBridge(Thread *thread) {
     
     list->count = cpdList->count;
     list->capacity = cpdList->capacity;
+    list->packedType = cpdList->packedType;
     
-    Object *items = newArray(sizeof(Something) * cpdList->capacity);
+    Object *items = newArray(listItemSize(cpdList) * cpdList->capacity);
     listO = stackGetVariable(0, thread).object;
     list = listO->value;
     cpdList = stackGetThis(thread)->value;
     list->items = items;
     
-    memcpy(items(list), items(cpdList), cpdList->count * sizeof(Something));
+    if (cpdList->count > 0) {
+        memcpy(listItemPointer(list, 0), listItemPointer(cpdList, 0), cpdList->count * listItemSize(cpdList));
+    }
     stackPop(thread);
     return somethingObject(listO);
 }
 
 static Something listRemoveAllBridge(Thread *thread) {
     List *list = stackGetThis(thread)->value;
-    memset(items(list), 0, list->count);
+    if (list->items) {
+        memset(listItemPointer(list, 0), 0, list->count * listItemSize(list));
+    }
     list->count = 0;
     return NOTHINGNESS;
 }
@@ -291,7 +994,27 @@ MethodHandler listMethodForName(EmojicodeChar method) {
         case 0x1F42E: //🐮
             return listFromListBridge;
         case 0x1F981: //🦁
-            return listSort;
+            return listSortBridge;
+        case 0x1F405: //🐅
+            return listSortByIntegerBridge;
+        case 0x1F406: //🐆
+            return listSortByDoubleBridge;
+        case 0x1F403: //🐃
+            return listSortBySymbolBridge;
+        case 0x1F402: //🐂
+            return listSortByStringBridge;
+        case 0x1F430: //🐰
+            return listMapBridge;
+        case 0x1F42D: //🐭
+            return listFilterBridge;
+        case 0x1F42F: //🐯
+            return listAllBridge;
+        case 0x1F984: //🦄
+            return listEqualBridge;
+        case 0x1F41D: //🐝
+            return listFoldBridge;
+        case 0x1F41E: //🐞
+            return listReduceBridge;
         case 0x1f417: //🐗
             return listRemoveAllBridge;
         case 0x1f437: //🐷
@@ -302,6 +1025,26 @@ MethodHandler listMethodForName(EmojicodeChar method) {
     return NULL;
 }
 
+ClassMethodHandler listReductionForName(EmojicodeChar name) {
+    switch (name) {
+        case 0x1F4CA: //📊
+            return listIntegerSumBridge;
+        case 0x1F4C9: //📉
+            return listIntegerMinimumBridge;
+        case 0x1F4C8: //📈
+            return listIntegerMaximumBridge;
+        case 0x1F522: //🔢
+            return listIntegerCountBridge;
+        case 0x1F4B9: //💹
+            return listDoubleSumBridge;
+        case 0x23EC: //⏬
+            return listDoubleMinimumBridge;
+        case 0x23EB: //⏫
+            return listDoubleMaximumBridge;
+    }
+    return NULL;
+}
+
 InitializerHandler listInitializerForName(EmojicodeChar name){
     switch (name) {
         case 0x1F427: //🐧
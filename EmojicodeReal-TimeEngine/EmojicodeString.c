@@ -9,8 +9,217 @@
 #include "EmojicodeString.h"
 
 #include <string.h>
-#include "utf8.h"
 #include "EmojicodeList.h"
+#include "StringKernels.h"
+
+/**
+ * The size in bytes from which on the GC only retains the part of a characters array that is used, if a string
+ * only uses a small slice of the array.
+ */
+#ifndef stringSliceRetentionLimit
+#define stringSliceRetentionLimit (64 * 1024)
+#endif
+
+//MARK: Characters
+
+Object* newStringCharacters(EmojicodeInteger length, bool compact){
+    return newArray(compact ? length : sizeCalculationWithOverflowProtection(length, sizeof(EmojicodeChar)));
+}
+
+void stringCopyCharacters(String *destination, EmojicodeInteger at, String *source, EmojicodeInteger from, EmojicodeInteger length){
+    if (destination->compact == source->compact) {
+        size_t size = stringCharacterSize(source);
+        memcpy((Byte *)stringCharacters(destination) + at * size, (Byte *)stringCharacters(source) + from * size, length * size);
+        return;
+    }
+    
+    //A wide string is never copied into a compact string, so we only have to widen
+    stringKernels.widen((EmojicodeChar *)stringCharacters(destination) + at,
+                        (unsigned char *)stringCharacters(source) + from, length);
+}
+
+/** Whether the given range of @c string only contains code points that can be stored compactly. */
+static bool stringRangeIsCompact(String *string, EmojicodeInteger from, EmojicodeInteger length){
+    if (string->compact) {
+        return true;
+    }
+    
+    EmojicodeChar *chars = (EmojicodeChar *)stringCharacters(string) + from;
+    for (EmojicodeInteger i = 0; i < length; i++) {
+        if (chars[i] > 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Copies the range of the wide string @c source into the compact string @c destination. */
+static void stringNarrowCharacters(String *destination, String *source, EmojicodeInteger from, EmojicodeInteger length){
+    unsigned char *chars = (unsigned char *)stringCharacters(destination);
+    EmojicodeChar *sourceChars = (EmojicodeChar *)stringCharacters(source) + from;
+    for (EmojicodeInteger i = 0; i < length; i++) {
+        chars[i] = (unsigned char)sourceChars[i];
+    }
+}
+
+//MARK: UTF-8
+
+/**
+ * Decodes the multi-byte sequence at @c *i and advances @c *i past it. A byte that does not start a valid sequence
+ * is decoded as U+FFFD and @c *valid is set to false.
+ */
+static inline EmojicodeChar utf8DecodeSequence(const unsigned char *bytes, size_t size, size_t *i, bool *valid){
+    const unsigned char *b = bytes + *i;
+    size_t left = size - *i;
+    
+    if (0xC2 <= b[0] && b[0] <= 0xDF) {
+        if (left >= 2 && (b[1] & 0xC0) == 0x80) {
+            *i += 2;
+            return ((b[0] & 0x1F) << 6) | (b[1] & 0x3F);
+        }
+    }
+    else if (0xE0 <= b[0] && b[0] <= 0xEF) {
+        //Reject overlong encodings and surrogates
+        unsigned char min = b[0] == 0xE0 ? 0xA0 : 0x80, max = b[0] == 0xED ? 0x9F : 0xBF;
+        if (left >= 3 && min <= b[1] && b[1] <= max && (b[2] & 0xC0) == 0x80) {
+            *i += 3;
+            return ((b[0] & 0x0F) << 12) | ((b[1] & 0x3F) << 6) | (b[2] & 0x3F);
+        }
+    }
+    else if (0xF0 <= b[0] && b[0] <= 0xF4) {
+        //Reject overlong encodings and code points above U+10FFFF
+        unsigned char min = b[0] == 0xF0 ? 0x90 : 0x80, max = b[0] == 0xF4 ? 0x8F : 0xBF;
+        if (left >= 4 && min <= b[1] && b[1] <= max && (b[2] & 0xC0) == 0x80 && (b[3] & 0xC0) == 0x80) {
+            *i += 4;
+            return ((b[0] & 0x07) << 18) | ((b[1] & 0x3F) << 12) | ((b[2] & 0x3F) << 6) | (b[3] & 0x3F);
+        }
+    }
+    
+    *valid = false;
+    *i += 1;
+    return 0xFFFD;
+}
+
+EmojicodeInteger utf8Length(const char *bytes, size_t size, bool *compact, bool *valid){
+    const unsigned char *b = (const unsigned char *)bytes;
+    EmojicodeInteger length = 0;
+    *compact = true;
+    *valid = true;
+    
+    for (size_t i = 0; i < size;) {
+        size_t ascii = stringKernels.asciiLength(b + i, size - i);
+        i += ascii;
+        length += ascii;
+        if (i < size) {
+            if (utf8DecodeSequence(b, size, &i, valid) > 0xFF) {
+                *compact = false;
+            }
+            length++;
+        }
+    }
+    return length;
+}
+
+void stringDecodeUTF8(String *string, const char *bytes, size_t size){
+    const unsigned char *b = (const unsigned char *)bytes;
+    bool valid;
+    
+    if (string->compact) {
+        unsigned char *chars = stringCharacters(string);
+        for (size_t i = 0; i < size;) {
+            size_t ascii = stringKernels.asciiLength(b + i, size - i);
+            memcpy(chars, b + i, ascii);
+            chars += ascii;
+            i += ascii;
+            if (i < size) {
+                *chars++ = utf8DecodeSequence(b, size, &i, &valid);
+            }
+        }
+    }
+    else {
+        EmojicodeChar *chars = stringCharacters(string);
+        for (size_t i = 0; i < size;) {
+            size_t ascii = stringKernels.asciiLength(b + i, size - i);
+            stringKernels.widen(chars, b + i, ascii);
+            chars += ascii;
+            i += ascii;
+            if (i < size) {
+                *chars++ = utf8DecodeSequence(b, size, &i, &valid);
+            }
+        }
+    }
+}
+
+size_t stringUTF8Size(String *string){
+    size_t size = string->length;
+    if (string->compact) {
+        unsigned char *chars = stringCharacters(string);
+        for (EmojicodeInteger i = 0; i < string->length; i++) {
+            size += chars[i] >> 7;
+        }
+    }
+    else {
+        EmojicodeChar *chars = stringCharacters(string);
+        for (EmojicodeInteger i = 0; i < string->length; i++) {
+            size += (chars[i] >= 0x80) + (chars[i] >= 0x800) + (chars[i] >= 0x10000);
+        }
+    }
+    return size;
+}
+
+size_t stringEncodeUTF8(String *string, char *buffer){
+    unsigned char *b = (unsigned char *)buffer;
+    
+    if (string->compact) {
+        unsigned char *chars = stringCharacters(string);
+        for (size_t i = 0, length = string->length; i < length; i++) {
+            size_t ascii = stringKernels.asciiLength(chars + i, length - i);
+            memcpy(b, chars + i, ascii);
+            b += ascii;
+            i += ascii;
+            if (i < length) {
+                *b++ = 0xC0 | (chars[i] >> 6);
+                *b++ = 0x80 | (chars[i] & 0x3F);
+            }
+        }
+    }
+    else {
+        EmojicodeChar *chars = stringCharacters(string);
+        for (size_t i = 0, length = string->length; i < length; i++) {
+            size_t ascii = stringKernels.narrowASCII(b, chars + i, length - i);
+            b += ascii;
+            i += ascii;
+            if (i == length) {
+                break;
+            }
+            
+            EmojicodeChar c = chars[i];
+            if (c < 0x800) {
+                *b++ = 0xC0 | (c >> 6);
+            }
+            else if (c < 0x10000) {
+                *b++ = 0xE0 | (c >> 12);
+                *b++ = 0x80 | ((c >> 6) & 0x3F);
+            }
+            else {
+                *b++ = 0xF0 | (c >> 18);
+                *b++ = 0x80 | ((c >> 12) & 0x3F);
+                *b++ = 0x80 | ((c >> 6) & 0x3F);
+            }
+            *b++ = 0x80 | (c & 0x3F);
+        }
+    }
+    return (char *)b - buffer;
+}
+
+size_t stringToUTF8Buffer(String *string, char *buffer, size_t size){
+    size_t utf8Size = stringUTF8Size(string);
+    if (utf8Size < size) {
+        stringEncodeUTF8(string, buffer);
+        buffer[utf8Size] = 0;
+    }
+    return utf8Size;
+}
 
 EmojicodeInteger stringCompare(String *a, String *b) {
     if (a == b) {
@@ -19,12 +228,93 @@ EmojicodeInteger stringCompare(String *a, String *b) {
     if (a->length != b->length) {
         return a->length - b->length;
     }
+    if (a->compact && b->compact) {
+        return memcmp(stringCharacters(a), stringCharacters(b), a->length);
+    }
     
-    return memcmp(a->characters->value, b->characters->value, a->length * sizeof(EmojicodeChar));
+    for (EmojicodeInteger i = 0; i < a->length; i++) {
+        EmojicodeChar ca = stringCharacterAt(a, i), cb = stringCharacterAt(b, i);
+        if (ca != cb) {
+            return ca < cb ? -1 : 1;
+        }
+    }
+    return 0;
 }
 
 bool stringEqual(String *a, String *b){
-    return stringCompare(a, b) == 0;
+    if (a->length != b->length || a->compact != b->compact || (a->hash && b->hash && a->hash != b->hash)) {
+        return false;
+    }
+    return a == b || memcmp(stringCharacters(a), stringCharacters(b), a->length * stringCharacterSize(a)) == 0;
+}
+
+/** Whether the @c length code points of @c a starting at @c from equal the code points of @c b. */
+static bool stringRangeEqual(String *a, EmojicodeInteger from, String *b){
+    if (a->compact == b->compact) {
+        size_t size = stringCharacterSize(a);
+        return memcmp((Byte *)stringCharacters(a) + from * size, stringCharacters(b), b->length * size) == 0;
+    }
+    if (a->compact) {
+        //b is not compact and contains at least one code point a cannot contain
+        return false;
+    }
+    
+    for (EmojicodeInteger i = 0; i < b->length; i++) {
+        if (stringCharacterAt(a, from + i) != stringCharacterAt(b, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Returns the index of the first occurrence of @c c in @c string at or after @c from or -1. */
+static EmojicodeInteger stringFindCharacter(String *string, EmojicodeInteger from, EmojicodeChar c){
+    EmojicodeInteger index;
+    if (string->compact) {
+        if (c > 0xFF) {
+            return -1;
+        }
+        index = stringKernels.findCharacterCompact((unsigned char *)stringCharacters(string) + from,
+                                                   string->length - from, (unsigned char)c);
+    }
+    else {
+        index = stringKernels.findCharacterWide((EmojicodeChar *)stringCharacters(string) + from, string->length - from, c);
+    }
+    return index < 0 ? index : from + index;
+}
+
+/** Returns the index of the first occurrence of @c search in @c string at or after @c from or -1. */
+static EmojicodeInteger stringFind(String *string, EmojicodeInteger from, String *search){
+    if (search->length == 0) {
+        return from <= string->length ? from : -1;
+    }
+    if (search->length > string->length - from) {
+        return -1;
+    }
+    
+    EmojicodeInteger index;
+    if (string->compact) {
+        if (!search->compact) {
+            //search contains at least one code point string cannot contain
+            return -1;
+        }
+        index = stringKernels.findCompact((unsigned char *)stringCharacters(string) + from, string->length - from,
+                                          stringCharacters(search), search->length);
+    }
+    else if (!search->compact) {
+        index = stringKernels.findWide((EmojicodeChar *)stringCharacters(string) + from, string->length - from,
+                                       stringCharacters(search), search->length);
+    }
+    else {
+        EmojicodeChar *wide = malloc(search->length * sizeof(EmojicodeChar));
+        for (EmojicodeInteger i = 0; i < search->length; i++) {
+            wide[i] = stringCharacterAt(search, i);
+        }
+        index = stringKernels.findWide((EmojicodeChar *)stringCharacters(string) + from, string->length - from,
+                                       wide, search->length);
+        free(wide);
+    }
+    return index < 0 ? index : from + index;
 }
 
 bool stringBeginsWith(String *a, String *with){
@@ -32,7 +322,7 @@ bool stringBeginsWith(String *a, String *with){
         return false;
     }
     
-    return memcmp(a->characters->value, with->characters->value, with->length * sizeof(EmojicodeChar)) == 0;
+    return stringRangeEqual(a, 0, with);
 }
 
 bool stringEndsWith(String *a, String *end){
@@ -40,12 +330,18 @@ bool stringEndsWith(String *a, String *end){
         return false;
     }
     
-    return memcmp(((EmojicodeChar*)a->characters->value) + (a->length - end->length), end->characters->value, end->length * sizeof(EmojicodeChar)) == 0;
+    return stringRangeEqual(a, a->length - end->length, end);
 }
 
-/** @warning GC-invoking */
+/**
+ * Returns a string which shares the characters of @c stro, unless @c stro is not compact and the range only
+ * contains code points that can be stored compactly. In that case the code points are copied as strings must
+ * always be stored compactly if possible.
+ * @warning GC-invoking
+ */
 Object* stringSubstring(Object *stro, EmojicodeInteger from, EmojicodeInteger length, Thread *thread){
     stackPush(stro, 1, 0, thread);
+    bool copy;
     {
         String *string = stackGetThis(thread)->value;
         if (from >= string->length){
@@ -61,50 +357,102 @@ Object* stringSubstring(Object *stro, EmojicodeInteger from, EmojicodeInteger le
             stackPop(thread);
             return emptyString;
         }
+        if (from == 0 && length == string->length) {
+            stackPop(thread);
+            return stro;
+        }
+        
+        copy = !string->compact && stringRangeIsCompact(string, from, length);
     }
     
     stackSetVariable(0, somethingObject(newObject(CL_STRING)), thread);
-    Object *co = newArray(length * sizeof(EmojicodeChar));
-    
-    Object *ostro = stackGetVariable(0, thread).object;
-    String *ostr = ostro->value;
-    
-    ostr->length = length;
-    ostr->characters = co;
     
-    memcpy(ostr->characters->value, characters((String *)stackGetThis(thread)->value) + from, length * sizeof(EmojicodeChar));
+    if (copy) {
+        Object *co = newStringCharacters(length, true);
+        
+        String *ostr = stackGetVariable(0, thread).object->value;
+        ostr->length = length;
+        ostr->characters = co;
+        ostr->compact = true;
+        
+        stringNarrowCharacters(ostr, stackGetThis(thread)->value, from, length);
+    }
+    else {
+        String *ostr = stackGetVariable(0, thread).object->value;
+        String *string = stackGetThis(thread)->value;
+        ostr->length = length;
+        ostr->characters = string->characters;
+        ostr->offset = string->offset + from;
+        ostr->compact = string->compact;
+    }
     
+    Object *ostro = stackGetVariable(0, thread).object;
     stackPop(thread);
     return ostro;
 }
 
 void initStringFromSymbolList(Object *string, List *list){
-    String *str = string->value;
-    
     size_t count = list->count;
+    bool compact = true;
+    for (size_t i = 0; i < count; i++) {
+        if (listGet(list, i).raw > 0xFF) {
+            compact = false;
+            break;
+        }
+    }
+    
+    String *str = string->value;
     str->length = count;
-    str->characters = newArray(count * sizeof(EmojicodeChar));
+    str->compact = compact;
+    str->characters = newStringCharacters(count, compact);
     
     for (size_t i = 0; i < count; i++) {
-        characters(str)[i] = (EmojicodeChar)listGet(list, i).raw;
+        stringSetCharacterAt(str, i, (EmojicodeChar)listGet(list, i).raw);
     }
 }
 
 //MARK: Converting from C strings
 
 char* stringToChar(String *str){
-    //Size needed for UTF8 representation
-    size_t ds = u8_codingsize(characters(str), str->length);
-    //Allocate space for the UTF8 string
-    char *utf8str = malloc(ds + 1);
-    //Convert
-    size_t written = u8_toutf8(utf8str, ds, characters(str), str->length);
-    utf8str[written] = 0;
+    size_t size = stringUTF8Size(str);
+    char *utf8str = malloc(size + 1);
+    stringEncodeUTF8(str, utf8str);
+    utf8str[size] = 0;
     return utf8str;
 }
 
+char* stringToCharInBuffer(String *str, char *buffer, size_t size){
+    if (stringToUTF8Buffer(str, buffer, size) < size) {
+        return buffer;
+    }
+    return stringToChar(str);
+}
+
+Object* stringFromUTF8(const char *bytes, size_t size, Thread *thread){
+    bool compact, valid;
+    EmojicodeInteger len = utf8Length(bytes, size, &compact, &valid);
+    
+    if(len == 0){
+        return emptyString;
+    }
+    
+    stackPush(newStringCharacters(len, compact), 0, 0, thread);
+    Object *stro = newObject(CL_STRING);
+    String *string = stro->value;
+    string->length = len;
+    string->compact = compact;
+    string->characters = stackGetThis(thread);
+    stackPop(thread);
+    
+    stringDecodeUTF8(string, bytes, size);
+    
+    return stro;
+}
+
 Object* stringFromChar(const char *cstring){
-    EmojicodeInteger len = u8_strlen(cstring);
+    size_t size = strlen(cstring);
+    bool compact, valid;
+    EmojicodeInteger len = utf8Length(cstring, size, &compact, &valid);
     
     if(len == 0){
         return emptyString;
@@ -113,9 +461,10 @@ Object* stringFromChar(const char *cstring){
     Object *stro = newObject(CL_STRING);
     String *string = stro->value;
     string->length = len;
-    string->characters = newArray(len * sizeof(EmojicodeChar));
+    string->compact = compact;
+    string->characters = newStringCharacters(len, compact);
     
-    u8_toucs(characters(string), len, cstring, strlen(cstring));
+    stringDecodeUTF8(string, cstring, size);
     
     return stro;
 }
@@ -123,10 +472,7 @@ Object* stringFromChar(const char *cstring){
 //MARK: Bridges
 
 static Something stringPrintStdoutBrigde(Thread *thread){
-    String *string = stackGetThis(thread)->value;
-    char *utf8str = stringToChar(string);
-    printf("%s\n", utf8str);
-    free(utf8str);
+    outputWriteString(standardOutput, stackGetThis(thread)->value, true);
     return NOTHINGNESS;
 }
 
@@ -152,58 +498,45 @@ static Something stringSubstringBridge(Thread *thread){
 }
 
 static Something stringSearchBridge(Thread *thread){
-    String *string = stackGetThis(thread)->value;
-    String *search = stackGetVariable(0, thread).object->value;
-    
-    for (EmojicodeInteger i = 0; i < string->length; ++i){
-        bool found = true;
-        for (EmojicodeInteger j = 0; j < search->length; ++j) {
-            if (characters(string)[i + j] != characters(search)[j]) {
-                found = false;
-                break;
-            }
-        }
-        
-        if (found) {
-            return somethingInteger(i);
-        }
-    }
-    return NOTHINGNESS;
+    EmojicodeInteger index = stringFind(stackGetThis(thread)->value, 0, stackGetVariable(0, thread).object->value);
+    return index < 0 ? NOTHINGNESS : somethingInteger(index);
 }
 
 static Something stringTrimBridge(Thread *thread){
     String *string = stackGetThis(thread)->value;
     
-    EmojicodeInteger start = 0;
-    EmojicodeInteger stop = string->length - 1;
-    
-    while(start < string->length && isWhitespace(characters(string)[start]))
-        start++;
-    
-    while(stop > 0 && isWhitespace(characters(string)[stop]))
-        stop--;
+    EmojicodeInteger start, end;
+    if (string->compact) {
+        start = stringKernels.leadingWhitespaceCompact(stringCharacters(string), string->length);
+        end = stringKernels.trailingWhitespaceCompact((unsigned char *)stringCharacters(string) + start,
+                                                     string->length - start);
+    }
+    else {
+        start = stringKernels.leadingWhitespaceWide(stringCharacters(string), string->length);
+        end = stringKernels.trailingWhitespaceWide((EmojicodeChar *)stringCharacters(string) + start,
+                                                  string->length - start);
+    }
     
-    return somethingObject(stringSubstring(stackGetThis(thread), start, stop - start + 1, thread));
+    return somethingObject(stringSubstring(stackGetThis(thread), start, string->length - start - end, thread));
 }
 
 static void stringGetInput(Thread *thread) {
-    String *prompt = stackGetVariable(0, thread).object->value;
-    char *utf8str = stringToChar(prompt);
-    printf("%s\n", utf8str);
-    fflush(stdout);
-    free(utf8str);
+    outputWriteString(standardOutput, stackGetVariable(0, thread).object->value, true);
+    outputFlush(standardOutput);
     
     int bufferSize = 50, oldBufferSize = 0;
-    Object *buffer = newArray(bufferSize);
+    char *buffer = malloc(bufferSize);
     size_t bufferUsedSize = 0;
+    buffer[0] = 0;
     
+    allowGC();
     while (true) {
-        fgets((char *)buffer->value + oldBufferSize, bufferSize - oldBufferSize, stdin);
+        fgets(buffer + oldBufferSize, bufferSize - oldBufferSize, stdin);
         
-        bufferUsedSize = strlen(buffer->value);
+        bufferUsedSize = strlen(buffer);
         
         if(bufferUsedSize < bufferSize - 1){
-            if (((char *)buffer->value)[bufferUsedSize - 1] == '\n') {
+            if (bufferUsedSize > 0 && buffer[bufferUsedSize - 1] == '\n') {
                 bufferUsedSize -= 1;
             }
             break;
@@ -211,19 +544,21 @@ static void stringGetInput(Thread *thread) {
         
         oldBufferSize = bufferSize - 1;
         bufferSize *= 2;
-        buffer = resizeArray(buffer, bufferSize);
+        buffer = realloc(buffer, bufferSize);
     }
+    disallowGCAndPauseIfNeeded();
 
-    EmojicodeInteger len = u8_strlen_l(buffer->value, bufferUsedSize);
+    bool compact, valid;
+    EmojicodeInteger len = utf8Length(buffer, bufferUsedSize, &compact, &valid);
     
+    Object *chars = newStringCharacters(len, compact);
     String *string = stackGetThis(thread)->value;
     string->length = len;
-    
-    Object *chars = newArray(len * sizeof(EmojicodeChar));
-    string = stackGetThis(thread)->value;
+    string->compact = compact;
     string->characters = chars;
     
-    u8_toucs(characters(string), len, buffer->value, bufferUsedSize);
+    stringDecodeUTF8(string, buffer, bufferUsedSize);
+    free(buffer);
 }
 
 static Something stringSplitByStringBridge(Thread *thread) {
@@ -233,39 +568,15 @@ static Something stringSplitByStringBridge(Thread *thread) {
     stackSetVariable(1, somethingObject(newObject(CL_LIST)), thread);
     stackSetVariable(0, sp, thread);
     
-    EmojicodeInteger firstOfSeperator = 0, seperatorIndex = 0, firstAfterSeperator = 0;
+    EmojicodeInteger firstAfterSeperator = 0, seperatorIndex;
     
-    for (EmojicodeInteger i = 0, l = ((String *)stackGetThis(thread)->value)->length; i < l; i++) {
-        Object *stringObject = stackGetThis(thread);
-        Object *separatorObject = stackGetVariable(0, thread).object;
-        String *separator = (String *)separatorObject->value;
-        if(characters((String *)stringObject->value)[i] == characters(separator)[seperatorIndex]){
-            if (seperatorIndex == 0) {
-                firstOfSeperator = i;
-            }
-            
-            //Full seperator found
-            if(firstOfSeperator + separator->length == i + 1){
-                Object *stro;
-                if(firstAfterSeperator == firstOfSeperator){
-                    stro = emptyString;
-                }
-                else {
-                    stro = stringSubstring(stringObject, firstAfterSeperator, i - firstAfterSeperator - separator->length + 1, thread);
-                }
-                listAppend(stackGetVariable(1, thread).object, somethingObject(stro), thread);
-                seperatorIndex = 0;
-                firstAfterSeperator = i + 1;
-            }
-            else {
-                seperatorIndex++;
-            }
-        }
-        else if(seperatorIndex > 0){ //and not matching
-            seperatorIndex = 0;
-            //We search from the begin of the last partial match
-            i = firstOfSeperator;
-        }
+    //An empty separator would be found at every position, the string is not split at all then
+    while (((String *)stackGetVariable(0, thread).object->value)->length > 0 &&
+           (seperatorIndex = stringFind(stackGetThis(thread)->value, firstAfterSeperator,
+                                        stackGetVariable(0, thread).object->value)) >= 0) {
+        Object *stro = stringSubstring(stackGetThis(thread), firstAfterSeperator, seperatorIndex - firstAfterSeperator, thread);
+        listAppend(stackGetVariable(1, thread).object, somethingObject(stro), thread);
+        firstAfterSeperator = seperatorIndex + ((String *)stackGetVariable(0, thread).object->value)->length;
     }
     
     Object *stringObject = stackGetThis(thread);
@@ -284,23 +595,31 @@ static Something stringLengthBridge(Thread *thread){
 
 static Something stringUTF8LengthBridge(Thread *thread){
     String *str = stackGetThis(thread)->value;
-    return somethingInteger((EmojicodeInteger)u8_codingsize(str->characters->value, str->length));
+    return somethingInteger((EmojicodeInteger)stringUTF8Size(str));
 }
 
 static Something stringByAppendingSymbolBridge(Thread *thread){
-    Object *co = newArray((((String *)stackGetThis(thread)->value)->length + 1) * sizeof(EmojicodeChar));
+    EmojicodeChar symbol = unwrapSymbol(stackGetVariable(0, thread));
+    
+    stackPush(stackGetThis(thread), 1, 0, thread);
+    stackSetVariable(0, somethingObject(newObject(CL_STRING)), thread);
+    
     String *string = stackGetThis(thread)->value;
+    bool compact = string->compact && symbol <= 0xFF;
+    Object *co = newStringCharacters(string->length + 1, compact);
     
-    Object *ostro = newObject(CL_STRING);
+    string = stackGetThis(thread)->value;
+    Object *ostro = stackGetVariable(0, thread).object;
     String *ostr = ostro->value;
     
     ostr->length = string->length + 1;
+    ostr->compact = compact;
     ostr->characters = co;
     
-    memcpy(characters(ostr), characters(string), string->length * sizeof(EmojicodeChar));
-    
-    characters(ostr)[string->length] = unwrapSymbol(stackGetVariable(0, thread));
+    stringCopyCharacters(ostr, 0, string, 0, string->length);
+    stringSetCharacterAt(ostr, string->length, symbol);
     
+    stackPop(thread);
     return somethingObject(ostro);
 }
 
@@ -311,7 +630,7 @@ static Something stringSymbolAtBridge(Thread *thread){
         return NOTHINGNESS;
     }
     
-    return somethingInteger(characters(str)[index]);
+    return somethingInteger(stringCharacterAt(str, index));
 }
 
 static Something stringBeginsWithBridge(Thread *thread){
@@ -327,15 +646,12 @@ static Something stringSplitBySymbolBridge(Thread *thread){
     stackPush(stackGetThis(thread), 1, 0, thread);
     stackSetVariable(0, somethingObject(newObject(CL_LIST)), thread);
     
-    EmojicodeInteger from = 0;
+    EmojicodeInteger from = 0, i;
     
-    for (EmojicodeInteger i = 0, l = ((String *)stackGetThis(thread)->value)->length; i < l; i++) {
-        Object *stringObject = stackGetThis(thread);
-        if (characters((String *)stringObject->value)[i] == separator) {
-            listAppend(stackGetVariable(0, thread).object, somethingObject(stringSubstring(stringObject, from, i - from, thread)), thread);
-            from = i + 1;
-        }
-        
+    while ((i = stringFindCharacter(stackGetThis(thread)->value, from, separator)) >= 0) {
+        Object *stro = stringSubstring(stackGetThis(thread), from, i - from, thread);
+        listAppend(stackGetVariable(0, thread).object, somethingObject(stro), thread);
+        from = i + 1;
     }
 
     Object *stringObject = stackGetThis(thread);
@@ -349,12 +665,12 @@ static Something stringSplitBySymbolBridge(Thread *thread){
 static Something stringToData(Thread *thread){
     String *str = stackGetThis(thread)->value;
     
-    size_t ds = u8_codingsize(characters(str), str->length);
+    size_t ds = stringUTF8Size(str);
     
     Object *bytesObject = newArray(ds);
     
     str = stackGetThis(thread)->value;
-    u8_toutf8(bytesObject->value, ds, characters(str), str->length);
+    stringEncodeUTF8(str, bytesObject->value);
     
     stackPush(bytesObject, 0, 0, thread);
     
@@ -370,13 +686,17 @@ static Something stringToData(Thread *thread){
 }
 
 static Something stringToCharacterList(Thread *thread){
-    String *str = stackGetThis(thread)->value;
-    Object *list = newObject(CL_LIST);
+    stackPush(stackGetThis(thread), 1, 0, thread);
+    stackSetVariable(0, somethingObject(newObject(CL_LIST)), thread);
     
-    for (size_t i = 0; i < str->length; i++) {
-        listAppend(list, somethingSymbol(characters(str)[i]), thread);
+    for (EmojicodeInteger i = 0; i < ((String *)stackGetThis(thread)->value)->length; i++) {
+        EmojicodeChar c = stringCharacterAt(stackGetThis(thread)->value, i);
+        listAppend(stackGetVariable(0, thread).object, somethingSymbol(c), thread);
     }
-    return somethingObject(list);
+    
+    Something list = stackGetVariable(0, thread);
+    stackPop(thread);
+    return list;
 }
 
 static Something stringJSON(Thread *thread){
@@ -390,21 +710,25 @@ static void stringFromSymbolListBridge(Thread *thread){
 static void stringFromStringList(Thread *thread) {
     size_t stringSize = 0;
     size_t appendLocation = 0;
+    bool compact = true;
     
     {
         List *list = stackGetVariable(0, thread).object->value;
         String *glue = stackGetVariable(1, thread).object->value;
         
         for (size_t i = 0; i < list->count; i++) {
-            stringSize += ((String *)listGet(list, i).object->value)->length;
+            String *aString = listGet(list, i).object->value;
+            stringSize += aString->length;
+            compact = compact && aString->compact;
         }
         
-        if (list->count > 0){
+        if (list->count > 1){
             stringSize += glue->length * (list->count - 1);
+            compact = compact && glue->compact;
         }
     }
         
-    Object *co = newArray(stringSize * sizeof(EmojicodeChar));
+    Object *co = newStringCharacters(stringSize, compact);
     
     {
         List *list = stackGetVariable(0, thread).object->value;
@@ -412,14 +736,15 @@ static void stringFromStringList(Thread *thread) {
         
         String *string = stackGetThis(thread)->value;
         string->length = stringSize;
+        string->compact = compact;
         string->characters = co;
         
         for (size_t i = 0; i < list->count; i++) {
             String *aString = listGet(list, i).object->value;
-            memcpy(characters(string) + appendLocation, characters(aString), aString->length * sizeof(EmojicodeChar));
+            stringCopyCharacters(string, appendLocation, aString, 0, aString->length);
             appendLocation += aString->length;
             if(i + 1 < list->count){
-                memcpy(characters(string) + appendLocation, characters(glue), glue->length * sizeof(EmojicodeChar));
+                stringCopyCharacters(string, appendLocation, glue, 0, glue->length);
                 appendLocation += glue->length;
             }
         }
@@ -427,35 +752,48 @@ static void stringFromStringList(Thread *thread) {
 }
 
 static void stringFromSymbol(Thread *thread){
-    Object *co = newArray(sizeof(EmojicodeChar));
+    EmojicodeChar symbol = (EmojicodeChar)stackGetVariable(0, thread).raw;
+    Object *co = newStringCharacters(1, symbol <= 0xFF);
     
     String *string = stackGetThis(thread)->value;
     string->length = 1;
+    string->compact = symbol <= 0xFF;
     string->characters = co;
     
-    ((EmojicodeChar *)string->characters->value)[0] = (EmojicodeChar)stackGetVariable(0, thread).raw;
+    stringSetCharacterAt(string, 0, symbol);
+}
+
+/** Returns the number of characters needed to represent @c n in @c base. */
+static EmojicodeInteger integerDigitCount(EmojicodeInteger n, EmojicodeInteger base){
+    EmojicodeInteger d = n < 0 ? 2 : 1;
+    while (n /= base) d++;
+    return d;
+}
+
+/** Writes the @c integerDigitCount(n, base) characters representing @c n to @c characters. */
+static void integerWriteDigits(unsigned char *characters, EmojicodeInteger n, EmojicodeInteger base){
+    EmojicodeInteger a = llabs(n);
+    characters += integerDigitCount(n, base);
+    do
+        *--characters =  "0123456789abcdefghijklmnopqrstuvxyz"[a % base % 35];
+    while (a /= base);
+    
+    if (n < 0) characters[-1] = '-';
 }
 
 static void stringFromInteger(Thread *thread){
     EmojicodeInteger base = stackGetVariable(1, thread).raw;
-    EmojicodeInteger n = stackGetVariable(0, thread).raw, a = llabs(n);
-    bool negative = n < 0;
+    EmojicodeInteger n = stackGetVariable(0, thread).raw;
+    EmojicodeInteger d = integerDigitCount(n, base);
     
-    EmojicodeInteger d = negative ? 2 : 1;
-    while (n /= base) d++;
-    
-    Object *co = newArray(d * sizeof(EmojicodeChar));
+    Object *co = newStringCharacters(d, true);
     
     String *string = stackGetThis(thread)->value;
     string->length = d;
+    string->compact = true;
     string->characters = co;
     
-    EmojicodeChar *characters = characters(string) + d;
-    do
-        *--characters =  "0123456789abcdefghijklmnopqrstuvxyz"[a % base % 35];
-    while (a /= base);
-    
-    if (negative) characters[-1] = '-';
+    integerWriteDigits(string->characters->value, n, base);
 }
 
 static Something stringToInteger(Thread *thread){
@@ -466,11 +804,10 @@ static Something stringToInteger(Thread *thread){
         return NOTHINGNESS;
     }
     
-    EmojicodeChar *characters = characters(string);
-    
     EmojicodeInteger x = 0;
     for (size_t i = 0; i < string->length; i++) {
-        if (i == 0 && (characters[i] == '-' || characters[i] == '+')) {
+        EmojicodeChar c = stringCharacterAt(string, i);
+        if (i == 0 && (c == '-' || c == '+')) {
             if (string->length < 2) {
                 return NOTHINGNESS;
             }
@@ -478,14 +815,14 @@ static Something stringToInteger(Thread *thread){
         }
         
         EmojicodeInteger b = base;
-        if ('0' <= characters[i] && characters[i] <= '9') {
-            b = characters[i] - '0';
+        if ('0' <= c && c <= '9') {
+            b = c - '0';
         }
-        else if ('A' <= characters[i] && characters[i] <= 'Z') {
-            b = characters[i] - 'A' + 10;
+        else if ('A' <= c && c <= 'Z') {
+            b = c - 'A' + 10;
         }
-        else if ('a' <= characters[i] && characters[i] <= 'z') {
-            b = characters[i] - 'a' + 10;
+        else if ('a' <= c && c <= 'z') {
+            b = c - 'a' + 10;
         }
         
         if (b >= base) {
@@ -496,7 +833,7 @@ static Something stringToInteger(Thread *thread){
         x += b;
     }
     
-    if (characters[0] == '-') {
+    if (stringCharacterAt(string, 0) == '-') {
         x *= -1;
     }
     return somethingInteger(x);
@@ -504,21 +841,23 @@ static Something stringToInteger(Thread *thread){
 
 static void stringFromData(Thread *thread){
     Data *data = stackGetVariable(0, thread).object->value;
-    if (!u8_isvalid(data->bytes, data->length)) {
+    bool compact, valid;
+    EmojicodeInteger len = utf8Length(data->bytes, data->length, &compact, &valid);
+    if (!valid) {
         stackGetThis(thread)->value = NULL;
         return;
     }
     
-    EmojicodeInteger len = u8_strlen_l(data->bytes, data->length);
-    Object *characters = newArray(len * sizeof(EmojicodeChar));
+    Object *characters = newStringCharacters(len, compact);
     
     String *string = stackGetThis(thread)->value;
     string->length = len;
+    string->compact = compact;
     string->characters = characters;
     
     data = stackGetVariable(0, thread).object->value;
     
-    u8_toucs(characters(string), len, data->bytes, data->length);
+    stringDecodeUTF8(string, data->bytes, data->length);
 }
 
 static Something stringCompareBridge(Thread *thread) {
@@ -528,9 +867,175 @@ static Something stringCompareBridge(Thread *thread) {
 }
 
 void stringMark(Object *self){
-    if(((String *)self->value)->characters){
-        mark(&((String *)self->value)->characters);
+    String *string = self->value;
+    if (!string->characters) {
+        return;
+    }
+    
+    //Only retain the used characters if this string is a small slice of a huge array
+    size_t size = stringCharacterSize(string);
+    size_t arraySize = string->characters->size - sizeof(Object);
+    if (arraySize >= stringSliceRetentionLimit && string->length * size <= arraySize / 8) {
+        if (markArraySlice(&string->characters, string->offset * size, string->length * size)) {
+            string->offset = 0;
+        }
+    }
+    else {
+        mark(&string->characters);
+    }
+}
+
+//MARK: String Builder
+
+/**
+ * Makes sure the builder in the this-slot can append @c length code points in the given representation.
+ * The characters array grows geometrically and is widened if a non-compact code point is going to be appended.
+ * @warning GC-invoking
+ */
+static void stringBuilderEnsureCapacity(EmojicodeInteger length, bool compact, Thread *thread){
+    StringBuilder *builder = stackGetThis(thread)->value;
+    bool widen = builder->string.compact && !compact;
+    EmojicodeInteger capacity = builder->capacity;
+    
+    if (builder->string.length + length > capacity) {
+        capacity += capacity >> 1;
+        if (capacity < builder->string.length + length) {
+            capacity = builder->string.length + length;
+        }
+    }
+    else if (!widen) {
+        return;
+    }
+    
+    if (widen || !builder->string.characters) {
+        bool newCompact = builder->string.compact && compact;
+        Object *co = newStringCharacters(capacity, newCompact);
+        builder = stackGetThis(thread)->value;
+        
+        if (builder->string.characters) {
+            String string = { .length = builder->string.length, .characters = co, .compact = newCompact };
+            stringCopyCharacters(&string, 0, &builder->string, 0, builder->string.length);
+        }
+        builder->string.characters = co;
+        builder->string.compact = newCompact;
+    }
+    else {
+        size_t size = builder->string.compact ? capacity : sizeCalculationWithOverflowProtection(capacity, sizeof(EmojicodeChar));
+        Object *co = resizeArray(builder->string.characters, size);
+        builder = stackGetThis(thread)->value;
+        builder->string.characters = co;
+    }
+    builder->capacity = capacity;
+}
+
+static void stringBuilderInit(Thread *thread){
+    StringBuilder *builder = stackGetThis(thread)->value;
+    builder->string.length = 0;
+    builder->string.characters = NULL;
+    builder->string.compact = true;
+    builder->capacity = 0;
+}
+
+static void stringBuilderInitCapacity(Thread *thread){
+    stringBuilderInit(thread);
+    EmojicodeInteger capacity = unwrapInteger(stackGetVariable(0, thread));
+    if (capacity > 0) {
+        stringBuilderEnsureCapacity(capacity, true, thread);
+    }
+}
+
+static Something stringBuilderAppendString(Thread *thread){
+    String *string = stackGetVariable(0, thread).object->value;
+    stringBuilderEnsureCapacity(string->length, string->compact, thread);
+    
+    StringBuilder *builder = stackGetThis(thread)->value;
+    string = stackGetVariable(0, thread).object->value;
+    stringCopyCharacters(&builder->string, builder->string.length, string, 0, string->length);
+    builder->string.length += string->length;
+    return NOTHINGNESS;
+}
+
+static Something stringBuilderAppendSymbol(Thread *thread){
+    EmojicodeChar symbol = unwrapSymbol(stackGetVariable(0, thread));
+    stringBuilderEnsureCapacity(1, symbol <= 0xFF, thread);
+    
+    StringBuilder *builder = stackGetThis(thread)->value;
+    stringSetCharacterAt(&builder->string, builder->string.length++, symbol);
+    return NOTHINGNESS;
+}
+
+static Something stringBuilderAppendInteger(Thread *thread){
+    EmojicodeInteger n = unwrapInteger(stackGetVariable(0, thread));
+    EmojicodeInteger base = unwrapInteger(stackGetVariable(1, thread));
+    EmojicodeInteger d = integerDigitCount(n, base);
+    stringBuilderEnsureCapacity(d, true, thread);
+    
+    StringBuilder *builder = stackGetThis(thread)->value;
+    if (builder->string.compact) {
+        integerWriteDigits((unsigned char *)stringCharacters(&builder->string) + builder->string.length, n, base);
+    }
+    else {
+        unsigned char digits[d];
+        integerWriteDigits(digits, n, base);
+        for (EmojicodeInteger i = 0; i < d; i++) {
+            stringSetCharacterAt(&builder->string, builder->string.length + i, digits[i]);
+        }
+    }
+    builder->string.length += d;
+    return NOTHINGNESS;
+}
+
+static Something stringBuilderLength(Thread *thread){
+    return somethingInteger(((StringBuilder *)stackGetThis(thread)->value)->string.length);
+}
+
+/** Hands the characters array over to a new string without copying it and empties the builder. */
+static Something stringBuilderToString(Thread *thread){
+    if (((StringBuilder *)stackGetThis(thread)->value)->string.length == 0) {
+        return somethingObject(emptyString);
+    }
+    
+    Object *stro = newObject(CL_STRING);
+    StringBuilder *builder = stackGetThis(thread)->value;
+    *(String *)stro->value = builder->string;
+    
+    builder->string.length = 0;
+    builder->string.characters = NULL;
+    builder->string.compact = true;
+    builder->capacity = 0;
+    
+    return somethingObject(stro);
+}
+
+void stringBuilderMark(Object *self){
+    StringBuilder *builder = self->value;
+    if (builder->string.characters) {
+        mark(&builder->string.characters);
+    }
+}
+
+MethodHandler stringBuilderMethodForName(EmojicodeChar name){
+    switch (name) {
+        case 0x1F4DD: //📝
+            return stringBuilderAppendString;
+        case 0x1F523: //🔣
+            return stringBuilderAppendSymbol;
+        case 0x1F682: //🚂
+            return stringBuilderAppendInteger;
+        case 0x1F4CF: //📏
+            return stringBuilderLength;
+        case 0x1F521: //🔡
+            return stringBuilderToString;
+    }
+    return NULL;
+}
+
+InitializerHandler stringBuilderInitializerForName(EmojicodeChar name){
+    switch (name) {
+        case 0x1F427: //🐧
+            return stringBuilderInitCapacity;
     }
+    return stringBuilderInit;
 }
 
 MethodHandler stringMethodForName(EmojicodeChar name){
@@ -9,328 +9,1382 @@
 #include "Emojicode.h"
 #include "EmojicodeDictionary.h"
 #include "EmojicodeList.h"
+#include "StringKernels.h"
+#include "utf8.h"
 #include <math.h>
+#include <stdio.h>
+#include <string.h>
 
-typedef enum {
-    JSON_NONE = 0,
-    JSON_STRING = 1,
-    JSON_STRING_ESCAPE = 2,
-    JSON_NUMBER = 3, JSON_DOUBLE = 4, JSON_EXPONENT = 5, JSON_EXPONENT_NO_PLUS = 6, JSON_EXPONENT_BACK_VALUE = 7,
-    JSON_NUMBER_NEGATIVE = 8, JSON_DOUBLE_NEGATIVE = 9, JSON_EXPONENT_NEGATIVE = 10, JSON_EXPONENT_NO_PLUS_NEGATIVE = 11, JSON_EXPONENT_BACK_VALUE_NEGATIVE = 12,
-    JSON_OBJECT_KEY, JSON_OBJECT_KEY_BACK_VALUE, JSON_OBJECT_COLON, JSON_OBJECT_VALUE_BACK_VALUE, JSON_OBJECT_NEXT,
-    JSON_ARRAY, JSON_ARRAY_BACK_VALUE, JSON_ARRAY_NEXT, JSON_ARRAY_FIRST,
-    JSON_TRUE_T, JSON_TRUE_TR, JSON_TRUE_TRU,
-    JSON_FALSE_F, JSON_FALSE_FA, JSON_FALSE_FAL, JSON_FALSE_FALS,
-    JSON_NULL_N, JSON_NULL_NU, JSON_NULL_NUL
-} JSONState;
+/*
+ * The parser works in two stages. The first stage lets a string kernel collect the indices of all structural
+ * characters and reduces them to the brackets, colons and commas outside of strings and the quotes delimiting strings.
+ * It also checks that all brackets are balanced and counts the elements of all arrays and objects.
+ * The second stage walks these structurals and builds the values. It never looks at the characters inside strings
+ * unless the string contains escape sequences, strings without them are copied from the source as a whole.
+ */
 
 typedef struct {
-    JSONState state;
-    EmojicodeInteger integer;
-    int numberDigitsFraction;
-} JSONStackFrame;
-
-#define errorExit() restoreStackState(s, thread); return NOTHINGNESS;
-#define upgrade(now, expect, ec) case now: if (c == ec) { stackCurrent->state = now ## expect; continue; } else { errorExit(); }
-#define upgradeReturn(now, ec, r) case now: if (c == ec) { backValue = r; popTheStack(); } else { errorExit(); }
-#define appendEscape(seq, c) case seq: listAppend(stackGetVariable(0, thread).object, somethingSymbol(c), thread); continue;
-#define whitespaceCase case '\t': case '\n': case '\r': case ' ':
-#define popTheStack() stackCurrent--; continue;
-#define pushTheStack() stackCurrent++; if (stackCurrent > stackLimit) { errorExit(); } stackCurrent->state = JSON_NONE; continue;
-#define returnArray() backValue = stackGetVariable(0, thread); stackPop(thread); popTheStack();
-#define integerValue() somethingInteger((stackCurrent->state == JSON_NUMBER_NEGATIVE) ? -stackCurrent->integer : stackCurrent->integer)
-
-#define _doubleInternalValue() ((double)stackCurrent->integer/pow(10, stackCurrent->numberDigitsFraction))
-#define doubleRawValue() ((stackCurrent->state == JSON_DOUBLE_NEGATIVE) ? -_doubleInternalValue() : _doubleInternalValue())
-#define doubleValue() somethingDouble(doubleRawValue())
-
-#define jsonMaxDepth 256
+    /** The index of the structural character in the source. */
+    uint32_t position;
+    /**
+     * For an opening bracket the number of commas directly inside the array or object, for the opening quote of a
+     * string whether the string contains escape sequences.
+     */
+    uint32_t extra;
+} JSONStructural;
 
-Something parseJSON(Thread *thread) {
-    const size_t length = ((String*)stackGetThis(thread)->value)->length;
-    JSONStackFrame stack[jsonMaxDepth];
-    JSONStackFrame *stackLimit = stack + jsonMaxDepth - 1;
-    JSONStackFrame *stackCurrent = stack;
+typedef struct {
+    Thread *thread;
+    /** The characters of the source, which is this of the current stack frame. Refresh after allocating. */
+    const void *characters;
+    bool compact;
+    size_t length;
+    JSONStructural *structurals;
+    size_t structuralsCount;
+    /** The next structural to consume. */
+    size_t next;
+    /** The index of the next character to read. */
+    size_t position;
+    /** A buffer to decode strings with escape sequences into. */
+    EmojicodeChar *buffer;
+    size_t bufferCapacity;
+} JSONParser;
+
+static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/** Returns the character at @c i or 0 if @c i is past the end, where the first stage guarantees no 0 can be. */
+static inline EmojicodeChar jsonCharacter(JSONParser *parser, size_t i){
+    if (i >= parser->length) {
+        return 0;
+    }
+    if (parser->compact) {
+        return ((const unsigned char *)parser->characters)[i];
+    }
+    return ((const EmojicodeChar *)parser->characters)[i];
+}
+
+static inline void jsonRefresh(JSONParser *parser){
+    parser->characters = stringCharacters(stackGetThis(parser->thread)->value);
+}
+
+static inline bool jsonIsWhitespace(EmojicodeChar c){
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+/** Skips whitespace and returns the character at the new position. */
+static inline EmojicodeChar jsonSkipWhitespace(JSONParser *parser){
     EmojicodeChar c;
-    Something backValue = NOTHINGNESS;
-    size_t i = 0;
-    
-    StackState s = storeStackState(thread);
-    
-    stackCurrent->state = JSON_NONE;
-    
-    while (i < length) {
-        if (stackCurrent < stack) {
-            errorExit();
-        }
-        
-        c = characters((String *)stackGetThis(thread)->value)[i++];
-        
-        switch (stackCurrent->state) {
-            case JSON_STRING:
-                switch (c) {
-                    case '\\':
-                        stackCurrent->state = JSON_STRING_ESCAPE;
-                        continue;
-                    case '"':
-                        stackSetVariable(1, somethingObject(newObject(CL_STRING)), thread);
-                        initStringFromSymbolList(stackGetVariable(1, thread).object, stackGetVariable(0, thread).object->value);
-                        backValue = stackGetVariable(1, thread);
-                        stackPop(thread);
-                        popTheStack();
-                    default:
-                        if (c <= 0x1F) {
-                            errorExit();
-                        }
-                        listAppend(stackGetVariable(0, thread).object, somethingSymbol(c), thread);
-                        continue;
+    while (jsonIsWhitespace(c = jsonCharacter(parser, parser->position))) {
+        parser->position++;
+    }
+    return c;
+}
+
+/**
+ * Reduces the @c count structural @c indices found by the string kernel to the structurals the second stage needs.
+ * @returns Whether the structurals are valid, i.e. brackets and quotes are balanced, no array or object is nested
+ * deeper than @c jsonMaxDepth and there are no control characters except whitespace outside of strings.
+ */
+static bool jsonReduceStructurals(JSONParser *parser, const uint32_t *indices, size_t count){
+    size_t open[jsonMaxDepth];
+    size_t depth = 0, string = 0, n = 0;
+    bool inString = false;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t position = indices[i];
+        EmojicodeChar c = jsonCharacter(parser, position);
+        if (inString) {
+            switch (c) {
+                case '"':
+                    parser->structurals[n++] = (JSONStructural){ position, 0 };
+                    inString = false;
+                    continue;
+                case '\\':
+                    parser->structurals[string].extra = 1;
+                    if (i + 1 < count && indices[i + 1] == position + 1) {
+                        i++;  // An escaped quote or backslash
+                    }
+                    continue;
+                default:
+                    if (c < 0x20) {
+                        return false;
+                    }
+                    continue;
+            }
+        }
+        switch (c) {
+            case '"':
+                string = n;
+                inString = true;
+                break;
+            case '[':
+            case '{':
+                if (depth == jsonMaxDepth) {
+                    return false;
                 }
-            case JSON_STRING_ESCAPE:
-                stackCurrent->state = JSON_STRING;
-                switch (c) {
-                        appendEscape('"', '"')
-                        appendEscape('\\', '\\')
-                        appendEscape('/', '/')
-                        appendEscape('b', '\b')
-                        appendEscape('f', '\f')
-                        appendEscape('n', '\n')
-                        appendEscape('r', '\r')
-                        appendEscape('t', '\t')
-                    case 'u': {
-                        EmojicodeChar *chars = characters((String *)stackGetThis(thread)->value);
-                        EmojicodeInteger x = 0, high = 0;
-                        while (true) {
-                            for (size_t e = i + 4; i < e; i++) {
-                                if (i >= length) {
-                                    errorExit();
-                                }
-                                
-                                c = chars[i];
-                                x *= 16;
-                                
-                                if ('0' <= c && c <= '9')
-                                    x += c - '0';
-                                else if ('A' <= c && c <= 'F')
-                                    x += c - 'A' + 10;
-                                else if ('a' <= c && c <= 'f')
-                                    x += c - 'a' + 10;
-                                else {
-                                    errorExit();
-                                }
-                            }
-                            if (high)
-                                x = (high << 10) + x + 0x10000 - (0xD800 << 10) - 0xDC00;
-                            else if (0xD800 <= x && x <= 0xDBFF) {
-                                if (i + 2 >= length || chars[i++] != '\\' || chars[i++] != 'u') {
-                                    errorExit();
-                                }
-                                high = x;
-                                x = 0;
-                                continue;
-                            }
-                            break;
-                        }
-                        listAppend(stackGetVariable(0, thread).object, somethingSymbol(x), thread);
-                        continue;
+                open[depth++] = n;
+                break;
+            case ']':
+            case '}':
+                //Both closing brackets follow their opening bracket two code points later
+                if (depth == 0 || jsonCharacter(parser, parser->structurals[open[--depth]].position) + 2 != c) {
+                    return false;
+                }
+                break;
+            case ',':
+                if (depth > 0) {
+                    parser->structurals[open[depth - 1]].extra++;
+                }
+                break;
+            case ':':
+                break;
+            case ' ':
+            case '\n':
+            case '\t':
+            case '\r':
+                continue;
+            default:
+                return false;
+        }
+        parser->structurals[n++] = (JSONStructural){ position, 0 };
+    }
+    parser->structuralsCount = n;
+    return !inString && depth == 0;
+}
+
+/** Consumes the structural at the current position. */
+static inline void jsonConsumeStructural(JSONParser *parser){
+    parser->position = parser->structurals[parser->next++].position + 1;
+}
+
+/**
+ * Allocates a string of @c length code points whose characters the caller must fill in.
+ * @warning GC-invoking
+ */
+static Object* jsonNewString(size_t length, bool compact, Thread *thread){
+    stackPush(newStringCharacters(length, compact), 0, 0, thread);
+    Object *stro = newObject(CL_STRING);
+    String *string = stro->value;
+    string->length = length;
+    string->compact = compact;
+    string->characters = stackGetThis(thread);
+    stackPop(thread);
+    return stro;
+}
+
+static bool jsonHexDigits(JSONParser *parser, size_t i, EmojicodeChar *value){
+    EmojicodeChar x = 0;
+    for (size_t e = i + 4; i < e; i++) {
+        EmojicodeChar c = jsonCharacter(parser, i);
+        x *= 16;
+        if ('0' <= c && c <= '9')
+            x += c - '0';
+        else if ('A' <= c && c <= 'F')
+            x += c - 'A' + 10;
+        else if ('a' <= c && c <= 'f')
+            x += c - 'a' + 10;
+        else
+            return false;
+    }
+    *value = x;
+    return true;
+}
+
+/** Decodes the escape sequences between @c from and @c to into the buffer and returns the number of code points. */
+static bool jsonUnescape(JSONParser *parser, size_t from, size_t to, size_t *length){
+    if (parser->bufferCapacity < to - from) {
+        free(parser->buffer);
+        parser->bufferCapacity = to - from;
+        parser->buffer = malloc(parser->bufferCapacity * sizeof(EmojicodeChar));
+    }
+    size_t n = 0;
+    for (size_t i = from; i < to; i++) {
+        EmojicodeChar c = jsonCharacter(parser, i);
+        if (c != '\\') {
+            parser->buffer[n++] = c;
+            continue;
+        }
+        switch (jsonCharacter(parser, ++i)) {
+            case '"': c = '"'; break;
+            case '\\': c = '\\'; break;
+            case '/': c = '/'; break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case 'u':
+                if (i + 4 >= to || !jsonHexDigits(parser, i + 1, &c)) {
+                    return false;
+                }
+                i += 4;
+                if (0xD800 <= c && c <= 0xDBFF) {
+                    EmojicodeChar low;
+                    if (i + 6 >= to || jsonCharacter(parser, i + 1) != '\\' || jsonCharacter(parser, i + 2) != 'u' ||
+                        !jsonHexDigits(parser, i + 3, &low) || low < 0xDC00 || 0xDFFF < low) {
+                        return false;
                     }
+                    c = (c << 10) + low + 0x10000 - (0xD800 << 10) - 0xDC00;
+                    i += 6;
                 }
-                errorExit();
-            case JSON_DOUBLE:
-            case JSON_DOUBLE_NEGATIVE:
-                stackCurrent->numberDigitsFraction++;
-            case JSON_NUMBER:
-            case JSON_NUMBER_NEGATIVE:
-                switch (c) {
-                    case '.':
-                        stackCurrent->state += 1;
-                        stackCurrent->numberDigitsFraction = 0;
-                        continue;
-                    case 'E':
-                    case 'e':
-                        stack->numberDigitsFraction = 0;
-                        stackCurrent->state += 2;
-                        continue;
-                    case '0':
-                    case '1':
-                    case '2':
-                    case '3':
-                    case '4':
-                    case '5':
-                    case '6':
-                    case '7':
-                    case '8':
-                    case '9':
-                        stackCurrent->integer = stackCurrent->integer * 10 + c - '0';
-                        continue;
-                    default:
-                        i--;
-                        backValue = integerValue();
-                        popTheStack();
+                break;
+            default:
+                return false;
+        }
+        parser->buffer[n++] = c;
+    }
+    *length = n;
+    return true;
+}
+
+/**
+ * Creates the string between the quotes at the current position.
+ * @warning GC-invoking
+ */
+static bool jsonString(JSONParser *parser, Something *value){
+    JSONStructural *open = parser->structurals + parser->next;
+    bool escaped = open->extra;
+    size_t from = open->position + 1, to = open[1].position;
+    parser->next += 2;
+    parser->position = to + 1;
+
+    if (escaped) {
+        size_t length;
+        if (!jsonUnescape(parser, from, to, &length)) {
+            return false;
+        }
+        bool compact = true;
+        for (size_t i = 0; i < length; i++) {
+            if (parser->buffer[i] > 0xFF) {
+                compact = false;
+                break;
+            }
+        }
+        Object *stro = jsonNewString(length, compact, parser->thread);
+        String *string = stro->value;
+        for (size_t i = 0; i < length; i++) {
+            stringSetCharacterAt(string, i, parser->buffer[i]);
+        }
+        jsonRefresh(parser);
+        *value = somethingObject(stro);
+        return true;
+    }
+
+    size_t length = to - from;
+    if (length == 0) {
+        *value = somethingObject(emptyString);
+        return true;
+    }
+    bool compact = parser->compact;
+    if (!compact) {
+        const EmojicodeChar *characters = (const EmojicodeChar *)parser->characters + from;
+        compact = true;
+        for (size_t i = 0; i < length; i++) {
+            if (characters[i] > 0xFF) {
+                compact = false;
+                break;
+            }
+        }
+    }
+    Object *stro = jsonNewString(length, compact, parser->thread);
+    jsonRefresh(parser);
+    String *string = stro->value;
+    if (compact == parser->compact) {
+        size_t size = stringCharacterSize(string);
+        memcpy(stringCharacters(string), (const Byte *)parser->characters + from * size, length * size);
+    }
+    else {
+        const EmojicodeChar *characters = (const EmojicodeChar *)parser->characters + from;
+        unsigned char *destination = stringCharacters(string);
+        for (size_t i = 0; i < length; i++) {
+            destination[i] = (unsigned char)characters[i];
+        }
+    }
+    *value = somethingObject(stro);
+    return true;
+}
+
+static inline bool jsonIsDigit(EmojicodeChar c){
+    return '0' <= c && c <= '9';
+}
+
+/** Parses the number at the current position, which is an integer unless it has a fraction or an exponent. */
+static bool jsonNumber(JSONParser *parser, Something *value){
+    size_t start = parser->position, i = start;
+    bool negative = jsonCharacter(parser, i) == '-';
+    if (negative) {
+        i++;
+    }
+    //The first 19 significant digits fit into mantissa, exponent is the power of ten it must be multiplied with
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int64_t exponent = 0;
+    bool truncated = false, isDouble = false;
+
+    EmojicodeChar c = jsonCharacter(parser, i);
+    if (c == '0') {
+        c = jsonCharacter(parser, ++i);
+    }
+    else if (jsonIsDigit(c)) {
+        for (; jsonIsDigit(c); c = jsonCharacter(parser, ++i)) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (c - '0');
+                digits++;
+            }
+            else {
+                truncated = true;
+                exponent++;
+            }
+        }
+    }
+    else {
+        return false;
+    }
+    if (c == '.') {
+        isDouble = true;
+        c = jsonCharacter(parser, ++i);
+        if (!jsonIsDigit(c)) {
+            return false;
+        }
+        for (; jsonIsDigit(c); c = jsonCharacter(parser, ++i)) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (c - '0');
+                digits += mantissa > 0;
+                exponent--;
+            }
+            else {
+                truncated = true;
+            }
+        }
+    }
+    if (c == 'e' || c == 'E') {
+        isDouble = true;
+        c = jsonCharacter(parser, ++i);
+        bool negativeExponent = c == '-';
+        if (c == '-' || c == '+') {
+            c = jsonCharacter(parser, ++i);
+        }
+        if (!jsonIsDigit(c)) {
+            return false;
+        }
+        int64_t e = 0;
+        for (; jsonIsDigit(c); c = jsonCharacter(parser, ++i)) {
+            if (e < 100000) {
+                e = e * 10 + (c - '0');
+            }
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+    parser->position = i;
+
+    if (!isDouble && !truncated && mantissa <= (uint64_t)INT64_MAX) {
+        *value = somethingInteger(negative ? -(EmojicodeInteger)mantissa : (EmojicodeInteger)mantissa);
+        return true;
+    }
+    //Both the mantissa and the power of ten are exact doubles, so a single multiplication or division rounds correctly
+    if (!truncated && mantissa <= (1ULL << 53) && -22 <= exponent && exponent <= 22) {
+        double d = (double)mantissa;
+        d = exponent < 0 ? d / powersOfTen[-exponent] : d * powersOfTen[exponent];
+        *value = somethingDouble(negative ? -d : d);
+        return true;
+    }
+
+    char buffer[64];
+    size_t size = i - start;
+    char *number = size < sizeof(buffer) ? buffer : malloc(size + 1);
+    for (size_t j = 0; j < size; j++) {
+        number[j] = (char)jsonCharacter(parser, start + j);
+    }
+    number[size] = 0;
+    *value = somethingDouble(strtod(number, NULL));
+    if (number != buffer) {
+        free(number);
+    }
+    return true;
+}
+
+static bool jsonLiteral(JSONParser *parser, const char *literal, Something literalValue, Something *value){
+    for (; *literal; literal++) {
+        if (jsonCharacter(parser, parser->position++) != (EmojicodeChar)*literal) {
+            return false;
+        }
+    }
+    *value = literalValue;
+    return true;
+}
+
+static bool jsonValue(JSONParser *parser, Something *value);
+
+/**
+ * Parses the array at the current position. The list is presized to the number of elements counted by the first stage.
+ * @warning GC-invoking
+ */
+static bool jsonArray(JSONParser *parser, Something *value){
+    Thread *thread = parser->thread;
+    size_t commas = parser->structurals[parser->next].extra;
+    jsonConsumeStructural(parser);
+
+    stackPush(stackGetThis(thread), 1, 0, thread);
+    stackSetVariable(0, somethingObject(newObject(CL_LIST)), thread);
+    if (jsonSkipWhitespace(parser) == ']') {
+        jsonConsumeStructural(parser);
+        *value = stackGetVariable(0, thread);
+        stackPop(thread);
+        return true;
+    }
+
+    stackPush(stackGetVariable(0, thread).object, 0, 0, thread);
+    listEnsureCapacity(thread, commas + 1);
+    stackPop(thread);
+    jsonRefresh(parser);
+
+    while (true) {
+        Something element;
+        if (!jsonValue(parser, &element)) {
+            return false;
+        }
+        listAppend(stackGetVariable(0, thread).object, element, thread);
+        jsonRefresh(parser);
+
+        EmojicodeChar c = jsonSkipWhitespace(parser);
+        if (c == ']') {
+            break;
+        }
+        if (c != ',') {
+            return false;
+        }
+        jsonConsumeStructural(parser);
+    }
+    jsonConsumeStructural(parser);
+    *value = stackGetVariable(0, thread);
+    stackPop(thread);
+    return true;
+}
+
+/**
+ * Parses the object at the current position into a presized dictionary.
+ * @warning GC-invoking
+ */
+static bool jsonObject(JSONParser *parser, Something *value){
+    Thread *thread = parser->thread;
+    size_t commas = parser->structurals[parser->next].extra;
+    jsonConsumeStructural(parser);
+
+    stackPush(newObject(CL_DICTIONARY), 0, 0, thread);
+    dictionaryInit(thread);
+    Object *dictionary = stackGetThis(thread);
+    stackPop(thread);
+    stackPush(stackGetThis(thread), 2, 0, thread);
+    stackSetVariable(0, somethingObject(dictionary), thread);
+    jsonRefresh(parser);
+
+    if (jsonSkipWhitespace(parser) == '}') {
+        jsonConsumeStructural(parser);
+        *value = stackGetVariable(0, thread);
+        stackPop(thread);
+        return true;
+    }
+
+    dictionaryReserve(stackGetVariable(0, thread).object, commas + 1, thread);
+    jsonRefresh(parser);
+
+    while (true) {
+        Something key, element;
+        if (jsonSkipWhitespace(parser) != '"' || !jsonString(parser, &key)) {
+            return false;
+        }
+        stackSetVariable(1, key, thread);
+        if (jsonSkipWhitespace(parser) != ':') {
+            return false;
+        }
+        jsonConsumeStructural(parser);
+        if (!jsonValue(parser, &element)) {
+            return false;
+        }
+        dictionarySet(stackGetVariable(0, thread).object, stackGetVariable(1, thread), element, thread);
+        jsonRefresh(parser);
+
+        EmojicodeChar c = jsonSkipWhitespace(parser);
+        if (c == '}') {
+            break;
+        }
+        if (c != ',') {
+            return false;
+        }
+        jsonConsumeStructural(parser);
+    }
+    jsonConsumeStructural(parser);
+    *value = stackGetVariable(0, thread);
+    stackPop(thread);
+    return true;
+}
+
+/**
+ * Parses the value at the current position.
+ * @warning GC-invoking
+ */
+static bool jsonValue(JSONParser *parser, Something *value){
+    switch (jsonSkipWhitespace(parser)) {
+        case '"':
+            return jsonString(parser, value);
+        case '[':
+            return jsonArray(parser, value);
+        case '{':
+            return jsonObject(parser, value);
+        case 't':
+            return jsonLiteral(parser, "true", EMOJICODE_TRUE, value);
+        case 'f':
+            return jsonLiteral(parser, "false", EMOJICODE_FALSE, value);
+        case 'n':
+            return jsonLiteral(parser, "null", NOTHINGNESS, value);
+        default:
+            return jsonNumber(parser, value);
+    }
+}
+
+Something parseJSON(Thread *thread) {
+    String *string = stackGetThis(thread)->value;
+    if (string->length > UINT32_MAX) {
+        return NOTHINGNESS;
+    }
+
+    JSONParser parser = {
+        .thread = thread,
+        .characters = stringCharacters(string),
+        .compact = string->compact,
+        .length = string->length,
+    };
+
+    uint32_t *indices = malloc((parser.length + 1) * sizeof(uint32_t));
+    size_t count;
+    if (parser.compact) {
+        count = stringKernels.jsonStructuralsCompact(parser.characters, parser.length, indices);
+    }
+    else {
+        count = stringKernels.jsonStructuralsWide(parser.characters, parser.length, indices);
+    }
+    parser.structurals = malloc((count + 1) * sizeof(JSONStructural));
+    bool valid = jsonReduceStructurals(&parser, indices, count);
+    free(indices);
+
+    Something value = NOTHINGNESS;
+    if (valid) {
+        StackState s = storeStackState(thread);
+        valid = jsonValue(&parser, &value) && jsonSkipWhitespace(&parser) == 0 && parser.position >= parser.length;
+        if (!valid) {
+            restoreStackState(s, thread);
+        }
+    }
+
+    free(parser.structurals);
+    free(parser.buffer);
+    return valid ? value : NOTHINGNESS;
+}
+
+//MARK: Serializing
+
+typedef struct {
+    char *bytes;
+    size_t size;
+    size_t capacity;
+    bool pretty;
+    /** The number of arrays and objects the value being written is in. */
+    size_t depth;
+} JSONOutput;
+
+/** Grows the buffer. */
+static bool jsonFlush(JSONOutput *out){
+    char *bytes = realloc(out->bytes, out->capacity * 2);
+    if (bytes == NULL) {
+        return false;
+    }
+    out->bytes = bytes;
+    out->capacity *= 2;
+    return true;
+}
+
+/**
+ * Returns a pointer to room for @c size bytes, which must be small, in the buffer or @c NULL if flushing failed.
+ * Increment @c size of @c out by the number of bytes written.
+ */
+static inline char* jsonRoom(JSONOutput *out, size_t size){
+    while (out->capacity - out->size < size) {
+        if (!jsonFlush(out)) {
+            return NULL;
+        }
+    }
+    return out->bytes + out->size;
+}
+
+static bool jsonAppend(JSONOutput *out, const void *bytes, size_t size){
+    while (out->capacity - out->size < size) {
+        size_t room = out->capacity - out->size;
+        memcpy(out->bytes + out->size, bytes, room);
+        out->size += room;
+        bytes = (const char *)bytes + room;
+        size -= room;
+        if (!jsonFlush(out)) {
+            return false;
+        }
+    }
+    memcpy(out->bytes + out->size, bytes, size);
+    out->size += size;
+    return true;
+}
+
+/** Starts a new line indented by the current depth if pretty printing. */
+static bool jsonNewline(JSONOutput *out, size_t depth){
+    if (!out->pretty) {
+        return true;
+    }
+    static const char spaces[] = "\n                                                               ";
+    if (!jsonAppend(out, spaces, 1)) {
+        return false;
+    }
+    for (size_t indentation = depth * 2; indentation > 0;) {
+        size_t n = indentation < sizeof(spaces) - 2 ? indentation : sizeof(spaces) - 2;
+        if (!jsonAppend(out, spaces + 1, n)) {
+            return false;
+        }
+        indentation -= n;
+    }
+    return true;
+}
+
+/** Writes a code point that is not plain, i.e. that must be escaped or encoded in multiple bytes. */
+static bool jsonWriteSpecialCharacter(JSONOutput *out, EmojicodeChar c){
+    char *b = jsonRoom(out, 6);
+    if (b == NULL) {
+        return false;
+    }
+    char escape = 0;
+    switch (c) {
+        case '"': escape = '"'; break;
+        case '\\': escape = '\\'; break;
+        case '\b': escape = 'b'; break;
+        case '\f': escape = 'f'; break;
+        case '\n': escape = 'n'; break;
+        case '\r': escape = 'r'; break;
+        case '\t': escape = 't'; break;
+    }
+    if (escape) {
+        b[0] = '\\';
+        b[1] = escape;
+        out->size += 2;
+    }
+    else if (c < 0x20) {
+        static const char hex[] = "0123456789abcdef";
+        memcpy(b, "\\u00", 4);
+        b[4] = hex[c >> 4];
+        b[5] = hex[c & 0xF];
+        out->size += 6;
+    }
+    else {
+        out->size += u8_wc_toutf8(b, c);
+    }
+    return true;
+}
+
+/** Writes @c string in quotes. Runs of plain ASCII are copied as a whole. */
+static bool jsonWriteString(JSONOutput *out, String *string){
+    if (!jsonAppend(out, "\"", 1)) {
+        return false;
+    }
+    size_t length = string->length;
+    if (string->compact) {
+        const unsigned char *characters = stringCharacters(string);
+        for (size_t i = 0; i < length; i++) {
+            size_t plain = stringKernels.jsonPlainLengthCompact(characters + i, length - i);
+            if (!jsonAppend(out, characters + i, plain)) {
+                return false;
+            }
+            i += plain;
+            if (i < length && !jsonWriteSpecialCharacter(out, characters[i])) {
+                return false;
+            }
+        }
+    }
+    else {
+        const EmojicodeChar *characters = stringCharacters(string);
+        for (size_t i = 0; i < length; i++) {
+            size_t plain = stringKernels.jsonPlainLengthWide(characters + i, length - i);
+            while (plain > 0) {
+                if (out->size == out->capacity && !jsonFlush(out)) {
+                    return false;
+                }
+                size_t room = out->capacity - out->size;
+                size_t n = plain < room ? plain : room;
+                out->size += stringKernels.narrowASCII((unsigned char *)out->bytes + out->size, characters + i, n);
+                i += n;
+                plain -= n;
+            }
+            if (i < length && !jsonWriteSpecialCharacter(out, characters[i])) {
+                return false;
+            }
+        }
+    }
+    return jsonAppend(out, "\"", 1);
+}
+
+static bool jsonWriteInteger(JSONOutput *out, EmojicodeInteger integer){
+    char *b = jsonRoom(out, 20);
+    if (b == NULL) {
+        return false;
+    }
+    char digits[20];
+    size_t count = 0;
+    uint64_t u = integer < 0 ? -(uint64_t)integer : (uint64_t)integer;
+    do {
+        digits[count++] = '0' + u % 10;
+        u /= 10;
+    } while (u);
+    if (integer < 0) {
+        *b++ = '-';
+        out->size++;
+    }
+    for (size_t i = 0; i < count; i++) {
+        b[i] = digits[count - 1 - i];
+    }
+    out->size += count;
+    return true;
+}
+
+/**
+ * Writes the shortest of the 15 and 17 digit representations of @c d that parses back to @c d. A fraction is added to
+ * integral values so that they are parsed as 🚀 again.
+ */
+static bool jsonWriteDouble(JSONOutput *out, double d){
+    //-Ofast assumes all doubles are finite, so isfinite cannot be used
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    if ((bits >> 52 & 0x7FF) == 0x7FF) {
+        return false;
+    }
+    char *b = jsonRoom(out, 32);
+    if (b == NULL) {
+        return false;
+    }
+    int n = snprintf(b, 32, "%.15g", d);
+    if (strtod(b, NULL) != d) {
+        n = snprintf(b, 32, "%.17g", d);
+    }
+    if (strpbrk(b, ".e") == NULL) {
+        memcpy(b + n, ".0", 2);
+        n += 2;
+    }
+    out->size += n;
+    return true;
+}
+
+static bool jsonWriteValue(JSONOutput *out, Something value);
+
+static bool jsonWriteList(JSONOutput *out, List *list){
+    if (!jsonAppend(out, "[", 1)) {
+        return false;
+    }
+    out->depth++;
+    for (size_t i = 0; i < list->count; i++) {
+        if ((i > 0 && !jsonAppend(out, ",", 1)) || !jsonNewline(out, out->depth) ||
+            !jsonWriteValue(out, listItemAt(list, i))) {
+            return false;
+        }
+    }
+    out->depth--;
+    if (list->count > 0 && !jsonNewline(out, out->depth)) {
+        return false;
+    }
+    return jsonAppend(out, "]", 1);
+}
+
+/** Writes the items of @c dict in insertion order. All keys must be strings. */
+static bool jsonWriteDictionary(JSONOutput *out, EmojicodeDictionary *dict){
+    if (!jsonAppend(out, "{", 1)) {
+        return false;
+    }
+    out->depth++;
+    bool first = true;
+    for (size_t i = 0; dict->size > 0 && i < dict->entriesCount; i++) {
+        EmojicodeDictionaryEntry *entry = dictionaryEntries(dict) + i;
+        if (isNothingness(entry->key)) {
+            continue;
+        }
+        if (entry->key.type != T_OBJECT || entry->key.object->class != CL_STRING) {
+            return false;
+        }
+        if ((!first && !jsonAppend(out, ",", 1)) || !jsonNewline(out, out->depth) ||
+            !jsonWriteString(out, entry->key.object->value) ||
+            !jsonAppend(out, ": ", out->pretty ? 2 : 1) || !jsonWriteValue(out, entry->value)) {
+            return false;
+        }
+        first = false;
+    }
+    out->depth--;
+    if (!first && !jsonNewline(out, out->depth)) {
+        return false;
+    }
+    return jsonAppend(out, "}", 1);
+}
+
+static bool jsonWriteValue(JSONOutput *out, Something value){
+    switch (value.type) {
+        case T_INTEGER:
+            return jsonWriteInteger(out, value.raw);
+        case T_DOUBLE:
+            return jsonWriteDouble(out, value.doubl);
+        case T_BOOLEAN:
+            return unwrapBool(value) ? jsonAppend(out, "true", 4) : jsonAppend(out, "false", 5);
+        case T_OBJECT:
+            if (value.object == NULL) {
+                return jsonAppend(out, "null", 4);
+            }
+            if (value.object->class == CL_STRING) {
+                return jsonWriteString(out, value.object->value);
+            }
+            //The depth limit also stops lists and dictionaries that contain themselves
+            if (out->depth == jsonMaxDepth) {
+                return false;
+            }
+            if (value.object->class == CL_LIST) {
+                return jsonWriteList(out, value.object->value);
+            }
+            if (value.object->class == CL_DICTIONARY) {
+                return jsonWriteDictionary(out, value.object->value);
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+char* serializeJSON(Something value, bool pretty, size_t *size){
+    JSONOutput out = {
+        .bytes = malloc(256),
+        .capacity = 256,
+        .pretty = pretty,
+    };
+    if (out.bytes == NULL || !jsonWriteValue(&out, value)) {
+        free(out.bytes);
+        return NULL;
+    }
+    *size = out.size;
+    return out.bytes;
+}
+
+Something serializeJSONData(Something value, bool pretty, Thread *thread){
+    size_t size;
+    char *bytes = serializeJSON(value, pretty, &size);
+    Something data = NOTHINGNESS;
+    if (bytes) {
+        Object *bytesObject = newArray(size);
+        memcpy(bytesObject->value, bytes, size);
+        stackPush(bytesObject, 0, 0, thread);
+
+        Object *o = newObject(CL_DATA);
+        Data *d = o->value;
+        d->length = size;
+        d->bytesObject = stackGetThis(thread);
+        d->bytes = d->bytesObject->value;
+        stackPop(thread);
+        data = somethingObject(o);
+    }
+    free(bytes);
+    return data;
+}
+
+//MARK: Reading
+
+/*
+ * A 🗞 reads JSON token by token from a 📇 or from the 📇 objects a callable returns one after another, so that only
+ * the current 📇 and the text of the last token are held in memory. Top-level values may follow each other, which
+ * allows reading JSON Lines. The UTF-8 is never transcoded, the text of a key or string is only decoded into a 🔡 if
+ * it is asked for.
+ */
+
+/** The tokens in the order of the values of 🚦. */
+typedef enum {
+    JSONTokenEnd, JSONTokenObjectStart, JSONTokenObjectEnd, JSONTokenArrayStart, JSONTokenArrayEnd, JSONTokenKey,
+    JSONTokenString, JSONTokenInteger, JSONTokenDouble, JSONTokenBoolean, JSONTokenNull, JSONTokenError
+} JSONToken;
+
+typedef enum {
+    /** The next top-level value or the end of the input. */
+    JSONExpectTopLevel,
+    JSONExpectValue,
+    JSONExpectValueOrArrayEnd,
+    JSONExpectKey,
+    JSONExpectKeyOrObjectEnd,
+    JSONExpectColon,
+    JSONExpectCommaOrEnd,
+    /** The input is invalid, every further token is an error. */
+    JSONExpectNothing
+} JSONReaderState;
+
+static inline JSONReader* jsonReader(Thread *thread){
+    return stackGetThis(thread)->value;
+}
+
+/**
+ * Requests 📇 objects from the source until there is a byte left to read.
+ * @returns Whether there is a byte left or false at the end of the input.
+ * @warning GC-invoking
+ */
+static bool jsonReaderFill(Thread *thread){
+    JSONReader *reader = jsonReader(thread);
+    while (!reader->data || reader->position >= ((Data *)reader->data->value)->length) {
+        if (!reader->source) {
+            return false;
+        }
+        Something data = executeCallableExtern(reader->source, NULL, thread);
+        reader = jsonReader(thread);
+        if (isNothingness(data)) {
+            reader->source = NULL;
+            return false;
+        }
+        reader->data = data.object;
+        reader->position = 0;
+    }
+    return true;
+}
+
+/**
+ * Returns the byte at the current position or -1 at the end of the input.
+ * @warning GC-invoking
+ */
+static int jsonReaderPeek(Thread *thread){
+    if (!jsonReaderFill(thread)) {
+        return -1;
+    }
+    JSONReader *reader = jsonReader(thread);
+    return ((unsigned char *)((Data *)reader->data->value)->bytes)[reader->position];
+}
+
+/**
+ * Consumes and returns the byte at the current position or returns -1 at the end of the input.
+ * @warning GC-invoking
+ */
+static int jsonReaderByte(Thread *thread){
+    int c = jsonReaderPeek(thread);
+    if (c >= 0) {
+        jsonReader(thread)->position++;
+    }
+    return c;
+}
+
+/**
+ * Makes room for @c size more bytes of text.
+ * @warning GC-invoking
+ */
+static void jsonReaderReserve(size_t size, Thread *thread){
+    JSONReader *reader = jsonReader(thread);
+    size_t capacity = reader->text ? reader->text->size - sizeof(Object) : 0;
+    if (reader->textLength + size <= capacity) {
+        return;
+    }
+    capacity = capacity < 64 ? 64 : capacity * 2;
+    while (capacity < reader->textLength + size) {
+        capacity *= 2;
+    }
+    Object *text = reader->text ? resizeArray(reader->text, capacity) : newArray(capacity);
+    jsonReader(thread)->text = text;
+}
+
+/**
+ * Appends @c size bytes to the text, which must not be in the object heap.
+ * @warning GC-invoking
+ */
+static void jsonReaderAppend(const char *bytes, size_t size, Thread *thread){
+    jsonReaderReserve(size, thread);
+    JSONReader *reader = jsonReader(thread);
+    memcpy((char *)reader->text->value + reader->textLength, bytes, size);
+    reader->textLength += size;
+}
+
+/**
+ * Appends the following bytes to the text as long as @c accept returns true for them.
+ * @warning GC-invoking
+ */
+static void jsonReaderCollect(bool (*accept)(int c), Thread *thread){
+    int c;
+    while ((c = jsonReaderPeek(thread)) >= 0 && accept(c)) {
+        char byte = (char)c;
+        jsonReaderAppend(&byte, 1, thread);
+        jsonReader(thread)->position++;
+    }
+}
+
+/**
+ * Decodes the escape sequence after a backslash into the text.
+ * @warning GC-invoking
+ */
+static bool jsonReaderEscape(Thread *thread){
+    EmojicodeChar c;
+    switch (jsonReaderByte(thread)) {
+        case '"': c = '"'; break;
+        case '\\': c = '\\'; break;
+        case '/': c = '/'; break;
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case 'n': c = '\n'; break;
+        case 'r': c = '\r'; break;
+        case 't': c = '\t'; break;
+        case 'u': {
+            //Read the digits of a possible surrogate pair and let the parser’s helper decode them
+            char digits[10];
+            JSONParser parser = { .characters = digits, .compact = true, .length = sizeof(digits) };
+            for (size_t i = 0; i < 4; i++) {
+                digits[i] = (char)jsonReaderByte(thread);
+            }
+            if (!jsonHexDigits(&parser, 0, &c)) {
+                return false;
+            }
+            if (0xD800 <= c && c <= 0xDBFF) {
+                EmojicodeChar low;
+                for (size_t i = 4; i < 10; i++) {
+                    digits[i] = (char)jsonReaderByte(thread);
                 }
-            case JSON_EXPONENT:
-            case JSON_EXPONENT_NEGATIVE:
-                stackCurrent->state++;
-                if (c == '+') continue;
-            case JSON_EXPONENT_NO_PLUS:
-            case JSON_EXPONENT_NO_PLUS_NEGATIVE:
-                stackCurrent->state++;
-                pushTheStack();
-            case JSON_EXPONENT_BACK_VALUE:
-            case JSON_EXPONENT_BACK_VALUE_NEGATIVE:
-                if (backValue.type != T_INTEGER) {
-                    errorExit();
+                if (digits[4] != '\\' || digits[5] != 'u' || !jsonHexDigits(&parser, 6, &low) ||
+                    low < 0xDC00 || 0xDFFF < low) {
+                    return false;
+                }
+                c = (c << 10) + low + 0x10000 - (0xD800 << 10) - 0xDC00;
+            }
+            break;
+        }
+        default:
+            return false;
+    }
+    char utf8[4];
+    jsonReaderAppend(utf8, u8_wc_toutf8(utf8, c), thread);
+    return true;
+}
+
+/**
+ * Reads the rest of the string whose opening quote was consumed into the text. Runs of bytes that need no decoding
+ * are copied from the 📇 as a whole.
+ * @warning GC-invoking
+ */
+static bool jsonReaderString(Thread *thread){
+    while (jsonReaderFill(thread)) {
+        JSONReader *reader = jsonReader(thread);
+        Data *data = reader->data->value;
+        const unsigned char *bytes = (const unsigned char *)data->bytes;
+        EmojicodeInteger end = reader->position;
+        while (end < data->length && bytes[end] != '"' && bytes[end] != '\\' && bytes[end] >= 0x20) {
+            end++;
+        }
+        size_t run = end - reader->position;
+        if (run > 0) {
+            jsonReaderReserve(run, thread);
+            reader = jsonReader(thread);
+            data = reader->data->value;
+            memcpy((char *)reader->text->value + reader->textLength, data->bytes + reader->position, run);
+            reader->textLength += run;
+            reader->position = end;
+        }
+        if (end == data->length) {
+            continue;
+        }
+        unsigned char c = (unsigned char)data->bytes[reader->position++];
+        if (c == '"') {
+            return true;
+        }
+        if (c != '\\' || !jsonReaderEscape(thread)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+static bool jsonReaderIsNumberByte(int c){
+    return jsonIsDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+static bool jsonReaderIsLiteralByte(int c){
+    return 'a' <= c && c <= 'z';
+}
+
+static inline void jsonReaderValueRead(JSONReader *reader){
+    reader->state = reader->depth == 0 ? JSONExpectTopLevel : JSONExpectCommaOrEnd;
+}
+
+/**
+ * Reads a number and parses it like the parser does.
+ * @warning GC-invoking
+ */
+static JSONToken jsonReaderNumber(Thread *thread){
+    jsonReaderCollect(jsonReaderIsNumberByte, thread);
+    JSONReader *reader = jsonReader(thread);
+    JSONParser parser = { .characters = reader->text->value, .compact = true, .length = reader->textLength };
+    if (!jsonNumber(&parser, &reader->value) || parser.position != parser.length) {
+        return JSONTokenError;
+    }
+    jsonReaderValueRead(reader);
+    return reader->value.type == T_INTEGER ? JSONTokenInteger : JSONTokenDouble;
+}
+
+/**
+ * Reads true, false or null.
+ * @warning GC-invoking
+ */
+static JSONToken jsonReaderLiteral(Thread *thread){
+    jsonReaderCollect(jsonReaderIsLiteralByte, thread);
+    JSONReader *reader = jsonReader(thread);
+    const char *text = reader->text->value;
+    size_t length = reader->textLength;
+    reader->textLength = 0;
+    jsonReaderValueRead(reader);
+    if (length == 4 && memcmp(text, "true", 4) == 0) {
+        reader->value = EMOJICODE_TRUE;
+        return JSONTokenBoolean;
+    }
+    if (length == 5 && memcmp(text, "false", 5) == 0) {
+        reader->value = EMOJICODE_FALSE;
+        return JSONTokenBoolean;
+    }
+    if (length == 4 && memcmp(text, "null", 4) == 0) {
+        return JSONTokenNull;
+    }
+    return JSONTokenError;
+}
+
+/**
+ * Reads the value starting with the byte @c c at the current position.
+ * @warning GC-invoking
+ */
+static JSONToken jsonReaderValue(int c, Thread *thread){
+    JSONReader *reader = jsonReader(thread);
+    switch (c) {
+        case '{':
+        case '[':
+            if (reader->depth == jsonMaxDepth) {
+                return JSONTokenError;
+            }
+            reader->position++;
+            reader->objects[reader->depth++] = c == '{';
+            reader->state = c == '{' ? JSONExpectKeyOrObjectEnd : JSONExpectValueOrArrayEnd;
+            return c == '{' ? JSONTokenObjectStart : JSONTokenArrayStart;
+        case '"':
+            reader->position++;
+            if (!jsonReaderString(thread)) {
+                return JSONTokenError;
+            }
+            jsonReaderValueRead(jsonReader(thread));
+            return JSONTokenString;
+        case 't':
+        case 'f':
+        case 'n':
+            return jsonReaderLiteral(thread);
+        default:
+            if (c == '-' || jsonIsDigit(c)) {
+                return jsonReaderNumber(thread);
+            }
+            return JSONTokenError;
+    }
+}
+
+/** Consumes the closing bracket of the innermost array or object. */
+static JSONToken jsonReaderClose(JSONReader *reader){
+    reader->position++;
+    bool object = reader->objects[--reader->depth];
+    jsonReaderValueRead(reader);
+    return object ? JSONTokenObjectEnd : JSONTokenArrayEnd;
+}
+
+/**
+ * Reads the next token.
+ * @warning GC-invoking
+ */
+static JSONToken jsonReaderRead(Thread *thread){
+    while (true) {
+        int c;
+        while (jsonIsWhitespace(c = jsonReaderPeek(thread))) {
+            jsonReader(thread)->position++;
+        }
+        JSONReader *reader = jsonReader(thread);
+        reader->textLength = 0;
+        switch (reader->state) {
+            case JSONExpectTopLevel:
+                if (c < 0) {
+                    return JSONTokenEnd;
                 }
-                double x = doubleRawValue() * pow(10, backValue.raw);
-                backValue = somethingDouble(x);
-            case JSON_ARRAY_FIRST:
-                stackCurrent->state = JSON_ARRAY;
+                return jsonReaderValue(c, thread);
+            case JSONExpectValue:
+                return jsonReaderValue(c, thread);
+            case JSONExpectValueOrArrayEnd:
                 if (c == ']') {
-                    returnArray();
+                    return jsonReaderClose(reader);
                 }
-            case JSON_ARRAY:
-                i--;
-                stackCurrent->state = JSON_ARRAY_BACK_VALUE;
-                pushTheStack();
-            case JSON_ARRAY_BACK_VALUE:
-                listAppend(stackGetVariable(0, thread).object, backValue, thread);
-                stackCurrent->state = JSON_ARRAY_NEXT;
-                i--;
-                continue;
-            case JSON_ARRAY_NEXT:
-                switch (c) {
-                    case ',':
-                        stackCurrent->state = JSON_ARRAY;
-                        continue;
-                    case ']':
-                        returnArray();
-                        whitespaceCase
-                        continue;
-                    default:
-                        errorExit();
+                return jsonReaderValue(c, thread);
+            case JSONExpectKeyOrObjectEnd:
+                if (c == '}') {
+                    return jsonReaderClose(reader);
                 }
-            case JSON_OBJECT_KEY:
-                i--;
-                stackCurrent->state = JSON_OBJECT_KEY_BACK_VALUE;
-                pushTheStack();
-            case JSON_OBJECT_KEY_BACK_VALUE:
-                if (backValue.type != T_OBJECT || backValue.object->class != CL_STRING) {
-                    errorExit();
+                //Fall through - otherwise a key must follow
+            case JSONExpectKey:
+                if (c != '"') {
+                    return JSONTokenError;
                 }
-                stackSetVariable(1, backValue, thread);
-                stackCurrent->state = JSON_OBJECT_COLON;
-                i--;
-                continue;
-            case JSON_OBJECT_COLON:
-                switch (c) {
-                    case ':':
-                        stackCurrent->state = JSON_OBJECT_VALUE_BACK_VALUE;
-                        pushTheStack();
-                    whitespaceCase
-                        continue;
-                    default:
-                        errorExit();
+                reader->position++;
+                if (!jsonReaderString(thread)) {
+                    return JSONTokenError;
                 }
-            case JSON_OBJECT_VALUE_BACK_VALUE:
-                dictionarySet(stackGetVariable(0, thread).object, stackGetVariable(1, thread).object, backValue, thread);
-                stackCurrent->state = JSON_OBJECT_NEXT;
-                i--;
-                continue;
-            case JSON_OBJECT_NEXT:
-                switch (c) {
-                    case ',':
-                        stackCurrent->state = JSON_OBJECT_KEY;
-                        continue;
-                    case '}':
-                        backValue = stackGetVariable(0, thread);
-                        stackPop(thread);
-                        popTheStack();
-                        whitespaceCase
-                        continue;
-                    default:
-                        errorExit();
+                jsonReader(thread)->state = JSONExpectColon;
+                return JSONTokenKey;
+            case JSONExpectColon:
+                if (c != ':') {
+                    return JSONTokenError;
                 }
-            upgrade(JSON_TRUE_T, R, 'r')
-            upgrade(JSON_TRUE_TR, U, 'u')
-            upgradeReturn(JSON_TRUE_TRU, 'e', EMOJICODE_TRUE)
-            upgrade(JSON_FALSE_F, A, 'a')
-            upgrade(JSON_FALSE_FA, L, 'l')
-            upgrade(JSON_FALSE_FAL, S, 's')
-            upgradeReturn(JSON_FALSE_FALS, 'e', EMOJICODE_FALSE)
-            upgrade(JSON_NULL_N, U, 'u')
-            upgrade(JSON_NULL_NU, L, 'l')
-            upgradeReturn(JSON_NULL_NUL, 'l', NOTHINGNESS)
-            case JSON_NONE:
-                switch (c) {
-                    case '"':
-                        stackCurrent->state = JSON_STRING;
-                        stackPush(stackGetThis(thread), 2, 0, thread);
-                        Object *string = newObject(CL_LIST);
-                        stackSetVariable(0, somethingObject(string), thread);
-                        break;
-                    case '{':
-                        stackCurrent->state = JSON_OBJECT_KEY;
-                        stackPush(newObject(CL_DICTIONARY), 0, 0, thread);
-                        dictionaryInit(thread);
-                        Object *o = stackGetThis(thread);
-                        stackPop(thread);
-                        stackPush(stackGetThis(thread), 2, 0, thread);
-                        stackSetVariable(0, somethingObject(o), thread);
-                        break;
-                    case '[':
-                        stackCurrent->state = JSON_ARRAY_FIRST;
-                        stackPush(stackGetThis(thread), 1, 0, thread);
-                        stackSetVariable(0, somethingObject(newObject(CL_LIST)), thread);
-                        break;
-                    case 't':
-                        stackCurrent->state = JSON_TRUE_T;
-                        break;
-                    case 'f':
-                        stackCurrent->state = JSON_FALSE_F;
-                        break;
-                    case 'n':
-                        stackCurrent->state = JSON_NULL_N;
-                        break;
-                    case '-':
-                        stackCurrent->state = JSON_NUMBER_NEGATIVE;
-                        stackCurrent->integer = 0;
-                        break;
-                    case '0':
-                    case '1':
-                    case '2':
-                    case '3':
-                    case '4':
-                    case '5':
-                    case '6':
-                    case '7':
-                    case '8':
-                    case '9':
-                        stackCurrent->state = JSON_NUMBER;
-                        stackCurrent->integer = c - '0';
-                        break;
-                    whitespaceCase
-                        continue;
-                    default:
-                        errorExit();
+                reader->position++;
+                reader->state = JSONExpectValue;
+                break;
+            case JSONExpectCommaOrEnd: {
+                bool object = reader->objects[reader->depth - 1];
+                if (c == ',') {
+                    reader->position++;
+                    reader->state = object ? JSONExpectKey : JSONExpectValue;
+                    break;
+                }
+                if (c == (object ? '}' : ']')) {
+                    return jsonReaderClose(reader);
                 }
+                return JSONTokenError;
+            }
+            default:
+                return JSONTokenError;
         }
     }
-    
-    if (stackCurrent == stack) {
-        switch (stackCurrent->state) {
-            case JSON_DOUBLE:
-            case JSON_DOUBLE_NEGATIVE:
-                return doubleValue();
-            case JSON_NUMBER:
-            case JSON_NUMBER_NEGATIVE:
-                return integerValue();
-            default:
-                break;
+}
+
+/**
+ * Reads the next token and remembers it. After an error the reader stays in the error state.
+ * @warning GC-invoking
+ */
+static JSONToken jsonReaderNext(Thread *thread){
+    JSONToken token = jsonReaderRead(thread);
+    JSONReader *reader = jsonReader(thread);
+    if (token == JSONTokenError) {
+        reader->state = JSONExpectNothing;
+        reader->textLength = 0;
+    }
+    reader->token = token;
+    return token;
+}
+
+static Something jsonReaderNextBridge(Thread *thread){
+    return somethingInteger(jsonReaderNext(thread));
+}
+
+/** Skips the rest of the array or object the last token started. */
+static Something jsonReaderSkip(Thread *thread){
+    JSONReader *reader = jsonReader(thread);
+    if (reader->token != JSONTokenObjectStart && reader->token != JSONTokenArrayStart) {
+        return NOTHINGNESS;
+    }
+    size_t depth = reader->depth;
+    while (jsonReader(thread)->depth >= depth) {
+        JSONToken token = jsonReaderNext(thread);
+        if (token == JSONTokenError || token == JSONTokenEnd) {
+            break;
         }
     }
-    
-    if (stackCurrent < stack) {
-        return backValue;
+    return NOTHINGNESS;
+}
+
+static Something jsonReaderText(Thread *thread){
+    JSONReader *reader = jsonReader(thread);
+    if (reader->textLength == 0) {
+        return somethingObject(emptyString);
+    }
+    bool compact, valid;
+    EmojicodeInteger length = utf8Length(reader->text->value, reader->textLength, &compact, &valid);
+    Object *stro = jsonNewString(length, compact, thread);
+    reader = jsonReader(thread);
+    stringDecodeUTF8(stro->value, reader->text->value, reader->textLength);
+    return somethingObject(stro);
+}
+
+static Something jsonReaderInteger(Thread *thread){
+    JSONReader *reader = jsonReader(thread);
+    switch (reader->token) {
+        case JSONTokenInteger:
+            return reader->value;
+        case JSONTokenDouble:
+            // Converting a double outside the range of EmojicodeInteger is undefined.
+            if (reader->value.doubl >= -9223372036854775808.0 && reader->value.doubl < 9223372036854775808.0) {
+                return somethingInteger((EmojicodeInteger)reader->value.doubl);
+            }
+            break;
+    }
+    return somethingInteger(0);
+}
+
+static Something jsonReaderDouble(Thread *thread){
+    JSONReader *reader = jsonReader(thread);
+    switch (reader->token) {
+        case JSONTokenInteger:
+            return somethingDouble((double)reader->value.raw);
+        case JSONTokenDouble:
+            return reader->value;
+    }
+    return somethingDouble(0);
+}
+
+static Something jsonReaderBoolean(Thread *thread){
+    JSONReader *reader = jsonReader(thread);
+    return reader->token == JSONTokenBoolean ? reader->value : EMOJICODE_FALSE;
+}
+
+static Something jsonReaderDepth(Thread *thread){
+    return somethingInteger((EmojicodeInteger)jsonReader(thread)->depth);
+}
+
+static void jsonReaderInitData(Thread *thread){
+    jsonReader(thread)->data = stackGetVariable(0, thread).object;
+}
+
+static void jsonReaderInitSource(Thread *thread){
+    jsonReader(thread)->source = stackGetVariable(0, thread).object;
+}
+
+void jsonReaderMark(Object *self){
+    JSONReader *reader = self->value;
+    if (reader->data) {
+        mark(&reader->data);
+    }
+    if (reader->source) {
+        mark(&reader->source);
+    }
+    if (reader->text) {
+        mark(&reader->text);
+    }
+}
+
+MethodHandler jsonReaderMethodForName(EmojicodeChar name){
+    switch (name) {
+        case 0x1F51C: //🔜
+            return jsonReaderNextBridge;
+        case 0x1F648: //🙈
+            return jsonReaderSkip;
+        case 0x1F4DD: //📝
+            return jsonReaderText;
+        case 0x1F682: //🚂
+            return jsonReaderInteger;
+        case 0x1F680: //🚀
+            return jsonReaderDouble;
+        case 0x1F44C: //👌
+            return jsonReaderBoolean;
+        case 0x1F4CF: //📏
+            return jsonReaderDepth;
+    }
+    return NULL;
+}
+
+InitializerHandler jsonReaderInitializerForName(EmojicodeChar name){
+    switch (name) {
+        case 0x1F6B0: //🚰
+            return jsonReaderInitSource;
     }
-    
-    errorExit();
-}
\ No newline at end of file
+    return jsonReaderInitData;
+}
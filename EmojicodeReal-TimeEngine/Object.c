@@ -6,10 +6,13 @@
 //  Copyright (c) 2015 Theo Weidmann. All rights reserved.
 //
 
-#include "EmojicodeAPI.h"
 #include "Emojicode.h"
 #include <string.h>
 #include <pthread.h>
+#ifdef nativeBlockingLimit
+#include <dlfcn.h>
+#include <time.h>
+#endif
 
 size_t memoryUse = 0;
 bool zeroingNeeded = false;
@@ -23,6 +26,25 @@ pthread_mutex_t allocationMutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t pauseThreadsFalsedCondition = PTHREAD_COND_INITIALIZER;
 pthread_cond_t threadsCountCondition = PTHREAD_COND_INITIALIZER;
 
+/** Pauses all other threads and collects garbage. The caller must hold @c allocationMutex, it is held again after. */
+static void collectGarbage(){
+    pauseThreads = true;
+    pthread_mutex_unlock(&allocationMutex);
+    
+    pthread_mutex_lock(&pausingThreadsCountMutex);
+    pausingThreadsCount++;
+
+    while (pausingThreadsCount < threads) pthread_cond_wait(&threadsCountCondition, &pausingThreadsCountMutex);
+    gc();
+    
+    pausingThreadsCount--;
+    pthread_mutex_unlock(&pausingThreadsCountMutex);
+
+    pauseThreads = false;
+    pthread_cond_broadcast(&pauseThreadsFalsedCondition);
+    pthread_mutex_lock(&allocationMutex);
+}
+
 static void* emojicodeMalloc(size_t size){
     pthread_mutex_lock(&allocationMutex);
     pauseForGC(&allocationMutex);
@@ -31,21 +53,10 @@ static void* emojicodeMalloc(size_t size){
             error("Allocation of %zu bytes is too big. Try to enlarge the heap. (Heap size: %zu)", size, heapSize);
         }
         
-        pauseThreads = true;
-        pthread_mutex_unlock(&allocationMutex);
-        
-        pthread_mutex_lock(&pausingThreadsCountMutex);
-        pausingThreadsCount++;
-
-        while (pausingThreadsCount < threads) pthread_cond_wait(&threadsCountCondition, &pausingThreadsCountMutex);
-        gc();
-        
-        pausingThreadsCount--;
-        pthread_mutex_unlock(&pausingThreadsCountMutex);
-
-        pauseThreads = false;
-        pthread_cond_broadcast(&pauseThreadsFalsedCondition);
-        pthread_mutex_lock(&allocationMutex);
+        collectGarbage();
+        if (memoryUse + size > gcThreshold) {
+            error("Terminating program due to too high memory pressure.");
+        }
     }
     Byte *block = currentHeap + memoryUse;
     memoryUse += size;
@@ -53,17 +64,21 @@ static void* emojicodeMalloc(size_t size){
     return (void *)block;
 }
 
-static void* emojicodeRealloc(void *ptr, size_t oldSize, size_t newSize){
+static Object* emojicodeRealloc(Object *ptr, size_t oldSize, size_t newSize){
     pthread_mutex_lock(&allocationMutex);
     //Nothing has been allocated since the allocation of ptr
-    if (ptr == currentHeap + memoryUse - oldSize) {
+    if ((Byte *)ptr == currentHeap + memoryUse - oldSize && memoryUse + newSize - oldSize <= gcThreshold) {
         memoryUse += newSize - oldSize;
         pthread_mutex_unlock(&allocationMutex);
         return ptr;
     }
     pthread_mutex_unlock(&allocationMutex);
     
-    void *block = emojicodeMalloc(newSize);
+    Object *block = emojicodeMalloc(newSize);
+    if ((Byte *)ptr < currentHeap || (Byte *)ptr >= currentHeap + gcThreshold) {
+        //The allocation caused a garbage collection, which moved ptr
+        ptr = ptr->newLocation;
+    }
     memcpy(block, ptr, oldSize);
     return block;
 }
@@ -107,11 +122,14 @@ size_t sizeCalculationWithOverflowProtection(size_t items, size_t itemSize) {
     return r;
 }
 
+/** The class of all objects created by @c newArray. It has no marker and no deconstructor. */
+static Class arrayClass;
+
 Object* newArray(size_t size){
     size_t fullSize = sizeof(Object) + size;
     Object *object = emojicodeMalloc(fullSize);
     object->size = fullSize;
-    object->class = CL_STRING;  // Has no marker and no deconstructor.
+    object->class = &arrayClass;  // Has no marker and no deconstructor.
     object->value = ((Byte *)object) + sizeof(Object);
     
     return object;
@@ -154,6 +172,27 @@ void mark(Object **oPointer){
     }
 }
 
+bool markArraySlice(Object **oPointer, size_t offset, size_t size){
+    Object *o = *oPointer;
+    if (o->newLocation) {
+        *oPointer = o->newLocation;
+        return false;
+    }
+    
+    //o->newLocation stays NULL, other references to the array must not end up with the slice
+    Object *slice = (Object *)(currentHeap + memoryUse);
+    slice->size = sizeof(Object) + size;
+    memoryUse += slice->size;
+    
+    slice->class = o->class;
+    slice->newLocation = NULL;
+    slice->value = ((Byte *)slice) + sizeof(Object);
+    memcpy(slice->value, (Byte *)o->value + offset, size);
+    
+    *oPointer = slice;
+    return true;
+}
+
 void gc(){
     if (zeroingNeeded) {
         memset(otherHeap, 0, heapSize / 2);
@@ -193,13 +232,58 @@ void gc(){
         }
         currentObjectPointer += currentObject->size;
     }
-   
-    if (oldMemoryUse == memoryUse) {
-        error("Terminating program due to too high memory pressure.");
+}
+
+void forceGC(){
+    pthread_mutex_lock(&allocationMutex);
+    pauseForGC(&allocationMutex);
+    collectGarbage();
+    pthread_mutex_unlock(&allocationMutex);
+}
+
+#ifdef nativeBlockingLimit
+/** When the calling thread last let the GC run. */
+static _Thread_local struct timespec lastGCCheckpoint;
+/** The native function the calling thread runs or NULL. */
+static _Thread_local void *runningNative;
+
+/** Reports the running native function if the GC could not run for too long and starts the next interval. */
+static void gcCheckpoint(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long milliseconds = (now.tv_sec - lastGCCheckpoint.tv_sec) * 1000 +
+                        (now.tv_nsec - lastGCCheckpoint.tv_nsec) / 1000000;
+    if (runningNative && lastGCCheckpoint.tv_sec && milliseconds >= nativeBlockingLimit) {
+        Dl_info info;
+        if (dladdr(runningNative, &info) && info.dli_sname && info.dli_saddr == runningNative) {
+            fprintf(stderr, "⚠️ %s blocked the GC for %ld ms.\n", info.dli_sname, milliseconds);
+        }
+        else {
+            //Static functions have no symbol, the nearest one would be misleading
+            fprintf(stderr, "⚠️ The native function at %p in %s blocked the GC for %ld ms.\n", runningNative,
+                    dladdr(runningNative, &info) ? info.dli_fname : "?", milliseconds);
+        }
     }
+    lastGCCheckpoint = now;
+}
+
+void* nativeCallBegin(void *handler){
+    void *caller = runningNative;
+    gcCheckpoint();
+    runningNative = handler;
+    return caller;
+}
+
+void nativeCallEnd(void *caller){
+    gcCheckpoint();
+    runningNative = caller;
 }
+#endif
 
 void pauseForGC(pthread_mutex_t *mutex) {
+#ifdef nativeBlockingLimit
+    gcCheckpoint();
+#endif
     if (pauseThreads) {
         if (mutex) pthread_mutex_unlock(mutex);
         
@@ -215,6 +299,9 @@ void pauseForGC(pthread_mutex_t *mutex) {
 }
 
 void allowGC() {
+#ifdef nativeBlockingLimit
+    gcCheckpoint();
+#endif
     pthread_mutex_lock(&pausingThreadsCountMutex);
     pausingThreadsCount++;
     pthread_cond_signal(&threadsCountCondition);
@@ -227,6 +314,10 @@ void disallowGCAndPauseIfNeeded() {
     pausingThreadsCount--;
     pthread_cond_signal(&threadsCountCondition);
     pthread_mutex_unlock(&pausingThreadsCountMutex);
+#ifdef nativeBlockingLimit
+    //The time the GC was allowed does not count
+    clock_gettime(CLOCK_MONOTONIC, &lastGCCheckpoint);
+#endif
 }
 
 bool instanceof(Object *object, Class *class){
@@ -234,5 +325,6 @@ bool instanceof(Object *object, Class *class){
 }
 
 bool isPossibleObjectPointer(void *s){
-    return (Byte *)s < currentHeap + heapSize/2 && s >= (void *)currentHeap;
+    // Only called while collecting, at which point the objects still live in the other heap.
+    return (Byte *)s < otherHeap + heapSize/2 && s >= (void *)otherHeap;
 }
\ No newline at end of file
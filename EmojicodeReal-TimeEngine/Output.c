@@ -0,0 +1,189 @@
+//
+//  Output.c
+//  Emojicode
+//
+
+#include "Emojicode.h"
+#include "EmojicodeString.h"
+#include "EmojicodeList.h"
+#include <string.h>
+#include <errno.h>
+
+/** The number of bytes buffered before an output buffer is flushed. */
+#ifndef outputBufferSize
+#define outputBufferSize (64 * 1024)
+#endif
+
+struct OutputBuffer {
+    int fileDescriptor;
+    /** Whether the buffer is flushed after every line feed. */
+    bool lineBuffered;
+    /** Whether the buffer is flushed after every write. */
+    bool unbuffered;
+    pthread_mutex_t mutex;
+    size_t used;
+    char bytes[outputBufferSize];
+};
+
+static OutputBuffer standardOutputBuffer = {STDOUT_FILENO, false, false, PTHREAD_MUTEX_INITIALIZER};
+static OutputBuffer standardErrorBuffer = {STDERR_FILENO, false, true, PTHREAD_MUTEX_INITIALIZER};
+
+OutputBuffer *standardOutput = &standardOutputBuffer;
+OutputBuffer *standardError = &standardErrorBuffer;
+
+static void writeAll(int fileDescriptor, const char *bytes, size_t length){
+    while (length > 0) {
+        ssize_t written = write(fileDescriptor, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            //There is nobody we could report this to
+            return;
+        }
+        bytes += written;
+        length -= written;
+    }
+}
+
+static void outputFlushLocked(OutputBuffer *output){
+    writeAll(output->fileDescriptor, output->bytes, output->used);
+    output->used = 0;
+}
+
+/** Returns whether @c output must be flushed after writing something that contained a line feed if @c line is true. */
+static bool outputNeedsFlush(OutputBuffer *output, bool line){
+    return output->unbuffered || (output->lineBuffered && line);
+}
+
+/**
+ * Appends @c bytes, which must not be in the object heap, to @c output and flushes as required. The GC is allowed
+ * meanwhile, as the mutex might be held by another thread that waits for a slow pipe or file, and writing might block.
+ */
+static void outputWriteUnmoving(OutputBuffer *output, const void *bytes, size_t length, bool line){
+    allowGC();
+    pthread_mutex_lock(&output->mutex);
+    if (length > outputBufferSize - output->used) {
+        outputFlushLocked(output);
+    }
+    if (length > outputBufferSize) {
+        writeAll(output->fileDescriptor, bytes, length);
+    }
+    else {
+        memcpy(output->bytes + output->used, bytes, length);
+        output->used += length;
+    }
+    if (outputNeedsFlush(output, line)) {
+        outputFlushLocked(output);
+    }
+    pthread_mutex_unlock(&output->mutex);
+    disallowGCAndPauseIfNeeded();
+}
+
+/**
+ * Locks @c output if that does not block and returns whether @c length bytes can then be appended without flushing.
+ * If so the caller holds the mutex and can copy from the object heap right into the buffer.
+ */
+static bool outputTryAppend(OutputBuffer *output, size_t length, bool line){
+    if (pthread_mutex_trylock(&output->mutex) != 0) {
+        return false;
+    }
+    if (outputNeedsFlush(output, line) || length > outputBufferSize - output->used) {
+        pthread_mutex_unlock(&output->mutex);
+        return false;
+    }
+    return true;
+}
+
+void outputWrite(OutputBuffer *output, const void *bytes, size_t length){
+    if (length == 0) {
+        return;
+    }
+    bool line = output->lineBuffered && memchr(bytes, '\n', length) != NULL;
+    if (outputTryAppend(output, length, line)) {
+        memcpy(output->bytes + output->used, bytes, length);
+        output->used += length;
+        pthread_mutex_unlock(&output->mutex);
+        return;
+    }
+    //The bytes might be in the object heap, which the GC moves
+    char *copy = malloc(length);
+    memcpy(copy, bytes, length);
+    outputWriteUnmoving(output, copy, length, line);
+    free(copy);
+}
+
+void outputWriteString(OutputBuffer *output, String *string, bool newline){
+    size_t size = stringUTF8Size(string);
+    if (outputTryAppend(output, size + newline, newline)) {
+        //Transcode right into the buffer
+        output->used += stringEncodeUTF8(string, output->bytes + output->used);
+        if (newline) {
+            output->bytes[output->used++] = '\n';
+        }
+        pthread_mutex_unlock(&output->mutex);
+        return;
+    }
+    char *utf8 = malloc(size + 1);
+    stringEncodeUTF8(string, utf8);
+    utf8[size] = '\n';
+    outputWriteUnmoving(output, utf8, size + newline, newline);
+    free(utf8);
+}
+
+void outputWriteStringList(OutputBuffer *output, List *list){
+    if (list->count == 0) {
+        return;
+    }
+    size_t size = 0;
+    for (size_t i = 0; i < list->count; i++) {
+        size += stringUTF8Size(listItemAt(list, i).object->value) + 1;
+    }
+    char *utf8 = NULL;
+    char *bytes;
+    bool appending = outputTryAppend(output, size, true);
+    if (appending) {
+        bytes = output->bytes + output->used;
+    }
+    else {
+        bytes = utf8 = malloc(size);
+    }
+    
+    char *end = bytes;
+    for (size_t i = 0; i < list->count; i++) {
+        end += stringEncodeUTF8(listItemAt(list, i).object->value, end);
+        *end++ = '\n';
+    }
+    
+    if (appending) {
+        output->used += size;
+        pthread_mutex_unlock(&output->mutex);
+        return;
+    }
+    outputWriteUnmoving(output, utf8, size, true);
+    free(utf8);
+}
+
+void outputFlush(OutputBuffer *output){
+    allowGC();
+    pthread_mutex_lock(&output->mutex);
+    outputFlushLocked(output);
+    pthread_mutex_unlock(&output->mutex);
+    disallowGCAndPauseIfNeeded();
+}
+
+void outputFlushAtExit(OutputBuffer *output){
+    pthread_mutex_lock(&output->mutex);
+    outputFlushLocked(output);
+    pthread_mutex_unlock(&output->mutex);
+}
+
+static void outputFlushAll(void){
+    outputFlushAtExit(standardOutput);
+    outputFlushAtExit(standardError);
+}
+
+void outputInitialize(void){
+    standardOutputBuffer.lineBuffered = isatty(STDOUT_FILENO);
+    atexit(outputFlushAll);
+}
@@ -7,6 +7,7 @@
 //
 
 #include "Emojicode.h"
+#include "EmojicodeString.h"
 #include <string.h>
 #include <dlfcn.h>
 
@@ -269,19 +270,31 @@ ClassMethod* readBytecode(FILE *in, Class **cl){
     CL_CAPTURED_METHOD_CALL = classTable[5];
     CL_CLOSURE = classTable[6];
     CL_RANGE = classTable[7];
+    CL_DICTIONARY_ENUMERATOR = classTable[8];
     
     stringPoolCount = readUInt16(in);
     stringPool = malloc(sizeof(Object*) * stringPoolCount);
     for (uint16_t i = 0; i < stringPoolCount; i++) {
+        uint16_t length = readUInt16(in);
+        EmojicodeChar *characters = malloc(length * sizeof(EmojicodeChar));
+        bool compact = true;
+        
+        for (uint16_t j = 0; j < length; j++) {
+            characters[j] = readEmojicodeChar(in);
+            compact = compact && characters[j] <= 0xFF;
+        }
+        
         Object *o = newObject(CL_STRING);
         String *string = o->value;
 
-        string->length = readUInt16(in);
-        string->characters = newArray(string->length * sizeof(EmojicodeChar));
+        string->length = length;
+        string->compact = compact;
+        string->characters = newStringCharacters(length, compact);
         
-        for (uint16_t j = 0; j < string->length; j++) {
-            ((EmojicodeChar*)string->characters->value)[j] = readEmojicodeChar(in);
+        for (uint16_t j = 0; j < length; j++) {
+            stringSetCharacterAt(string, j, characters[j]);
         }
+        free(characters);
 
         stringPool[i] = o;
     }
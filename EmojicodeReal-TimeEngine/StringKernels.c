@@ -0,0 +1,792 @@
+//
+//  StringKernels.c
+//  Emojicode
+//
+
+#include "StringKernels.h"
+#include <string.h>
+
+#ifdef STRING_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+//MARK: Scalar
+
+static EmojicodeInteger findCharacterCompactScalar(const unsigned char *characters, EmojicodeInteger length, unsigned char c){
+    for (EmojicodeInteger i = 0; i < length; i++) {
+        if (characters[i] == c) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static EmojicodeInteger findCharacterWideScalar(const EmojicodeChar *characters, EmojicodeInteger length, EmojicodeChar c){
+    for (EmojicodeInteger i = 0; i < length; i++) {
+        if (characters[i] == c) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/** Searches the positions from @c i on one by one. The vector kernels use this for the positions they cannot load. */
+static EmojicodeInteger findCompactFrom(const unsigned char *characters, EmojicodeInteger length,
+                                        const unsigned char *needle, EmojicodeInteger needleLength, EmojicodeInteger i){
+    for (; i + needleLength <= length; i++) {
+        if (characters[i] == needle[0] && memcmp(characters + i, needle, needleLength) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static EmojicodeInteger findWideFrom(const EmojicodeChar *characters, EmojicodeInteger length,
+                                     const EmojicodeChar *needle, EmojicodeInteger needleLength, EmojicodeInteger i){
+    for (; i + needleLength <= length; i++) {
+        if (characters[i] == needle[0] && memcmp(characters + i, needle, needleLength * sizeof(EmojicodeChar)) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static EmojicodeInteger findCompactScalar(const unsigned char *characters, EmojicodeInteger length,
+                                          const unsigned char *needle, EmojicodeInteger needleLength){
+    return findCompactFrom(characters, length, needle, needleLength, 0);
+}
+
+static EmojicodeInteger findWideScalar(const EmojicodeChar *characters, EmojicodeInteger length,
+                                       const EmojicodeChar *needle, EmojicodeInteger needleLength){
+    return findWideFrom(characters, length, needle, needleLength, 0);
+}
+
+static EmojicodeInteger leadingWhitespaceCompactScalar(const unsigned char *characters, EmojicodeInteger length){
+    EmojicodeInteger i = 0;
+    while (i < length && isWhitespace(characters[i])) i++;
+    return i;
+}
+
+static EmojicodeInteger trailingWhitespaceCompactScalar(const unsigned char *characters, EmojicodeInteger length){
+    EmojicodeInteger i = length;
+    while (i > 0 && isWhitespace(characters[i - 1])) i--;
+    return length - i;
+}
+
+static EmojicodeInteger leadingWhitespaceWideScalar(const EmojicodeChar *characters, EmojicodeInteger length){
+    EmojicodeInteger i = 0;
+    while (i < length && isWhitespace(characters[i])) i++;
+    return i;
+}
+
+static EmojicodeInteger trailingWhitespaceWideScalar(const EmojicodeChar *characters, EmojicodeInteger length){
+    EmojicodeInteger i = length;
+    while (i > 0 && isWhitespace(characters[i - 1])) i--;
+    return length - i;
+}
+
+static size_t asciiLengthScalar(const unsigned char *bytes, size_t size){
+    size_t i = 0;
+    while (i < size && bytes[i] < 0x80) i++;
+    return i;
+}
+
+static void widenScalar(EmojicodeChar *destination, const unsigned char *source, size_t length){
+    for (size_t i = 0; i < length; i++) {
+        destination[i] = source[i];
+    }
+}
+
+static size_t narrowASCIIScalar(unsigned char *destination, const EmojicodeChar *source, size_t length){
+    size_t i = 0;
+    for (; i < length && source[i] < 0x80; i++) {
+        destination[i] = (unsigned char)source[i];
+    }
+    return i;
+}
+
+static inline bool isJSONStructural(EmojicodeChar c){
+    switch (c) {
+        case '{': case '}': case '[': case ']': case ':': case ',': case '"': case '\\':
+            return true;
+        default:
+            return c < 0x20;
+    }
+}
+
+static size_t jsonStructuralsCompactScalar(const unsigned char *characters, size_t length, uint32_t *indices){
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        indices[count] = (uint32_t)i;
+        count += isJSONStructural(characters[i]);
+    }
+    return count;
+}
+
+static size_t jsonStructuralsWideScalar(const EmojicodeChar *characters, size_t length, uint32_t *indices){
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        indices[count] = (uint32_t)i;
+        count += isJSONStructural(characters[i]);
+    }
+    return count;
+}
+
+static inline bool isJSONPlain(EmojicodeChar c){
+    return 0x20 <= c && c < 0x80 && c != '"' && c != '\\';
+}
+
+static size_t jsonPlainLengthCompactScalar(const unsigned char *characters, size_t length){
+    size_t i = 0;
+    while (i < length && isJSONPlain(characters[i])) i++;
+    return i;
+}
+
+static size_t jsonPlainLengthWideScalar(const EmojicodeChar *characters, size_t length){
+    size_t i = 0;
+    while (i < length && isJSONPlain(characters[i])) i++;
+    return i;
+}
+
+const StringKernels scalarStringKernels = {
+    findCharacterCompactScalar, findCharacterWideScalar,
+    findCompactScalar, findWideScalar,
+    leadingWhitespaceCompactScalar, trailingWhitespaceCompactScalar,
+    leadingWhitespaceWideScalar, trailingWhitespaceWideScalar,
+    asciiLengthScalar, widenScalar, narrowASCIIScalar,
+    jsonStructuralsCompactScalar, jsonStructuralsWideScalar,
+    jsonPlainLengthCompactScalar, jsonPlainLengthWideScalar,
+    "scalar"
+};
+
+StringKernels stringKernels = {
+    findCharacterCompactScalar, findCharacterWideScalar,
+    findCompactScalar, findWideScalar,
+    leadingWhitespaceCompactScalar, trailingWhitespaceCompactScalar,
+    leadingWhitespaceWideScalar, trailingWhitespaceWideScalar,
+    asciiLengthScalar, widenScalar, narrowASCIIScalar,
+    jsonStructuralsCompactScalar, jsonStructuralsWideScalar,
+    jsonPlainLengthCompactScalar, jsonPlainLengthWideScalar,
+    "scalar"
+};
+
+#ifdef STRING_KERNELS_X86
+
+/*
+ * The substring searches compare the first and the last code point of the needle against a whole vector of
+ * positions at once and only compare the rest of the needle at the positions where both matched.
+ * The whitespace kernels test all characters of a vector against everything isWhitespace accepts.
+ * The JSON kernels build a bit mask of the structural characters of up to 64 positions and append the index of every
+ * set bit.
+ */
+
+/** Appends @c base plus the index of every bit set in @c mask to @c indices. */
+static inline size_t appendMaskIndices(uint32_t *indices, size_t count, size_t base, uint64_t mask){
+    while (mask) {
+        indices[count++] = (uint32_t)(base + __builtin_ctzll(mask));
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+//MARK: SSE2
+
+#define SSE2 __attribute__((target("sse2")))
+
+SSE2 static EmojicodeInteger findCharacterCompactSSE2(const unsigned char *characters, EmojicodeInteger length, unsigned char c){
+    __m128i needle = _mm_set1_epi8((char)c);
+    EmojicodeInteger i = 0;
+    for (; i + 16 <= length; i += 16) {
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(characters + i)), needle));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    EmojicodeInteger r = findCharacterCompactScalar(characters + i, length - i, c);
+    return r < 0 ? r : i + r;
+}
+
+SSE2 static EmojicodeInteger findCharacterWideSSE2(const EmojicodeChar *characters, EmojicodeInteger length, EmojicodeChar c){
+    __m128i needle = _mm_set1_epi32((int)c);
+    EmojicodeInteger i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(characters + i)), needle);
+        unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    EmojicodeInteger r = findCharacterWideScalar(characters + i, length - i, c);
+    return r < 0 ? r : i + r;
+}
+
+SSE2 static EmojicodeInteger findCompactSSE2(const unsigned char *characters, EmojicodeInteger length,
+                                             const unsigned char *needle, EmojicodeInteger needleLength){
+    if (needleLength == 1) {
+        return findCharacterCompactSSE2(characters, length, needle[0]);
+    }
+    __m128i first = _mm_set1_epi8((char)needle[0]);
+    __m128i last = _mm_set1_epi8((char)needle[needleLength - 1]);
+    EmojicodeInteger i = 0;
+    for (; i + needleLength - 1 + 16 <= length; i += 16) {
+        __m128i f = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(characters + i)), first);
+        __m128i l = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(characters + i + needleLength - 1)), last);
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(f, l));
+        while (mask) {
+            unsigned bit = __builtin_ctz(mask);
+            if (memcmp(characters + i + bit + 1, needle + 1, needleLength - 2) == 0) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findCompactFrom(characters, length, needle, needleLength, i);
+}
+
+SSE2 static EmojicodeInteger findWideSSE2(const EmojicodeChar *characters, EmojicodeInteger length,
+                                          const EmojicodeChar *needle, EmojicodeInteger needleLength){
+    if (needleLength == 1) {
+        return findCharacterWideSSE2(characters, length, needle[0]);
+    }
+    __m128i first = _mm_set1_epi32((int)needle[0]);
+    __m128i last = _mm_set1_epi32((int)needle[needleLength - 1]);
+    EmojicodeInteger i = 0;
+    for (; i + needleLength - 1 + 4 <= length; i += 4) {
+        __m128i f = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(characters + i)), first);
+        __m128i l = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(characters + i + needleLength - 1)), last);
+        unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(f, l)));
+        while (mask) {
+            unsigned bit = __builtin_ctz(mask);
+            if (memcmp(characters + i + bit + 1, needle + 1, (needleLength - 2) * sizeof(EmojicodeChar)) == 0) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findWideFrom(characters, length, needle, needleLength, i);
+}
+
+/** Returns a mask with one bit per byte which is set if the byte is whitespace. */
+SSE2 static inline unsigned whitespaceMaskCompactSSE2(const unsigned char *characters){
+    __m128i c = _mm_loadu_si128((const __m128i *)characters);
+    __m128i ws = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(c, _mm_set1_epi8(0x9)), c),
+                               _mm_cmpeq_epi8(_mm_min_epu8(c, _mm_set1_epi8(0xD)), c));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(c, _mm_set1_epi8(0x20)));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(c, _mm_set1_epi8((char)0x85)));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(c, _mm_set1_epi8((char)0xA0)));
+    return _mm_movemask_epi8(ws);
+}
+
+SSE2 static EmojicodeInteger leadingWhitespaceCompactSSE2(const unsigned char *characters, EmojicodeInteger length){
+    EmojicodeInteger i = 0;
+    for (; i + 16 <= length; i += 16) {
+        unsigned mask = whitespaceMaskCompactSSE2(characters + i);
+        if (mask != 0xFFFF) {
+            return i + __builtin_ctz(~mask);
+        }
+    }
+    return i + leadingWhitespaceCompactScalar(characters + i, length - i);
+}
+
+SSE2 static EmojicodeInteger trailingWhitespaceCompactSSE2(const unsigned char *characters, EmojicodeInteger length){
+    EmojicodeInteger i = length;
+    for (; i >= 16; i -= 16) {
+        unsigned mask = whitespaceMaskCompactSSE2(characters + i - 16);
+        if (mask != 0xFFFF) {
+            return length - i + __builtin_clz(~mask & 0xFFFF) - 16;
+        }
+    }
+    return length - i + trailingWhitespaceCompactScalar(characters, i);
+}
+
+/** Returns a mask with one bit per code point which is set if the code point is whitespace. */
+SSE2 static inline unsigned whitespaceMaskWideSSE2(const EmojicodeChar *characters){
+    __m128i c = _mm_loadu_si128((const __m128i *)characters);
+    __m128i ws = _mm_or_si128(_mm_cmplt_epi32(c, _mm_set1_epi32(0x9)), _mm_cmpgt_epi32(c, _mm_set1_epi32(0xD)));
+    __m128i ws2 = _mm_or_si128(_mm_cmplt_epi32(c, _mm_set1_epi32(0x2000)), _mm_cmpgt_epi32(c, _mm_set1_epi32(0x200A)));
+    ws = _mm_andnot_si128(_mm_and_si128(ws, ws2), _mm_set1_epi32(-1));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi32(c, _mm_set1_epi32(0x20)));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi32(c, _mm_set1_epi32(0x85)));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi32(c, _mm_set1_epi32(0xA0)));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi32(c, _mm_set1_epi32(0x1680)));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi32(c, _mm_set1_epi32(0x2028)));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi32(c, _mm_set1_epi32(0x2029)));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi32(c, _mm_set1_epi32(0x202F)));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi32(c, _mm_set1_epi32(0x205F)));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi32(c, _mm_set1_epi32(0x3000)));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi32(c, _mm_set1_epi32(0xFE0F)));
+    return _mm_movemask_ps(_mm_castsi128_ps(ws));
+}
+
+SSE2 static EmojicodeInteger leadingWhitespaceWideSSE2(const EmojicodeChar *characters, EmojicodeInteger length){
+    EmojicodeInteger i = 0;
+    for (; i + 4 <= length; i += 4) {
+        unsigned mask = whitespaceMaskWideSSE2(characters + i);
+        if (mask != 0xF) {
+            return i + __builtin_ctz(~mask);
+        }
+    }
+    return i + leadingWhitespaceWideScalar(characters + i, length - i);
+}
+
+SSE2 static EmojicodeInteger trailingWhitespaceWideSSE2(const EmojicodeChar *characters, EmojicodeInteger length){
+    EmojicodeInteger i = length;
+    for (; i >= 4; i -= 4) {
+        unsigned mask = whitespaceMaskWideSSE2(characters + i - 4);
+        if (mask != 0xF) {
+            return length - i + __builtin_clz(~mask & 0xF) - 28;
+        }
+    }
+    return length - i + trailingWhitespaceWideScalar(characters, i);
+}
+
+SSE2 static size_t asciiLengthSSE2(const unsigned char *bytes, size_t size){
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        unsigned mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(bytes + i)));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + asciiLengthScalar(bytes + i, size - i);
+}
+
+SSE2 static void widenSSE2(EmojicodeChar *destination, const unsigned char *source, size_t length){
+    __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i c = _mm_loadu_si128((const __m128i *)(source + i));
+        __m128i lo = _mm_unpacklo_epi8(c, zero), hi = _mm_unpackhi_epi8(c, zero);
+        _mm_storeu_si128((__m128i *)(destination + i), _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128((__m128i *)(destination + i + 4), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128((__m128i *)(destination + i + 8), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128((__m128i *)(destination + i + 12), _mm_unpackhi_epi16(hi, zero));
+    }
+    widenScalar(destination + i, source + i, length - i);
+}
+
+SSE2 static size_t narrowASCIISSE2(unsigned char *destination, const EmojicodeChar *source, size_t length){
+    __m128i limit = _mm_set1_epi32(0x7F);
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(source + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(source + i + 4));
+        __m128i c = _mm_loadu_si128((const __m128i *)(source + i + 8));
+        __m128i d = _mm_loadu_si128((const __m128i *)(source + i + 12));
+        __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        if (_mm_movemask_epi8(_mm_cmpgt_epi32(any, limit))) {
+            break;
+        }
+        __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        _mm_storeu_si128((__m128i *)(destination + i), bytes);
+    }
+    return i + narrowASCIIScalar(destination + i, source + i, length - i);
+}
+
+/** Returns a mask with one bit per byte which is set if the byte is a JSON structural character. */
+SSE2 static inline uint64_t jsonStructuralMaskCompactSSE2(const unsigned char *characters){
+    __m128i c = _mm_loadu_si128((const __m128i *)characters);
+    //Setting bit 5 maps [ and ] onto { and }
+    __m128i brackets = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i s = _mm_or_si128(_mm_cmpeq_epi8(brackets, _mm_set1_epi8('{')), _mm_cmpeq_epi8(brackets, _mm_set1_epi8('}')));
+    s = _mm_or_si128(s, _mm_cmpeq_epi8(c, _mm_set1_epi8(':')));
+    s = _mm_or_si128(s, _mm_cmpeq_epi8(c, _mm_set1_epi8(',')));
+    s = _mm_or_si128(s, _mm_cmpeq_epi8(c, _mm_set1_epi8('"')));
+    s = _mm_or_si128(s, _mm_cmpeq_epi8(c, _mm_set1_epi8('\\')));
+    s = _mm_or_si128(s, _mm_cmpeq_epi8(_mm_min_epu8(c, _mm_set1_epi8(0x1F)), c));
+    return (unsigned)_mm_movemask_epi8(s);
+}
+
+SSE2 static size_t jsonStructuralsCompactSSE2(const unsigned char *characters, size_t length, uint32_t *indices){
+    size_t count = 0, i = 0;
+    for (; i + 64 <= length; i += 64) {
+        uint64_t mask = jsonStructuralMaskCompactSSE2(characters + i)
+                        | jsonStructuralMaskCompactSSE2(characters + i + 16) << 16
+                        | jsonStructuralMaskCompactSSE2(characters + i + 32) << 32
+                        | jsonStructuralMaskCompactSSE2(characters + i + 48) << 48;
+        count = appendMaskIndices(indices, count, i, mask);
+    }
+    size_t rest = jsonStructuralsCompactScalar(characters + i, length - i, indices + count);
+    for (size_t j = count; j < count + rest; j++) {
+        indices[j] += i;
+    }
+    return count + rest;
+}
+
+/** Returns a mask with one bit per code point which is set if the code point is a JSON structural character. */
+SSE2 static inline uint64_t jsonStructuralMaskWideSSE2(const EmojicodeChar *characters){
+    __m128i c = _mm_loadu_si128((const __m128i *)characters);
+    __m128i brackets = _mm_or_si128(c, _mm_set1_epi32(0x20));
+    __m128i s = _mm_or_si128(_mm_cmpeq_epi32(brackets, _mm_set1_epi32('{')), _mm_cmpeq_epi32(brackets, _mm_set1_epi32('}')));
+    s = _mm_or_si128(s, _mm_cmpeq_epi32(c, _mm_set1_epi32(':')));
+    s = _mm_or_si128(s, _mm_cmpeq_epi32(c, _mm_set1_epi32(',')));
+    s = _mm_or_si128(s, _mm_cmpeq_epi32(c, _mm_set1_epi32('"')));
+    s = _mm_or_si128(s, _mm_cmpeq_epi32(c, _mm_set1_epi32('\\')));
+    s = _mm_or_si128(s, _mm_cmplt_epi32(c, _mm_set1_epi32(0x20)));
+    return (unsigned)_mm_movemask_ps(_mm_castsi128_ps(s));
+}
+
+SSE2 static size_t jsonStructuralsWideSSE2(const EmojicodeChar *characters, size_t length, uint32_t *indices){
+    size_t count = 0, i = 0;
+    for (; i + 16 <= length; i += 16) {
+        uint64_t mask = jsonStructuralMaskWideSSE2(characters + i)
+                        | jsonStructuralMaskWideSSE2(characters + i + 4) << 4
+                        | jsonStructuralMaskWideSSE2(characters + i + 8) << 8
+                        | jsonStructuralMaskWideSSE2(characters + i + 12) << 12;
+        count = appendMaskIndices(indices, count, i, mask);
+    }
+    size_t rest = jsonStructuralsWideScalar(characters + i, length - i, indices + count);
+    for (size_t j = count; j < count + rest; j++) {
+        indices[j] += i;
+    }
+    return count + rest;
+}
+
+SSE2 static size_t jsonPlainLengthCompactSSE2(const unsigned char *characters, size_t length){
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i c = _mm_loadu_si128((const __m128i *)(characters + i));
+        //Compared as signed bytes everything from 0x80 on is smaller than 0x20 too
+        __m128i special = _mm_cmplt_epi8(c, _mm_set1_epi8(0x20));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(c, _mm_set1_epi8('"')));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(c, _mm_set1_epi8('\\')));
+        unsigned mask = _mm_movemask_epi8(special);
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + jsonPlainLengthCompactScalar(characters + i, length - i);
+}
+
+SSE2 static size_t jsonPlainLengthWideSSE2(const EmojicodeChar *characters, size_t length){
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128i c = _mm_loadu_si128((const __m128i *)(characters + i));
+        __m128i special = _mm_or_si128(_mm_cmplt_epi32(c, _mm_set1_epi32(0x20)), _mm_cmpgt_epi32(c, _mm_set1_epi32(0x7F)));
+        special = _mm_or_si128(special, _mm_cmpeq_epi32(c, _mm_set1_epi32('"')));
+        special = _mm_or_si128(special, _mm_cmpeq_epi32(c, _mm_set1_epi32('\\')));
+        unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(special));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + jsonPlainLengthWideScalar(characters + i, length - i);
+}
+
+const StringKernels sse2StringKernels = {
+    findCharacterCompactSSE2, findCharacterWideSSE2,
+    findCompactSSE2, findWideSSE2,
+    leadingWhitespaceCompactSSE2, trailingWhitespaceCompactSSE2,
+    leadingWhitespaceWideSSE2, trailingWhitespaceWideSSE2,
+    asciiLengthSSE2, widenSSE2, narrowASCIISSE2,
+    jsonStructuralsCompactSSE2, jsonStructuralsWideSSE2,
+    jsonPlainLengthCompactSSE2, jsonPlainLengthWideSSE2,
+    "SSE2"
+};
+
+//MARK: AVX2
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static EmojicodeInteger findCharacterCompactAVX2(const unsigned char *characters, EmojicodeInteger length, unsigned char c){
+    __m256i needle = _mm256_set1_epi8((char)c);
+    EmojicodeInteger i = 0;
+    for (; i + 32 <= length; i += 32) {
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(characters + i)), needle));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    EmojicodeInteger r = findCharacterCompactScalar(characters + i, length - i, c);
+    return r < 0 ? r : i + r;
+}
+
+AVX2 static EmojicodeInteger findCharacterWideAVX2(const EmojicodeChar *characters, EmojicodeInteger length, EmojicodeChar c){
+    __m256i needle = _mm256_set1_epi32((int)c);
+    EmojicodeInteger i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(characters + i)), needle);
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    EmojicodeInteger r = findCharacterWideScalar(characters + i, length - i, c);
+    return r < 0 ? r : i + r;
+}
+
+AVX2 static EmojicodeInteger findCompactAVX2(const unsigned char *characters, EmojicodeInteger length,
+                                             const unsigned char *needle, EmojicodeInteger needleLength){
+    if (needleLength == 1) {
+        return findCharacterCompactAVX2(characters, length, needle[0]);
+    }
+    __m256i first = _mm256_set1_epi8((char)needle[0]);
+    __m256i last = _mm256_set1_epi8((char)needle[needleLength - 1]);
+    EmojicodeInteger i = 0;
+    for (; i + needleLength - 1 + 32 <= length; i += 32) {
+        __m256i f = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(characters + i)), first);
+        __m256i l = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(characters + i + needleLength - 1)), last);
+        unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(f, l));
+        while (mask) {
+            unsigned bit = __builtin_ctz(mask);
+            if (memcmp(characters + i + bit + 1, needle + 1, needleLength - 2) == 0) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findCompactFrom(characters, length, needle, needleLength, i);
+}
+
+AVX2 static EmojicodeInteger findWideAVX2(const EmojicodeChar *characters, EmojicodeInteger length,
+                                          const EmojicodeChar *needle, EmojicodeInteger needleLength){
+    if (needleLength == 1) {
+        return findCharacterWideAVX2(characters, length, needle[0]);
+    }
+    __m256i first = _mm256_set1_epi32((int)needle[0]);
+    __m256i last = _mm256_set1_epi32((int)needle[needleLength - 1]);
+    EmojicodeInteger i = 0;
+    for (; i + needleLength - 1 + 8 <= length; i += 8) {
+        __m256i f = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(characters + i)), first);
+        __m256i l = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(characters + i + needleLength - 1)), last);
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(f, l)));
+        while (mask) {
+            unsigned bit = __builtin_ctz(mask);
+            if (memcmp(characters + i + bit + 1, needle + 1, (needleLength - 2) * sizeof(EmojicodeChar)) == 0) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findWideFrom(characters, length, needle, needleLength, i);
+}
+
+AVX2 static inline unsigned whitespaceMaskCompactAVX2(const unsigned char *characters){
+    __m256i c = _mm256_loadu_si256((const __m256i *)characters);
+    __m256i ws = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(c, _mm256_set1_epi8(0x9)), c),
+                                  _mm256_cmpeq_epi8(_mm256_min_epu8(c, _mm256_set1_epi8(0xD)), c));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(c, _mm256_set1_epi8(0x20)));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(c, _mm256_set1_epi8((char)0x85)));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(c, _mm256_set1_epi8((char)0xA0)));
+    return _mm256_movemask_epi8(ws);
+}
+
+AVX2 static EmojicodeInteger leadingWhitespaceCompactAVX2(const unsigned char *characters, EmojicodeInteger length){
+    EmojicodeInteger i = 0;
+    for (; i + 32 <= length; i += 32) {
+        unsigned mask = whitespaceMaskCompactAVX2(characters + i);
+        if (mask != 0xFFFFFFFF) {
+            return i + __builtin_ctz(~mask);
+        }
+    }
+    return i + leadingWhitespaceCompactSSE2(characters + i, length - i);
+}
+
+AVX2 static EmojicodeInteger trailingWhitespaceCompactAVX2(const unsigned char *characters, EmojicodeInteger length){
+    EmojicodeInteger i = length;
+    for (; i >= 32; i -= 32) {
+        unsigned mask = whitespaceMaskCompactAVX2(characters + i - 32);
+        if (mask != 0xFFFFFFFF) {
+            return length - i + __builtin_clz(~mask);
+        }
+    }
+    return length - i + trailingWhitespaceCompactSSE2(characters, i);
+}
+
+AVX2 static inline unsigned whitespaceMaskWideAVX2(const EmojicodeChar *characters){
+    __m256i c = _mm256_loadu_si256((const __m256i *)characters);
+    __m256i ws = _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(0x9), c), _mm256_cmpgt_epi32(c, _mm256_set1_epi32(0xD)));
+    __m256i ws2 = _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(0x2000), c),
+                                  _mm256_cmpgt_epi32(c, _mm256_set1_epi32(0x200A)));
+    ws = _mm256_andnot_si256(_mm256_and_si256(ws, ws2), _mm256_set1_epi32(-1));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi32(c, _mm256_set1_epi32(0x20)));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi32(c, _mm256_set1_epi32(0x85)));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi32(c, _mm256_set1_epi32(0xA0)));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi32(c, _mm256_set1_epi32(0x1680)));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi32(c, _mm256_set1_epi32(0x2028)));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi32(c, _mm256_set1_epi32(0x2029)));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi32(c, _mm256_set1_epi32(0x202F)));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi32(c, _mm256_set1_epi32(0x205F)));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi32(c, _mm256_set1_epi32(0x3000)));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi32(c, _mm256_set1_epi32(0xFE0F)));
+    return _mm256_movemask_ps(_mm256_castsi256_ps(ws));
+}
+
+AVX2 static EmojicodeInteger leadingWhitespaceWideAVX2(const EmojicodeChar *characters, EmojicodeInteger length){
+    EmojicodeInteger i = 0;
+    for (; i + 8 <= length; i += 8) {
+        unsigned mask = whitespaceMaskWideAVX2(characters + i);
+        if (mask != 0xFF) {
+            return i + __builtin_ctz(~mask);
+        }
+    }
+    return i + leadingWhitespaceWideSSE2(characters + i, length - i);
+}
+
+AVX2 static EmojicodeInteger trailingWhitespaceWideAVX2(const EmojicodeChar *characters, EmojicodeInteger length){
+    EmojicodeInteger i = length;
+    for (; i >= 8; i -= 8) {
+        unsigned mask = whitespaceMaskWideAVX2(characters + i - 8);
+        if (mask != 0xFF) {
+            return length - i + __builtin_clz(~mask & 0xFF) - 24;
+        }
+    }
+    return length - i + trailingWhitespaceWideSSE2(characters, i);
+}
+
+AVX2 static size_t asciiLengthAVX2(const unsigned char *bytes, size_t size){
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        unsigned mask = _mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)(bytes + i)));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + asciiLengthSSE2(bytes + i, size - i);
+}
+
+AVX2 static void widenAVX2(EmojicodeChar *destination, const unsigned char *source, size_t length){
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        for (size_t j = 0; j < 32; j += 8) {
+            __m256i c = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(source + i + j)));
+            _mm256_storeu_si256((__m256i *)(destination + i + j), c);
+        }
+    }
+    widenSSE2(destination + i, source + i, length - i);
+}
+
+AVX2 static size_t narrowASCIIAVX2(unsigned char *destination, const EmojicodeChar *source, size_t length){
+    __m256i limit = _mm256_set1_epi32(0x7F);
+    //packs and packus work within 128 bit lanes, this permutation restores the order of the code points
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(source + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(source + i + 8));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(source + i + 16));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(source + i + 24));
+        __m256i any = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+        if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(any, limit))) {
+            break;
+        }
+        __m256i bytes = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+        _mm256_storeu_si256((__m256i *)(destination + i), _mm256_permutevar8x32_epi32(bytes, order));
+    }
+    return i + narrowASCIISSE2(destination + i, source + i, length - i);
+}
+
+AVX2 static inline uint64_t jsonStructuralMaskCompactAVX2(const unsigned char *characters){
+    __m256i c = _mm256_loadu_si256((const __m256i *)characters);
+    __m256i brackets = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    __m256i s = _mm256_or_si256(_mm256_cmpeq_epi8(brackets, _mm256_set1_epi8('{')),
+                                _mm256_cmpeq_epi8(brackets, _mm256_set1_epi8('}')));
+    s = _mm256_or_si256(s, _mm256_cmpeq_epi8(c, _mm256_set1_epi8(':')));
+    s = _mm256_or_si256(s, _mm256_cmpeq_epi8(c, _mm256_set1_epi8(',')));
+    s = _mm256_or_si256(s, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('"')));
+    s = _mm256_or_si256(s, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\\')));
+    s = _mm256_or_si256(s, _mm256_cmpeq_epi8(_mm256_min_epu8(c, _mm256_set1_epi8(0x1F)), c));
+    return (uint32_t)_mm256_movemask_epi8(s);
+}
+
+AVX2 static size_t jsonStructuralsCompactAVX2(const unsigned char *characters, size_t length, uint32_t *indices){
+    size_t count = 0, i = 0;
+    for (; i + 64 <= length; i += 64) {
+        uint64_t mask = jsonStructuralMaskCompactAVX2(characters + i)
+                        | jsonStructuralMaskCompactAVX2(characters + i + 32) << 32;
+        count = appendMaskIndices(indices, count, i, mask);
+    }
+    size_t rest = jsonStructuralsCompactSSE2(characters + i, length - i, indices + count);
+    for (size_t j = count; j < count + rest; j++) {
+        indices[j] += i;
+    }
+    return count + rest;
+}
+
+AVX2 static inline uint64_t jsonStructuralMaskWideAVX2(const EmojicodeChar *characters){
+    __m256i c = _mm256_loadu_si256((const __m256i *)characters);
+    __m256i brackets = _mm256_or_si256(c, _mm256_set1_epi32(0x20));
+    __m256i s = _mm256_or_si256(_mm256_cmpeq_epi32(brackets, _mm256_set1_epi32('{')),
+                                _mm256_cmpeq_epi32(brackets, _mm256_set1_epi32('}')));
+    s = _mm256_or_si256(s, _mm256_cmpeq_epi32(c, _mm256_set1_epi32(':')));
+    s = _mm256_or_si256(s, _mm256_cmpeq_epi32(c, _mm256_set1_epi32(',')));
+    s = _mm256_or_si256(s, _mm256_cmpeq_epi32(c, _mm256_set1_epi32('"')));
+    s = _mm256_or_si256(s, _mm256_cmpeq_epi32(c, _mm256_set1_epi32('\\')));
+    s = _mm256_or_si256(s, _mm256_cmpgt_epi32(_mm256_set1_epi32(0x20), c));
+    return (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(s));
+}
+
+AVX2 static size_t jsonStructuralsWideAVX2(const EmojicodeChar *characters, size_t length, uint32_t *indices){
+    size_t count = 0, i = 0;
+    for (; i + 32 <= length; i += 32) {
+        uint64_t mask = jsonStructuralMaskWideAVX2(characters + i)
+                        | jsonStructuralMaskWideAVX2(characters + i + 8) << 8
+                        | jsonStructuralMaskWideAVX2(characters + i + 16) << 16
+                        | jsonStructuralMaskWideAVX2(characters + i + 24) << 24;
+        count = appendMaskIndices(indices, count, i, mask);
+    }
+    size_t rest = jsonStructuralsWideSSE2(characters + i, length - i, indices + count);
+    for (size_t j = count; j < count + rest; j++) {
+        indices[j] += i;
+    }
+    return count + rest;
+}
+
+AVX2 static size_t jsonPlainLengthCompactAVX2(const unsigned char *characters, size_t length){
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(characters + i));
+        __m256i special = _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), c);
+        special = _mm256_or_si256(special, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('"')));
+        special = _mm256_or_si256(special, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\\')));
+        unsigned mask = _mm256_movemask_epi8(special);
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + jsonPlainLengthCompactSSE2(characters + i, length - i);
+}
+
+AVX2 static size_t jsonPlainLengthWideAVX2(const EmojicodeChar *characters, size_t length){
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(characters + i));
+        __m256i special = _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(0x20), c),
+                                          _mm256_cmpgt_epi32(c, _mm256_set1_epi32(0x7F)));
+        special = _mm256_or_si256(special, _mm256_cmpeq_epi32(c, _mm256_set1_epi32('"')));
+        special = _mm256_or_si256(special, _mm256_cmpeq_epi32(c, _mm256_set1_epi32('\\')));
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(special));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + jsonPlainLengthWideSSE2(characters + i, length - i);
+}
+
+const StringKernels avx2StringKernels = {
+    findCharacterCompactAVX2, findCharacterWideAVX2,
+    findCompactAVX2, findWideAVX2,
+    leadingWhitespaceCompactAVX2, trailingWhitespaceCompactAVX2,
+    leadingWhitespaceWideAVX2, trailingWhitespaceWideAVX2,
+    asciiLengthAVX2, widenAVX2, narrowASCIIAVX2,
+    jsonStructuralsCompactAVX2, jsonStructuralsWideAVX2,
+    jsonPlainLengthCompactAVX2, jsonPlainLengthWideAVX2,
+    "AVX2"
+};
+
+#endif
+
+void selectStringKernels(void){
+#ifdef STRING_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        stringKernels = avx2StringKernels;
+        return;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        stringKernels = sse2StringKernels;
+        return;
+    }
+#endif
+    stringKernels = scalarStringKernels;
+}
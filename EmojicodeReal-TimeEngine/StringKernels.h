@@ -0,0 +1,71 @@
+//
+//  StringKernels.h
+//  Emojicode
+//
+
+#ifndef StringKernels_h
+#define StringKernels_h
+
+#include "EmojicodeAPI.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define STRING_KERNELS_X86
+#endif
+
+/**
+ * The loops the string methods spend most of their time in. Every kernel exists once for compact (one byte per code
+ * point) and once for wide (one @c EmojicodeChar per code point) characters. All indices are code point indices.
+ * The transcoding kernels only handle ASCII, the UTF-8 functions in EmojicodeString.c handle everything else.
+ */
+typedef struct {
+    /** Returns the index of the first occurrence of @c c or -1. */
+    EmojicodeInteger (*findCharacterCompact)(const unsigned char *characters, EmojicodeInteger length, unsigned char c);
+    EmojicodeInteger (*findCharacterWide)(const EmojicodeChar *characters, EmojicodeInteger length, EmojicodeChar c);
+    /** Returns the index of the first occurrence of @c needle, which must not be empty, or -1. */
+    EmojicodeInteger (*findCompact)(const unsigned char *characters, EmojicodeInteger length,
+                                    const unsigned char *needle, EmojicodeInteger needleLength);
+    EmojicodeInteger (*findWide)(const EmojicodeChar *characters, EmojicodeInteger length,
+                                 const EmojicodeChar *needle, EmojicodeInteger needleLength);
+    /** Returns the number of whitespace characters, as defined by @c isWhitespace, at the start. */
+    EmojicodeInteger (*leadingWhitespaceCompact)(const unsigned char *characters, EmojicodeInteger length);
+    /** Returns the number of whitespace characters at the end. */
+    EmojicodeInteger (*trailingWhitespaceCompact)(const unsigned char *characters, EmojicodeInteger length);
+    EmojicodeInteger (*leadingWhitespaceWide)(const EmojicodeChar *characters, EmojicodeInteger length);
+    EmojicodeInteger (*trailingWhitespaceWide)(const EmojicodeChar *characters, EmojicodeInteger length);
+    /** Returns the number of bytes smaller than 0x80 at the start. */
+    size_t (*asciiLength)(const unsigned char *bytes, size_t size);
+    /** Widens @c length compact characters to @c EmojicodeChar. */
+    void (*widen)(EmojicodeChar *destination, const unsigned char *source, size_t length);
+    /** Copies the code points smaller than 0x80 at the start of @c source as bytes and returns their number. */
+    size_t (*narrowASCII)(unsigned char *destination, const EmojicodeChar *source, size_t length);
+    /**
+     * Stores the indices of the characters with a structural meaning in JSON, @c {}[]:," and @c \\, and of all
+     * control characters in @c indices in ascending order and returns their number. @c indices must have room for
+     * @c length entries.
+     */
+    size_t (*jsonStructuralsCompact)(const unsigned char *characters, size_t length, uint32_t *indices);
+    size_t (*jsonStructuralsWide)(const EmojicodeChar *characters, size_t length, uint32_t *indices);
+    /**
+     * Returns the number of code points at the start that JSON strings can contain unescaped and that are ASCII,
+     * i.e. that are neither control characters nor @c " or @c \\ nor larger than 0x7F.
+     */
+    size_t (*jsonPlainLengthCompact)(const unsigned char *characters, size_t length);
+    size_t (*jsonPlainLengthWide)(const EmojicodeChar *characters, size_t length);
+    /** The name of the instruction set used, for diagnostics and benchmarks. */
+    const char *name;
+} StringKernels;
+
+/** The kernels used by the string methods. Scalar until @c selectStringKernels was called. */
+extern StringKernels stringKernels;
+
+/** The portable kernels. */
+extern const StringKernels scalarStringKernels;
+#ifdef STRING_KERNELS_X86
+extern const StringKernels sse2StringKernels;
+extern const StringKernels avx2StringKernels;
+#endif
+
+/** Selects the fastest kernels the CPU supports. Call once at startup. */
+void selectStringKernels(void);
+
+#endif /* StringKernels_h */
@@ -13,6 +13,9 @@ Thread *lastThread = NULL;
 int threads = 0;
 pthread_mutex_t threadListMutex = PTHREAD_MUTEX_INITIALIZER;
 
+extern pthread_mutex_t pausingThreadsCountMutex;
+extern pthread_cond_t threadsCountCondition;
+
 Thread* allocateThread() {
 #define stackSize (sizeof(StackFrame) + 4 * sizeof(Something)) * 10000 //ca. 400 KB
     Thread *thread = malloc(sizeof(Thread));
@@ -43,10 +46,16 @@ void removeThread(Thread *thread) {
     
     if (before) before->threadAfter = after;
     if (after) after->threadBefore = before;
+    if (lastThread == thread) lastThread = before;
     
     threads--;
     pthread_mutex_unlock(&threadListMutex);
     
+    //A GC might be waiting for this thread to pause
+    pthread_mutex_lock(&pausingThreadsCountMutex);
+    pthread_cond_signal(&threadsCountCondition);
+    pthread_mutex_unlock(&pausingThreadsCountMutex);
+    
     free(thread->stackLimit);
     free(thread);
 }
\ No newline at end of file
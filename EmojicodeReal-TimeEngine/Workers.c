@@ -0,0 +1,74 @@
+//
+//  Workers.c
+//  Emojicode
+//
+
+#include "Emojicode.h"
+#include <pthread.h>
+#include <unistd.h>
+
+/** The number of workers large operations are split into at most. 0 means one per online processor. */
+#ifndef maximumWorkerCount
+#define maximumWorkerCount 0
+#endif
+
+typedef struct {
+    WorkerFunction function;
+    void *context;
+    size_t index;
+    Thread *thread;
+    pthread_t pthread;
+} Worker;
+
+size_t workerCount(size_t items, size_t minimumItemsPerWorker){
+    static size_t processors = 0;
+    if (processors == 0) {
+        long online = maximumWorkerCount > 0 ? maximumWorkerCount : sysconf(_SC_NPROCESSORS_ONLN);
+        processors = online > 0 ? (size_t)online : 1;
+    }
+    size_t count = items / minimumItemsPerWorker;
+    if (count > processors) {
+        return processors;
+    }
+    return count > 0 ? count : 1;
+}
+
+static void* workerStarter(void *workerv) {
+    Worker *worker = workerv;
+    pauseForGC(NULL);
+    worker->function(worker->context, worker->index, worker->thread);
+    stackPop(worker->thread);
+    removeThread(worker->thread);
+    return NULL;
+}
+
+void runWorkers(WorkerFunction function, void *context, size_t count, Object *root, Thread *thread){
+    if (count == 1) {
+        stackPush(root, 0, 0, thread);
+        function(context, 0, thread);
+        stackPop(thread);
+        return;
+    }
+
+    Worker *workers = malloc(sizeof(Worker) * count);
+    for (size_t i = 0; i < count; i++) {
+        workers[i].function = function;
+        workers[i].context = context;
+        workers[i].index = i;
+        workers[i].thread = allocateThread();
+        stackPush(root, 0, 0, workers[i].thread);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (pthread_create(&workers[i].pthread, NULL, workerStarter, workers + i) != 0) {
+            error("Could not start a worker thread.");
+        }
+    }
+
+    allowGC();
+    for (size_t i = 0; i < count; i++) {
+        pthread_join(workers[i].pthread, NULL);
+    }
+    disallowGCAndPauseIfNeeded();
+
+    free(workers);
+}
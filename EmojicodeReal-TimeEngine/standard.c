@@ -17,7 +17,6 @@
 #include "EmojicodeList.h"
 #include "EmojicodeString.h"
 #include "EmojicodeDictionary.h"
-#include "utf8.h"
 
 EmojicodeInteger secureRandomNumber(EmojicodeInteger min, EmojicodeInteger max){
     uint_fast64_t z;
@@ -46,21 +45,33 @@ static Something systemExit(Thread *thread){
 }
 
 static Something systemGetEnv(Thread *thread){
-    char* variableName = stringToChar(stackGetVariable(0, thread).object->value);
+    char buffer[256];
+    char* variableName = stringToCharInBuffer(stackGetVariable(0, thread).object->value, buffer, sizeof(buffer));
     char* env = getenv(variableName);
+    stringFreeCharInBuffer(variableName, buffer);
     
     if(!env)
         return NOTHINGNESS;
     
-    free(variableName);
-    return somethingObject(stringFromChar(env));
+    return somethingObject(stringFromUTF8(env, strlen(env), thread));
 }
 
 static Something systemCWD(Thread *thread){
     char path[1050];
     getcwd(path, sizeof(path));
     
-    return somethingObject(stringFromChar(path));
+    return somethingObject(stringFromUTF8(path, strlen(path), thread));
+}
+
+static Something systemFlush(Thread *thread) {
+    outputFlush(standardOutput);
+    outputFlush(standardError);
+    return NOTHINGNESS;
+}
+
+static Something systemPrintLines(Thread *thread) {
+    outputWriteStringList(standardOutput, stackGetVariable(0, thread).object->value);
+    return NOTHINGNESS;
 }
 
 static Something systemTime(Thread *thread) {
@@ -82,51 +93,48 @@ static Something systemArgs(Thread *thread) {
     ((List *)listObject->value)->items = items;
     
     for (int i = 0; i < cliArgumentCount; i++) {
-        listAppend(listObject, somethingObject(stringFromChar(cliArguments[i])), thread);
+        Object *argument = stringFromUTF8(cliArguments[i], strlen(cliArguments[i]), thread);
+        listAppend(stackGetVariable(0, thread).object, somethingObject(argument), thread);
     }
     
+    listObject = stackGetVariable(0, thread).object;
     stackPop(thread);
     return somethingObject(listObject);
 }
 
 static Something systemSystem(Thread *thread) {
     char *command = stringToChar(stackGetVariable(0, thread).object->value);
-    FILE *f = popen(command, "r");
-    free(command);
-    
-    if (!f) {
-        return NOTHINGNESS;
-    }
     
     size_t bufferUsedSize = 0;
     int bufferSize = 50;
-    Object *buffer = newArray(bufferSize);
+    char *buffer = malloc(bufferSize);
+    buffer[0] = 0;
     
-    while (fgets((char *)buffer->value + bufferUsedSize, bufferSize - (int)bufferUsedSize, f) != NULL) {
-        bufferUsedSize = strlen(buffer->value);
+    allowGC();
+    FILE *f = popen(command, "r");
+    while (f && fgets(buffer + bufferUsedSize, bufferSize - (int)bufferUsedSize, f) != NULL) {
+        bufferUsedSize = strlen(buffer);
         
         if (bufferSize - bufferUsedSize < 2) {
             bufferSize *= 2;
-            buffer = resizeArray(buffer, bufferSize);
+            buffer = realloc(buffer, bufferSize);
         }
     }
+    if (f) {
+        pclose(f);
+    }
+    disallowGCAndPauseIfNeeded();
+    free(command);
     
-    bufferUsedSize = strlen(buffer->value);
-    
-    EmojicodeInteger len = u8_strlen_l(buffer->value, bufferUsedSize);
-    
-    Object *so = newObject(CL_STRING);
-    stackSetVariable(0, somethingObject(so), thread);
-    String *string = so->value;
-    string->length = len;
-    
-    Object *chars = newArray(len * sizeof(EmojicodeChar));
-    string = stackGetVariable(0, thread).object->value;
-    string->characters = chars;
+    if (!f) {
+        free(buffer);
+        return NOTHINGNESS;
+    }
     
-    u8_toucs(characters(string), len, buffer->value, bufferUsedSize);
+    Object *so = stringFromUTF8(buffer, strlen(buffer), thread);
+    free(buffer);
     
-    return stackGetVariable(0, thread);
+    return somethingObject(so);
 }
 
 //MARK: Threads
@@ -148,7 +156,8 @@ static Something threadJoin(Thread *thread) {
 }
 
 static Something threadSleep(Thread *thread){
-    sleep((unsigned int)stackGetVariable(0, thread).raw);
+    unsigned int seconds = (unsigned int)stackGetVariable(0, thread).raw;
+    allowingGC(sleep(seconds));
     return NOTHINGNESS;
 }
 
@@ -202,7 +211,7 @@ void newErrorBridge(Thread *thread){
 
 static Something errorGetMessage(Thread *thread){
     EmojicodeError *error = stackGetThis(thread)->value;
-    return somethingObject(stringFromChar(error->message));
+    return somethingObject(stringFromUTF8(error->message, strlen(error->message), thread));
 }
 
 static Something errorGetCode(Thread *thread){
@@ -263,6 +272,13 @@ static void dataMark(Object *o) {
     }
 }
 
+static void dataDeinit(void *value) {
+    Data *d = value;
+    if (d->release) {
+        d->release(d);
+    }
+}
+
 static Something dataGetByte(Thread *thread) {
     Data *d = stackGetThis(thread)->value;
     
@@ -277,6 +293,10 @@ static Something dataGetByte(Thread *thread) {
     return somethingInteger(d->bytes[index]);
 }
 
+static Something dataJSON(Thread *thread) {
+    return serializeJSONData(stackGetVariable(0, thread), unwrapBool(stackGetVariable(1, thread)), thread);
+}
+
 //MARK: Math
 
 static Something mathSin(Thread *thread) {
@@ -347,7 +367,7 @@ static void closureMark(Object *o){
     
     Something *t = c->capturedVariables->value;
     for (uint8_t i = 0; i < c->capturedVariablesCount; i++) {
-        Something *s = t + c->argumentCount + i;
+        Something *s = t + i;
         if (isRealObject(*s)) {
             mark(&s->object);
         }
@@ -366,6 +386,10 @@ MethodHandler handlerPointerForMethod(EmojicodeChar cl, EmojicodeChar symbol) {
     switch (cl) {
         case 0x1F521: //String
             return stringMethodForName(symbol);
+        case 0x1F58D: //🖍
+            return stringBuilderMethodForName(symbol);
+        case 0x1F5DE: //🗞
+            return jsonReaderMethodForName(symbol);
         case 0x1F368: //List
             return listMethodForName(symbol);
         case 0x1F6A8: //Error
@@ -386,6 +410,8 @@ MethodHandler handlerPointerForMethod(EmojicodeChar cl, EmojicodeChar symbol) {
             }
         case 0x1F36F:
             return dictionaryMethodForName(symbol);
+        case 0x1F511: //🔑
+            return dictionaryEnumeratorMethodForName(symbol);
         case 0x23E9:
             // case 0x1F43D: //pig nose
             return rangeGet;
@@ -412,6 +438,10 @@ InitializerHandler handlerPointerForInitializer(EmojicodeChar cl, EmojicodeChar
             return listInitializerForName(symbol);
         case 0x1F521: //String
             return stringInitializerForName(symbol);
+        case 0x1F58D: //🖍
+            return stringBuilderInitializerForName(symbol);
+        case 0x1F5DE: //🗞
+            return jsonReaderInitializerForName(symbol);
         case 0x1F6A8: //Error’s only initializer 0x1F62E
             return newErrorBridge;
         case 0x1F36F: //Only dictionary contstructor 0x1F438
@@ -433,6 +463,12 @@ InitializerHandler handlerPointerForInitializer(EmojicodeChar cl, EmojicodeChar
 
 ClassMethodHandler handlerPointerForClassMethod(EmojicodeChar cl, EmojicodeChar symbol){
     switch (cl) {
+        case 0x1F4C7: //📇
+            switch (symbol) {
+                case 0x1F4F0: //📰
+                    return dataJSON;
+            }
+            break;
         case 0x1F4BB: //💻
             switch (symbol) {
                 case 0x1F6AA:
@@ -447,6 +483,10 @@ ClassMethodHandler handlerPointerForClassMethod(EmojicodeChar cl, EmojicodeChar
                     return systemArgs;
                 case 0x1f574: //🕴
                     return systemSystem;
+                case 0x1f6bd: //🚽
+                    return systemFlush;
+                case 0x1f5a8: //🖨
+                    return systemPrintLines;
             }
             break;
         case 0x1F684: //🚄
@@ -479,6 +519,8 @@ ClassMethodHandler handlerPointerForClassMethod(EmojicodeChar cl, EmojicodeChar
                     return mathLog2;
                 case 0x1f3c4: //🏄
                     return mathLn;
+                default:
+                    return listReductionForName(symbol);
             }
         case 0x1f488: //💈
             //case 0x23f3: //⏳
@@ -491,10 +533,16 @@ uint_fast32_t sizeForClass(Class *cl, EmojicodeChar name) {
     switch (name) {
         case 0x1F521:
             return sizeof(String);
+        case 0x1F58D: //🖍
+            return sizeof(StringBuilder);
+        case 0x1F5DE: //🗞
+            return sizeof(JSONReader);
         case 0x1F368:
             return sizeof(List);
         case 0x1F36F:
             return sizeof(EmojicodeDictionary);
+        case 0x1F511: //🔑
+            return sizeof(EmojicodeDictionaryEnumerator);
         case 0x1F4C7:
             return sizeof(Data);
         case 0x1F347:
@@ -517,8 +565,14 @@ Marker markerPointerForClass(EmojicodeChar cl){
             return listMark;
         case 0x1F36F: //Dictionary
             return dictionaryMark;
+        case 0x1F511: //🔑
+            return dictionaryEnumeratorMark;
         case 0x1F521:
             return stringMark;
+        case 0x1F58D: //🖍
+            return stringBuilderMark;
+        case 0x1F5DE: //🗞
+            return jsonReaderMark;
         case 0x1F347:
             return closureMark;
         case 0x1F336:
@@ -530,5 +584,9 @@ Marker markerPointerForClass(EmojicodeChar cl){
 }
 
 Deinitializer deinitializerPointerForClass(EmojicodeChar cl){
+    switch (cl) {
+        case 0x1F4C7:
+            return dataDeinit;
+    }
     return NULL;
 }
@@ -25,7 +25,20 @@ typedef uint32_t EmojicodeCoin;
 
 /* Using either of them in a package makes absolutely no sense */
 #define packageDirectory "/usr/local/EmojicodePackages/"
-#define ByteCodeSpecificationVersion 3
+#define ByteCodeSpecificationVersion 5
+
+/**
+ * The kinds of keys of a 🍯. The compiler tells the engine the kind of every dictionary it creates, so that casts to
+ * 🍯 can check the key type, which is erased otherwise.
+ */
+typedef enum {
+    /** The default, also for dictionaries the engine or packages create. */
+    DictionaryKeyString = 0,
+    DictionaryKeyInteger = 1,
+    DictionaryKeySymbol = 2,
+    /** Objects other than strings, or a generic key type. Such dictionaries cannot be cast to a 🍯 type. */
+    DictionaryKeyOther = 3
+} DictionaryKeyKind;
 
 /**
  * @defined(isWhitespace)
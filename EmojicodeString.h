@@ -12,33 +12,189 @@
 #include "EmojicodeAPI.h"
 #include "EmojicodeList.h"
 
+typedef struct {
+    /** The string built so far. Its characters array might be larger than needed. */
+    String string;
+    /** The number of code points the characters array can hold. */
+    EmojicodeInteger capacity;
+} StringBuilder;
+
+/** The maximum nesting depth of JSON arrays and objects. Documents nested deeper are rejected. */
+#ifndef jsonMaxDepth
+#define jsonMaxDepth 256
+#endif
+
+/** A 🗞, which reads JSON documents from 📇 objects token by token. */
+typedef struct {
+    /** The 📇 being read or NULL if the source has not been asked yet. */
+    Object *data;
+    /** The callable returning the next 📇 once @c data is exhausted or NULL if there is no more input. */
+    Object *source;
+    /** The index of the next byte of @c data to read. */
+    EmojicodeInteger position;
+    /** An array holding the UTF-8 of the last key or string or the last number in its first @c textLength bytes. */
+    Object *text;
+    size_t textLength;
+    /** The value of the last integer, double or boolean token. */
+    Something value;
+    /** The last token returned as value of 🚦. */
+    EmojicodeInteger token;
+    /** What the reader expects next. */
+    uint8_t state;
+    /** The number of arrays and objects the reader is in. */
+    size_t depth;
+    /** Whether the array or object at each depth is an object. */
+    bool objects[jsonMaxDepth];
+} JSONReader;
+
 extern Object **stringPool;
 #define emptyString (stringPool[0])
-#define characters(string) ((EmojicodeChar*)(string)->characters->value)
+
+/** The number of bytes a single code point of @c string occupies in its characters array. */
+static inline size_t stringCharacterSize(String *string){
+    return string->compact ? 1 : sizeof(EmojicodeChar);
+}
+
+/** Returns a pointer to the first code point of @c string. Use @c stringCharacterSize to interpret it. */
+static inline void* stringCharacters(String *string){
+    return (Byte *)string->characters->value + string->offset * stringCharacterSize(string);
+}
+
+/** Returns the code point at @c index. No bounds checking is performed. */
+static inline EmojicodeChar stringCharacterAt(String *string, EmojicodeInteger index){
+    if (string->compact) {
+        return ((unsigned char *)string->characters->value)[string->offset + index];
+    }
+    return ((EmojicodeChar *)string->characters->value)[string->offset + index];
+}
+
+/** 
+ * Sets the code point at @c index. No bounds checking is performed.
+ * @warning If the string is compact @c c must be smaller than 256.
+ */
+static inline void stringSetCharacterAt(String *string, EmojicodeInteger index, EmojicodeChar c){
+    if (string->compact) {
+        ((unsigned char *)string->characters->value)[string->offset + index] = (unsigned char)c;
+    }
+    else {
+        ((EmojicodeChar *)string->characters->value)[string->offset + index] = c;
+    }
+}
+
+/**
+ * Allocates a characters array for @c length code points in the compact or in the wide representation.
+ * @warning GC-invoking
+ */
+Object* newStringCharacters(EmojicodeInteger length, bool compact);
+
+/**
+ * Copies @c length code points starting at @c from of @c source to @c destination starting at @c at.
+ * @warning @c destination must not be compact unless @c source is compact.
+ */
+void stringCopyCharacters(String *destination, EmojicodeInteger at, String *source, EmojicodeInteger from, EmojicodeInteger length);
+
+/**
+ * Returns the number of code points encoded in the UTF-8 in @c bytes, stores whether they all fit in a compact string
+ * in @c compact and whether the bytes are valid UTF-8 in @c valid. Bytes that are not part of a valid sequence
+ * count as one U+FFFD each.
+ */
+EmojicodeInteger utf8Length(const char *bytes, size_t size, bool *compact, bool *valid);
+
+/**
+ * Decodes @c size bytes of UTF-8 into the characters of @c string, which must already have been allocated with the
+ * length and representation @c utf8Length determined.
+ */
+void stringDecodeUTF8(String *string, const char *bytes, size_t size);
+
+/** Returns the number of bytes needed to represent @c string in UTF-8 without a terminating null byte. */
+size_t stringUTF8Size(String *string);
+
+/**
+ * Encodes @c string as UTF-8 into @c buffer, which must be able to hold @c stringUTF8Size bytes.
+ * @returns The number of bytes written.
+ */
+size_t stringEncodeUTF8(String *string, char *buffer);
+
+/**
+ * Encodes @c string as null terminated UTF-8 into @c buffer if the encoding and the terminator fit into @c size bytes.
+ * @returns The size of the encoding without the terminator. If it is not smaller than @c size nothing was written.
+ */
+size_t stringToUTF8Buffer(String *string, char *buffer, size_t size);
 
 /** Comparse if the value of a is equal to b. */
 bool stringEqual(String *a, String *b);
 
+/**
+ * Returns a negative integer, zero or a positive integer if @c a is respectively shorter than, equal to or longer
+ * than @c b. Strings of the same length are compared code point by code point.
+ */
+EmojicodeInteger stringCompare(String *a, String *b);
+
 /**
  * Converts the string to a UTF8 char array and returns it.
  * @warning You must take care of releasing the allocated memory by calling @c free.
  */
 char* stringToChar(String *str);
 
+/**
+ * Converts the string to a UTF8 char array in @c buffer if it fits into @c size bytes or in memory allocated with
+ * @c malloc otherwise.
+ * @warning Release the result by calling @c stringFreeCharInBuffer.
+ */
+char* stringToCharInBuffer(String *str, char *buffer, size_t size);
+
+static inline void stringFreeCharInBuffer(char *cstring, char *buffer){
+    if (cstring != buffer) {
+        free(cstring);
+    }
+}
+
 /** Creates a string from a UTF8 C string. The string must be null terminated! */
 Object* stringFromChar(const char *cstring);
 
+/**
+ * Creates a string from @c size bytes of UTF-8, which must not be in the object heap.
+ * @warning GC-invoking
+ */
+Object* stringFromUTF8(const char *bytes, size_t size, Thread *thread);
+
 /** 
  * Tries to parse the string in the this-slot on the stack as JSON.
  * @returns The top-level object or Nothingness if there was an error parsing the string.
  */
 Something parseJSON(Thread *thread);
 
+/**
+ * Serializes @c value, which may be a 🍯 with 🔡 keys, a 🍨, a 🔡, a 🚂, a finite 🚀, a 👌 or nothingness, as JSON
+ * into a buffer outside of the object heap, which can thus be written while the GC runs. Dictionaries are written in
+ * insertion order and indented by two spaces per level if @c pretty is true.
+ * @returns The UTF-8, which must be freed, and its length in @c size, or @c NULL if the value cannot be represented
+ * as JSON.
+ */
+char* serializeJSON(Something value, bool pretty, size_t *size);
+
+/**
+ * Serializes @c value like @c serializeJSON into a 📇 object.
+ * @returns The 📇 object or nothingness if the value cannot be represented as JSON.
+ * @warning GC-invoking
+ */
+Something serializeJSONData(Something value, bool pretty, Thread *thread);
+
 void stringMark(Object *self);
 
 void initStringFromSymbolList(Object *string, List *list);
 
+void stringBuilderMark(Object *self);
+
+void jsonReaderMark(Object *self);
+
 MethodHandler stringMethodForName(EmojicodeChar name);
 InitializerHandler stringInitializerForName(EmojicodeChar name);
 
+MethodHandler stringBuilderMethodForName(EmojicodeChar name);
+InitializerHandler stringBuilderInitializerForName(EmojicodeChar name);
+
+MethodHandler jsonReaderMethodForName(EmojicodeChar name);
+InitializerHandler jsonReaderInitializerForName(EmojicodeChar name);
+
 #endif /* EmojicodeString_h */
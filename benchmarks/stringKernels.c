@@ -0,0 +1,211 @@
+//
+//  stringKernels.c
+//  Emojicode
+//
+//  Checks the string kernels of every instruction set the CPU supports against the scalar kernels and measures
+//  their throughput. Run with `make benchmarks`.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "StringKernels.h"
+
+#define TEXT_LENGTH (1 << 20)
+#define ROUNDS 200
+
+static unsigned char compactText[TEXT_LENGTH];
+static EmojicodeChar wideText[TEXT_LENGTH];
+static unsigned char compactSpaces[TEXT_LENGTH];
+static EmojicodeChar wideSpaces[TEXT_LENGTH];
+static unsigned char compactASCII[TEXT_LENGTH];
+static EmojicodeChar wideASCII[TEXT_LENGTH];
+static unsigned char compactBuffer[TEXT_LENGTH];
+static EmojicodeChar wideBuffer[TEXT_LENGTH];
+static unsigned char compactJSON[TEXT_LENGTH];
+static EmojicodeChar wideJSON[TEXT_LENGTH];
+static EmojicodeChar widePlain[TEXT_LENGTH];
+static uint32_t jsonIndices[TEXT_LENGTH];
+static unsigned char compactNeedle[] = "needle in a haystack";
+static EmojicodeChar wideNeedle[] = {0x1F60E, 'n', 'e', 'e', 'd', 'l', 'e', 0x1F60E};
+
+static double now(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/**
+ * Fills the texts with letters and spaces and puts the needles at the very end. The spaces are only whitespace and
+ * the ASCII texts only ASCII.
+ */
+static void prepareTexts(){
+    for (size_t i = 0; i < TEXT_LENGTH; i++) {
+        compactText[i] = (i % 7 == 0) ? ' ' : 'a' + (i % 26);
+        wideText[i] = (i % 7 == 0) ? 0x3000 : 0x1F600 + (i % 26);
+    }
+    size_t needleLength = sizeof(compactNeedle) - 1;
+    memcpy(compactText + TEXT_LENGTH - needleLength - 64, compactNeedle, needleLength);
+    memcpy(wideText + TEXT_LENGTH - 8 - 64, wideNeedle, sizeof(wideNeedle));
+    for (size_t i = 0; i < TEXT_LENGTH; i++) {
+        compactSpaces[i] = (i % 2) ? ' ' : '\n';
+        wideSpaces[i] = (i % 2) ? 0x2003 : 0xA0;
+        compactASCII[i] = wideASCII[i] = 0x20 + i % 0x5F;
+    }
+    const char json[] = "{\"name\": \"Emojicode\", \"values\": [1, 22, 333],\n \"nested\": {\"ok\": true}},";
+    for (size_t i = 0; i < TEXT_LENGTH; i++) {
+        compactJSON[i] = wideJSON[i] = json[i % (sizeof(json) - 1)];
+        widePlain[i] = compactText[i];
+    }
+}
+
+static int failures = 0;
+
+static void expect(const char *kernels, const char *what, EmojicodeInteger got, EmojicodeInteger expected){
+    if (got != expected) {
+        printf("🚨 %s %s returned %lld instead of %lld\n", kernels, what, (long long)got, (long long)expected);
+        failures++;
+    }
+}
+
+/** Compares @c k against the scalar kernels on short random texts of all lengths up to 200. */
+static void check(const StringKernels *k){
+    const StringKernels *s = &scalarStringKernels;
+    unsigned char compact[200];
+    EmojicodeChar wide[200];
+    unsigned char compactWhitespace[] = {' ', '\t', '\n', 0x85, 0xA0, 'a', 0x84, 0xFF};
+    EmojicodeChar wideWhitespace[] = {' ', 0x2000, 0x200A, 0x3000, 0xFE0F, 'a', 0x200B, 0x1F600, 0x8};
+
+    srand(42);
+    for (int round = 0; round < 2000; round++) {
+        EmojicodeInteger length = rand() % 200;
+        for (EmojicodeInteger i = 0; i < length; i++) {
+            compact[i] = (rand() % 4) ? 'a' + rand() % 3 : compactWhitespace[rand() % sizeof(compactWhitespace)];
+            wide[i] = (rand() % 4) ? 0x1F600 + rand() % 3 : wideWhitespace[rand() % 9];
+        }
+        EmojicodeInteger from = length ? rand() % length : 0;
+        EmojicodeInteger needleLength = 1 + rand() % 4;
+        if (from + needleLength > length) {
+            needleLength = length - from;
+        }
+
+        expect(k->name, "findCharacterCompact", k->findCharacterCompact(compact, length, 'b'),
+               s->findCharacterCompact(compact, length, 'b'));
+        expect(k->name, "findCharacterWide", k->findCharacterWide(wide, length, 0x1F601),
+               s->findCharacterWide(wide, length, 0x1F601));
+        if (needleLength > 0) {
+            expect(k->name, "findCompact", k->findCompact(compact, length, compact + from, needleLength),
+                   s->findCompact(compact, length, compact + from, needleLength));
+            expect(k->name, "findWide", k->findWide(wide, length, wide + from, needleLength),
+                   s->findWide(wide, length, wide + from, needleLength));
+        }
+        expect(k->name, "leadingWhitespaceCompact", k->leadingWhitespaceCompact(compact, length),
+               s->leadingWhitespaceCompact(compact, length));
+        expect(k->name, "trailingWhitespaceCompact", k->trailingWhitespaceCompact(compact, length),
+               s->trailingWhitespaceCompact(compact, length));
+        expect(k->name, "leadingWhitespaceWide", k->leadingWhitespaceWide(wide, length),
+               s->leadingWhitespaceWide(wide, length));
+        expect(k->name, "trailingWhitespaceWide", k->trailingWhitespaceWide(wide, length),
+               s->trailingWhitespaceWide(wide, length));
+
+        for (EmojicodeInteger i = 0; i < length; i++) {
+            compact[i] = (rand() % 8) ? compact[i] & 0x7F : compact[i];
+            wide[i] = (rand() % 8) ? wide[i] & 0x7F : wide[i];
+        }
+        expect(k->name, "asciiLength", k->asciiLength(compact, length), s->asciiLength(compact, length));
+        EmojicodeChar widened[200];
+        k->widen(widened, compact, length);
+        for (EmojicodeInteger i = 0; i < length; i++) {
+            expect(k->name, "widen", widened[i], compact[i]);
+        }
+        unsigned char narrowed[200];
+        size_t ascii = k->narrowASCII(narrowed, wide, length);
+        expect(k->name, "narrowASCII", ascii, s->narrowASCII(compact, wide, length));
+        for (size_t i = 0; i < ascii; i++) {
+            expect(k->name, "narrowASCII", narrowed[i], wide[i]);
+        }
+
+        unsigned char jsonCharacters[] = {'{', '}', '[', ']', ':', ',', '"', '\\', '\n', 0x1F, 0x0, ' ', '|', ';', 0xDB};
+        for (EmojicodeInteger i = 0; i < length; i++) {
+            compact[i] = (rand() % 3) ? 'a' : jsonCharacters[rand() % sizeof(jsonCharacters)];
+            wide[i] = (rand() % 16) ? compact[i] : 0x1F57B;
+        }
+        uint32_t indices[200], expectedIndices[200];
+        size_t count = k->jsonStructuralsCompact(compact, length, indices);
+        expect(k->name, "jsonStructuralsCompact", count, s->jsonStructuralsCompact(compact, length, expectedIndices));
+        for (size_t i = 0; i < count; i++) {
+            expect(k->name, "jsonStructuralsCompact", indices[i], expectedIndices[i]);
+        }
+        count = k->jsonStructuralsWide(wide, length, indices);
+        expect(k->name, "jsonStructuralsWide", count, s->jsonStructuralsWide(wide, length, expectedIndices));
+        for (size_t i = 0; i < count; i++) {
+            expect(k->name, "jsonStructuralsWide", indices[i], expectedIndices[i]);
+        }
+        for (EmojicodeInteger i = 0; i < length; i++) {
+            compact[i] = (rand() % 32) ? 'a' : jsonCharacters[rand() % sizeof(jsonCharacters)];
+            wide[i] = (rand() % 64) ? compact[i] : 0x1F57B;
+        }
+        expect(k->name, "jsonPlainLengthCompact", k->jsonPlainLengthCompact(compact, length),
+               s->jsonPlainLengthCompact(compact, length));
+        expect(k->name, "jsonPlainLengthWide", k->jsonPlainLengthWide(wide, length),
+               s->jsonPlainLengthWide(wide, length));
+    }
+}
+
+/** Prints the throughput of @c k in code points per nanosecond. */
+static void measure(const StringKernels *k){
+    volatile EmojicodeInteger sink = 0;
+    double gigas = (double)TEXT_LENGTH * ROUNDS / 1e9;
+    double start;
+
+    printf("%s\n", k->name);
+
+#define MEASURE(what, expression) \
+    start = now(); \
+    for (int i = 0; i < ROUNDS; i++) sink += expression; \
+    printf("  %-26s %6.2f code points/ns\n", what, gigas / (now() - start));
+
+    MEASURE("findCharacterCompact", k->findCharacterCompact(compactText, TEXT_LENGTH, 'N'));
+    MEASURE("findCharacterWide", k->findCharacterWide(wideText, TEXT_LENGTH, 0x1F6FF));
+    MEASURE("findCompact", k->findCompact(compactText, TEXT_LENGTH, compactNeedle, sizeof(compactNeedle) - 1));
+    MEASURE("findWide", k->findWide(wideText, TEXT_LENGTH, wideNeedle, 8));
+    MEASURE("leadingWhitespaceCompact", k->leadingWhitespaceCompact(compactSpaces, TEXT_LENGTH));
+    MEASURE("trailingWhitespaceCompact", k->trailingWhitespaceCompact(compactSpaces, TEXT_LENGTH));
+    MEASURE("leadingWhitespaceWide", k->leadingWhitespaceWide(wideSpaces, TEXT_LENGTH));
+    MEASURE("trailingWhitespaceWide", k->trailingWhitespaceWide(wideSpaces, TEXT_LENGTH));
+    MEASURE("asciiLength", k->asciiLength(compactASCII, TEXT_LENGTH));
+    MEASURE("widen", (k->widen(wideBuffer, compactASCII, TEXT_LENGTH), 0));
+    MEASURE("narrowASCII", k->narrowASCII(compactBuffer, wideASCII, TEXT_LENGTH));
+    MEASURE("jsonStructuralsCompact", k->jsonStructuralsCompact(compactJSON, TEXT_LENGTH, jsonIndices));
+    MEASURE("jsonStructuralsWide", k->jsonStructuralsWide(wideJSON, TEXT_LENGTH, jsonIndices));
+    MEASURE("jsonPlainLengthCompact", k->jsonPlainLengthCompact(compactText, TEXT_LENGTH));
+    MEASURE("jsonPlainLengthWide", k->jsonPlainLengthWide(widePlain, TEXT_LENGTH));
+#undef MEASURE
+
+    (void)sink;
+}
+
+int main(){
+    const StringKernels *all[3];
+    int count = 0;
+    all[count++] = &scalarStringKernels;
+#ifdef STRING_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) all[count++] = &sse2StringKernels;
+    if (__builtin_cpu_supports("avx2")) all[count++] = &avx2StringKernels;
+#endif
+    selectStringKernels();
+    printf("Selected kernels: %s\n", stringKernels.name);
+
+    for (int i = 1; i < count; i++) {
+        check(all[i]);
+    }
+
+    prepareTexts();
+    for (int i = 0; i < count; i++) {
+        measure(all[i]);
+    }
+
+    return failures > 0;
+}